@@ -1,4 +1,4 @@
-// c/mmerge.c rev. 22 July 2013 by Stuart Ambler.
+// c/mmerge.c rev. 17 October 2026 by Stuart Ambler.
 // Merge of k sorted arrays of ints.  See c/mmerge.h for further comments.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
@@ -20,15 +20,15 @@
 // has been set to a value in an element of arrays; otherwise *pminval is set
 // to INT_MAX.
 
-static bool minptrix(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
-                     int **p_p_int, int *pminval) {
+static bool minptrix(int nr_arrays, size_t lens[nr_arrays],
+                     int *arrays[nr_arrays], int **p_p_int, int *pminval) {
   bool  did_examine = false;  // did examine an element of an element of arrays
   int **minit;
   int   minval;
   int **p_int_array = arrays;
 
   for (int i = 0; i < nr_arrays; ++i, ++p_int_array, ++p_p_int) {
-    if (*p_p_int - *p_int_array >= lens[i]) {
+    if ((size_t) (*p_p_int - *p_int_array) >= lens[i]) {
       continue;
     }
 
@@ -53,8 +53,8 @@ static bool minptrix(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
 
 // Multimerge, linear in k.
 
-bool multimerge(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
-                int total_nr, int output[total_nr]) {
+bool multimerge(int nr_arrays, size_t lens[nr_arrays], int *arrays[nr_arrays],
+                size_t total_nr, int output[total_nr]) {
   int **p_int_array = arrays;
   int **array_int_p = (int **) malloc(nr_arrays * sizeof (int *));
   if (array_int_p == NULL)
@@ -74,8 +74,9 @@ bool multimerge(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
 
 // Priority queue multimerge, logarithmic in k.
 
-bool multimerge_pq(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
-                   int total_nr, int output[total_nr]) {
+bool multimerge_pq(int nr_arrays, size_t lens[nr_arrays],
+                   int *arrays[nr_arrays], size_t total_nr,
+                   int output[total_nr]) {
   int **p_int_array = arrays;
   int **array_int_p = (int **) malloc(nr_arrays * sizeof (int *));
   if (array_int_p == NULL)
@@ -100,7 +101,7 @@ bool multimerge_pq(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
   int minval;
   PointerPointerPair *pppp;
 
-  for (int i = 0; i < total_nr; ++i) {
+  for (size_t i = 0; i < total_nr; ++i) {
     pppp = priority_queue_top (ppq);
     if (pppp == NULL) {  // should't occur
       free (array_int_p);
@@ -110,7 +111,8 @@ bool multimerge_pq(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
     priority_queue_pop (ppq);
     minval = **(ppp.p_p_int);
     ++(*(ppp.p_p_int));
-    if (*(ppp.p_p_int) - *(ppp.p_int_array) < lens[ppp.p_int_array - arrays]) {
+    if (  (size_t) (*(ppp.p_p_int) - *(ppp.p_int_array))
+        < lens[ppp.p_int_array - arrays]) {
       priority_queue_push (ppq, ppp);
     }
     *output = minval;
@@ -121,3 +123,216 @@ bool multimerge_pq(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
   free (array_int_p);
   return true;
 }
+
+// Keyed priority queue multimerge, logarithmic in k.
+
+bool multimerge_pq_keyed(int nr_arrays, size_t lens[nr_arrays],
+                         int *arrays[nr_arrays], size_t total_nr,
+                         int output[total_nr], int arity) {
+  size_t *positions = (size_t *) malloc(nr_arrays * sizeof (size_t));
+  if (positions == NULL)
+    return false;
+
+  KeyedPriorityQueue *pkq = keyed_priority_queue_alloc (nr_arrays, arity);
+  if (pkq == NULL) {
+    free (positions);
+    return false;
+  }
+
+  KeyIndexNode node;
+
+  for (int i = 0; i < nr_arrays; ++i) {
+    positions[i] = 0;
+    if (lens[i] > 0) {
+      node.key = arrays[i][0];
+      node.src = i;
+      keyed_priority_queue_push (pkq, node);
+    }
+  }
+
+  KeyIndexNode *ptop;
+
+  for (size_t i = 0; i < total_nr; ++i) {
+    ptop = keyed_priority_queue_top (pkq);
+    if (ptop == NULL) {  // shouldn't occur
+      keyed_priority_queue_free (pkq);
+      free (positions);
+      return false;
+    }
+    *output++ = ptop->key;
+    int    src = ptop->src;
+    size_t pos = ++positions[src];
+    if (pos < lens[src]) {
+      node.key = arrays[src][pos];
+      node.src = src;
+      keyed_priority_queue_replace_top (pkq, node);
+    } else {
+      keyed_priority_queue_pop (pkq);
+    }
+  }
+
+  keyed_priority_queue_free (pkq);
+  free (positions);
+  return true;
+}
+
+// 64-bit keys.  The shared implementations read keys as unsigned and
+// compare key ^ flip, flip being 2^63 for signed keys and 0 for unsigned.
+
+static const uint64_t kSignFlip = (uint64_t) 1 << 63;
+
+// minptrix for 64-bit keys compared as key ^ flip: the same scan of the
+// same pointer pairs, so that the linear merges of int and of 64-bit keys
+// differ only in the width of the keys.
+
+static bool minptrix_64(int nr_arrays, size_t lens[nr_arrays],
+                        uint64_t *arrays[nr_arrays], uint64_t **p_p_key,
+                        uint64_t flip, uint64_t *pminkey) {
+  bool       did_examine = false;
+  uint64_t **minit;
+  uint64_t   minkey;
+  uint64_t **p_key_array = arrays;
+
+  for (int i = 0; i < nr_arrays; ++i, ++p_key_array, ++p_p_key) {
+    if ((size_t) (*p_p_key - *p_key_array) >= lens[i]) {
+      continue;
+    }
+
+    uint64_t curkey = **p_p_key ^ flip;
+
+    if ((!did_examine) || minkey > curkey) {
+      did_examine = true;
+      minkey      = curkey;
+      minit       = p_p_key;
+    }
+  }
+
+  if (did_examine) {
+    *pminkey = minkey ^ flip;
+    ++(*minit);
+  }
+
+  return did_examine;
+}
+
+// Multimerge of 64-bit keys, linear in k.
+
+static bool multimerge_64(int nr_arrays, size_t lens[nr_arrays],
+                          uint64_t *arrays[nr_arrays], size_t total_nr,
+                          uint64_t output[total_nr], uint64_t flip) {
+  uint64_t **array_key_p = (uint64_t **) malloc(nr_arrays
+                                                * sizeof (uint64_t *));
+  if (array_key_p == NULL)
+    return false;
+
+  for (int i = 0; i < nr_arrays; ++i)
+    array_key_p[i] = arrays[i];
+
+  uint64_t minkey;
+  while (minptrix_64(nr_arrays, lens, arrays, array_key_p, flip, &minkey))
+    *output++ = minkey;
+
+  free (array_key_p);
+  return true;
+}
+
+// Keyed priority queue multimerge of 64-bit keys, logarithmic in k.
+
+static bool multimerge_pq_64(int nr_arrays, size_t lens[nr_arrays],
+                             uint64_t *arrays[nr_arrays], size_t total_nr,
+                             uint64_t output[total_nr], int arity,
+                             uint64_t flip) {
+  size_t *positions = (size_t *) malloc(nr_arrays * sizeof (size_t));
+  if (positions == NULL)
+    return false;
+
+  Keyed64PriorityQueue *pkq = keyed64_priority_queue_alloc (nr_arrays, arity);
+  if (pkq == NULL) {
+    free (positions);
+    return false;
+  }
+
+  KeyIndexNode64 node;
+
+  for (int i = 0; i < nr_arrays; ++i) {
+    positions[i] = 0;
+    if (lens[i] > 0) {
+      node.key = arrays[i][0] ^ flip;
+      node.src = i;
+      keyed64_priority_queue_push (pkq, node);
+    }
+  }
+
+  KeyIndexNode64 *ptop;
+
+  for (size_t i = 0; i < total_nr; ++i) {
+    ptop = keyed64_priority_queue_top (pkq);
+    if (ptop == NULL) {  // shouldn't occur
+      keyed64_priority_queue_free (pkq);
+      free (positions);
+      return false;
+    }
+    *output++ = ptop->key ^ flip;
+    int    src = ptop->src;
+    size_t pos = ++positions[src];
+    if (pos < lens[src]) {
+      node.key = arrays[src][pos] ^ flip;
+      node.src = src;
+      keyed64_priority_queue_replace_top (pkq, node);
+    } else {
+      keyed64_priority_queue_pop (pkq);
+    }
+  }
+
+  keyed64_priority_queue_free (pkq);
+  free (positions);
+  return true;
+}
+
+// The signed arrays as pointers to their values read as unsigned, which C
+// allows; returns NULL if unable to allocate.
+
+static uint64_t **unsigned_arrays(int nr_arrays, int64_t *arrays[nr_arrays]) {
+  uint64_t **uarrays = (uint64_t **) malloc(nr_arrays * sizeof (uint64_t *));
+  if (uarrays != NULL) {
+    for (int i = 0; i < nr_arrays; ++i)
+      uarrays[i] = (uint64_t *) arrays[i];
+  }
+  return uarrays;
+}
+
+bool multimerge_int64(int nr_arrays, size_t lens[nr_arrays],
+                      int64_t *arrays[nr_arrays], size_t total_nr,
+                      int64_t output[total_nr]) {
+  uint64_t **uarrays = unsigned_arrays(nr_arrays, arrays);
+  if (uarrays == NULL)
+    return false;
+  bool ok = multimerge_64(nr_arrays, lens, uarrays, total_nr,
+                          (uint64_t *) output, kSignFlip);
+  free (uarrays);
+  return ok;
+}
+
+bool multimerge_uint64(int nr_arrays, size_t lens[nr_arrays],
+                       uint64_t *arrays[nr_arrays], size_t total_nr,
+                       uint64_t output[total_nr]) {
+  return multimerge_64(nr_arrays, lens, arrays, total_nr, output, 0);
+}
+
+bool multimerge_pq_int64(int nr_arrays, size_t lens[nr_arrays],
+                         int64_t *arrays[nr_arrays], size_t total_nr,
+                         int64_t output[total_nr], int arity) {
+  uint64_t **uarrays = unsigned_arrays(nr_arrays, arrays);
+  if (uarrays == NULL)
+    return false;
+  bool ok = multimerge_pq_64(nr_arrays, lens, uarrays, total_nr,
+                             (uint64_t *) output, arity, kSignFlip);
+  free (uarrays);
+  return ok;
+}
+
+bool multimerge_pq_uint64(int nr_arrays, size_t lens[nr_arrays],
+                          uint64_t *arrays[nr_arrays], size_t total_nr,
+                          uint64_t output[total_nr], int arity) {
+  return multimerge_pq_64(nr_arrays, lens, arrays, total_nr, output, arity, 0);
+}
@@ -1,4 +1,4 @@
-// c/mmerge.h rev. 22 July 2013 by Stuart Ambler.  Header file for c/mmerge.c.
+// c/mmerge.h rev. 17 October 2026 by Stuart Ambler.  Header file for c/mmerge.c.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
@@ -14,21 +14,56 @@
 #include <limits.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+// Lengths and total_nr are size_t in all the functions below, so that a
+// merge may hold more than 2^31 elements.
+
 // Multimerge, linear in k.  Each element of arrays must be a sorted
 // vector of int.  On return, *poutput will be a sorted vector containing
 // all the values in all the elements of arrays.  Returns false if error.
 
-bool multimerge(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
-                int total_nr, int output[total_nr]);
+bool multimerge(int nr_arrays, size_t lens[nr_arrays], int *arrays[nr_arrays],
+                size_t total_nr, int output[total_nr]);
 
 // Priority queue multimerge, logarithmic in k. Each element of arrays must be
 // a sorted vector of int.  On return, *poutput will be a sorted vector
 // containing all the values in all the elements of arrays.  Returns false if
 // error.
 
-bool multimerge_pq(int nr_arrays, int lens[nr_arrays], int *arrays[nr_arrays],
-                   int total_nr, int  output[total_nr]);
+bool multimerge_pq(int nr_arrays, size_t lens[nr_arrays],
+                   int *arrays[nr_arrays], size_t total_nr,
+                   int output[total_nr]);
+
+// Keyed priority queue multimerge, logarithmic in k, with the same contract as
+// multimerge_pq.  The heap nodes hold each array's current value beside its
+// index, and each output element costs one sift-down replacing the top
+// rather than a pop and a push.  arity, 2 or 4, selects a binary or a
+// cache-line-aligned 4-ary heap.  Returns false if error.
+
+bool multimerge_pq_keyed(int nr_arrays, size_t lens[nr_arrays],
+                         int *arrays[nr_arrays], size_t total_nr,
+                         int output[total_nr], int arity);
+
+// The linear and keyed priority queue multimerges for 64-bit keys, signed
+// and unsigned, with the same contracts.  Signed keys are compared as
+// unsigned with their sign bits flipped, which keeps their order, so both
+// share one implementation.  A 64-bit key doubles the bytes read and written
+// per element.
+
+bool multimerge_int64(int nr_arrays, size_t lens[nr_arrays],
+                      int64_t *arrays[nr_arrays], size_t total_nr,
+                      int64_t output[total_nr]);
+bool multimerge_uint64(int nr_arrays, size_t lens[nr_arrays],
+                       uint64_t *arrays[nr_arrays], size_t total_nr,
+                       uint64_t output[total_nr]);
+bool multimerge_pq_int64(int nr_arrays, size_t lens[nr_arrays],
+                         int64_t *arrays[nr_arrays], size_t total_nr,
+                         int64_t output[total_nr], int arity);
+bool multimerge_pq_uint64(int nr_arrays, size_t lens[nr_arrays],
+                          uint64_t *arrays[nr_arrays], size_t total_nr,
+                          uint64_t output[total_nr], int arity);
 
 #endif  // _HOME_STUART_PROJECTS_SAMPLES_C_MMERGE_H_
@@ -1,8 +1,10 @@
-// c/pqueue.c rev. 22 July 2013 by Stuart Ambler.
+// c/pqueue.c rev. 17 October 2026 by Stuart Ambler.
 // Priority queue implementation; see c/pqueue.h for further notes.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
+#define _POSIX_C_SOURCE 200112L  // for posix_memalign
+
 #include "./pqueue.h"
 
 // Assumes index > 1.
@@ -112,3 +114,281 @@ void priority_queue_free(IntPriorityQueue *ppq) {
     free (ppq);
   }
 }
+
+// Keyed priority queue.  The binary heap keeps the layout above, root at
+// index 1.  The 4-ary heap has its root at index 0 and the children of node i
+// at 4 * i + 1 through 4 * i + 4; with the nodes array starting
+// kFourAryOffset nodes into a cache-line-aligned allocation, each group of
+// four children, 32 bytes, starts on a 32-byte boundary, inside one line;
+// for 16-byte 64-bit key nodes, each group is one whole line.
+
+#define CACHE_LINE_SIZE (64)
+static const int kFourAryOffset = 3;
+
+// Allocates the nodes of a keyed priority queue of size nodes of node_size
+// bytes for arity, setting *pallocation to the allocation and returning the
+// address of nodes[0], or returning NULL if unable to allocate.
+
+static void *keyed_nodes_alloc(int size, int arity, size_t node_size,
+                               void **pallocation) {
+  if (arity == 2) {
+    *pallocation = malloc((size + 1) * node_size);
+    return *pallocation;
+  }
+  if (posix_memalign(pallocation, CACHE_LINE_SIZE,
+                     (size + kFourAryOffset) * node_size) != 0) {
+    *pallocation = NULL;
+    return NULL;
+  }
+  return (char *) *pallocation + kFourAryOffset * node_size;
+}
+
+KeyedPriorityQueue *keyed_priority_queue_alloc(int size, int arity) {
+  if (size < 1 || (arity != 2 && arity != 4))
+    return NULL;
+
+  KeyedPriorityQueue *pkq = (KeyedPriorityQueue *)
+                            malloc(sizeof(KeyedPriorityQueue));
+  if (pkq == NULL)
+    return NULL;
+
+  pkq->size     = size;
+  pkq->occupied = 0;
+  pkq->arity    = arity;
+  pkq->nodes    = (KeyIndexNode *) keyed_nodes_alloc(size, arity,
+                                                     sizeof(KeyIndexNode),
+                                                     &pkq->allocation);
+  if (pkq->nodes == NULL) {
+    free (pkq);
+    return NULL;
+  }
+
+  return pkq;
+}
+
+// Sift-up and sift-down.  The node moving is held aside and written once, at
+// its final place, rather than swapped at each level.
+
+static inline void sift_up_2 (KeyIndexNode *nodes, int k, KeyIndexNode node) {
+  while (k > 1 && node.key < nodes[k / 2].key) {
+    nodes[k] = nodes[k / 2];
+    k /= 2;
+  }
+  nodes[k] = node;
+}
+
+static inline void sift_up_4 (KeyIndexNode *nodes, int k, KeyIndexNode node) {
+  while (k > 0 && node.key < nodes[(k - 1) / 4].key) {
+    nodes[k] = nodes[(k - 1) / 4];
+    k = (k - 1) / 4;
+  }
+  nodes[k] = node;
+}
+
+static inline void sift_down_2 (KeyIndexNode *nodes, int occupied,
+                                KeyIndexNode node) {
+  int j;
+  int k = 1;
+  while ((j = 2 * k) <= occupied) {
+    if (j < occupied && nodes[j + 1].key < nodes[j].key)
+      ++j;
+    if (node.key <= nodes[j].key)
+      break;
+    nodes[k] = nodes[j];
+    k = j;
+  }
+  nodes[k] = node;
+}
+
+static inline void sift_down_4 (KeyIndexNode *nodes, int occupied,
+                                KeyIndexNode node) {
+  int j;
+  int k = 0;
+  while ((j = 4 * k + 1) < occupied) {
+    int last = j + 4 < occupied ? j + 4 : occupied;
+    int min  = j;
+    for (++j; j < last; ++j) {
+      if (nodes[j].key < nodes[min].key)
+        min = j;
+    }
+    if (node.key <= nodes[min].key)
+      break;
+    nodes[k] = nodes[min];
+    k = min;
+  }
+  nodes[k] = node;
+}
+
+void keyed_priority_queue_push(KeyedPriorityQueue *pkq, KeyIndexNode node) {
+  if (pkq->occupied >= pkq->size)
+    return;
+
+  if (pkq->arity == 2)
+    sift_up_2 (pkq->nodes, ++pkq->occupied, node);
+  else
+    sift_up_4 (pkq->nodes, pkq->occupied++, node);
+}
+
+KeyIndexNode *keyed_priority_queue_top(KeyedPriorityQueue *pkq) {
+  if (pkq == NULL || pkq->occupied <= 0)
+    return NULL;
+
+  return &pkq->nodes[pkq->arity == 2 ? 1 : 0];
+}
+
+void keyed_priority_queue_pop(KeyedPriorityQueue *pkq) {
+  if (pkq == NULL || pkq->occupied <= 0)
+    return;
+
+  if (pkq->arity == 2) {
+    KeyIndexNode last = pkq->nodes[pkq->occupied--];
+    sift_down_2 (pkq->nodes, pkq->occupied, last);
+  } else {
+    KeyIndexNode last = pkq->nodes[--pkq->occupied];
+    sift_down_4 (pkq->nodes, pkq->occupied, last);
+  }
+}
+
+void keyed_priority_queue_replace_top(KeyedPriorityQueue *pkq,
+                                      KeyIndexNode node) {
+  if (pkq == NULL || pkq->occupied <= 0)
+    return;
+
+  if (pkq->arity == 2)
+    sift_down_2 (pkq->nodes, pkq->occupied, node);
+  else
+    sift_down_4 (pkq->nodes, pkq->occupied, node);
+}
+
+void keyed_priority_queue_free(KeyedPriorityQueue *pkq) {
+  if (pkq != NULL) {
+    free (pkq->allocation);
+    free (pkq);
+  }
+}
+
+// Keyed priority queue of 64-bit keys, as above.
+
+Keyed64PriorityQueue *keyed64_priority_queue_alloc(int size, int arity) {
+  if (size < 1 || (arity != 2 && arity != 4))
+    return NULL;
+
+  Keyed64PriorityQueue *pkq = (Keyed64PriorityQueue *)
+                              malloc(sizeof(Keyed64PriorityQueue));
+  if (pkq == NULL)
+    return NULL;
+
+  pkq->size     = size;
+  pkq->occupied = 0;
+  pkq->arity    = arity;
+  pkq->nodes    = (KeyIndexNode64 *) keyed_nodes_alloc(size, arity,
+                                                       sizeof(KeyIndexNode64),
+                                                       &pkq->allocation);
+  if (pkq->nodes == NULL) {
+    free (pkq);
+    return NULL;
+  }
+
+  return pkq;
+}
+
+static inline void sift_up_64_2 (KeyIndexNode64 *nodes, int k,
+                                 KeyIndexNode64 node) {
+  while (k > 1 && node.key < nodes[k / 2].key) {
+    nodes[k] = nodes[k / 2];
+    k /= 2;
+  }
+  nodes[k] = node;
+}
+
+static inline void sift_up_64_4 (KeyIndexNode64 *nodes, int k,
+                                 KeyIndexNode64 node) {
+  while (k > 0 && node.key < nodes[(k - 1) / 4].key) {
+    nodes[k] = nodes[(k - 1) / 4];
+    k = (k - 1) / 4;
+  }
+  nodes[k] = node;
+}
+
+static inline void sift_down_64_2 (KeyIndexNode64 *nodes, int occupied,
+                                   KeyIndexNode64 node) {
+  int j;
+  int k = 1;
+  while ((j = 2 * k) <= occupied) {
+    if (j < occupied && nodes[j + 1].key < nodes[j].key)
+      ++j;
+    if (node.key <= nodes[j].key)
+      break;
+    nodes[k] = nodes[j];
+    k = j;
+  }
+  nodes[k] = node;
+}
+
+static inline void sift_down_64_4 (KeyIndexNode64 *nodes, int occupied,
+                                   KeyIndexNode64 node) {
+  int j;
+  int k = 0;
+  while ((j = 4 * k + 1) < occupied) {
+    int last = j + 4 < occupied ? j + 4 : occupied;
+    int min  = j;
+    for (++j; j < last; ++j) {
+      if (nodes[j].key < nodes[min].key)
+        min = j;
+    }
+    if (node.key <= nodes[min].key)
+      break;
+    nodes[k] = nodes[min];
+    k = min;
+  }
+  nodes[k] = node;
+}
+
+void keyed64_priority_queue_push(Keyed64PriorityQueue *pkq,
+                                 KeyIndexNode64 node) {
+  if (pkq->occupied >= pkq->size)
+    return;
+
+  if (pkq->arity == 2)
+    sift_up_64_2 (pkq->nodes, ++pkq->occupied, node);
+  else
+    sift_up_64_4 (pkq->nodes, pkq->occupied++, node);
+}
+
+KeyIndexNode64 *keyed64_priority_queue_top(Keyed64PriorityQueue *pkq) {
+  if (pkq == NULL || pkq->occupied <= 0)
+    return NULL;
+
+  return &pkq->nodes[pkq->arity == 2 ? 1 : 0];
+}
+
+void keyed64_priority_queue_pop(Keyed64PriorityQueue *pkq) {
+  if (pkq == NULL || pkq->occupied <= 0)
+    return;
+
+  if (pkq->arity == 2) {
+    KeyIndexNode64 last = pkq->nodes[pkq->occupied--];
+    sift_down_64_2 (pkq->nodes, pkq->occupied, last);
+  } else {
+    KeyIndexNode64 last = pkq->nodes[--pkq->occupied];
+    sift_down_64_4 (pkq->nodes, pkq->occupied, last);
+  }
+}
+
+void keyed64_priority_queue_replace_top(Keyed64PriorityQueue *pkq,
+                                        KeyIndexNode64 node) {
+  if (pkq == NULL || pkq->occupied <= 0)
+    return;
+
+  if (pkq->arity == 2)
+    sift_down_64_2 (pkq->nodes, pkq->occupied, node);
+  else
+    sift_down_64_4 (pkq->nodes, pkq->occupied, node);
+}
+
+void keyed64_priority_queue_free(Keyed64PriorityQueue *pkq) {
+  if (pkq != NULL) {
+    free (pkq->allocation);
+    free (pkq);
+  }
+}
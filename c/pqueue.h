@@ -1,4 +1,4 @@
-// c/pqueue.h rev. 22 July 2013 by Stuart Ambler.  Header for c/pqueue.c.
+// c/pqueue.h rev. 17 October 2026 by Stuart Ambler.  Header for c/pqueue.c.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
@@ -10,6 +10,7 @@
 
 #include <limits.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 struct PointerPointerPair_ {
@@ -37,4 +38,68 @@ PointerPointerPair *priority_queue_top   (IntPriorityQueue  *ppq);
 void                priority_queue_pop   (IntPriorityQueue  *ppq);
 void                priority_queue_free  (IntPriorityQueue  *ppq);
 
+// Keyed priority queue, minimum at top.  Each node holds the current key of
+// a source next to the index of the source, so that comparisons read only the
+// heap array, not the source arrays through two pointers as above.  arity is
+// 2 or 4; a 4-ary heap is half as deep, and its array is aligned to a cache
+// line and offset so that the four children of a node lie in one line.
+
+struct KeyIndexNode_ {
+  int key;
+  int src;  // index of the source array key was read from
+};
+typedef struct KeyIndexNode_ KeyIndexNode;
+
+struct KeyedPriorityQueue_ {
+  int size;
+  int occupied;
+  int arity;
+  KeyIndexNode *nodes;       // the root is nodes[1] if arity 2, else nodes[0]
+  void         *allocation;  // for free
+};
+typedef struct KeyedPriorityQueue_ KeyedPriorityQueue;
+
+// Returns NULL if unable to allocate, or if arity is neither 2 nor 4.
+KeyedPriorityQueue *keyed_priority_queue_alloc      (int size, int arity);
+// Does nothing if the push would cause size to be exceeded.
+void                keyed_priority_queue_push       (KeyedPriorityQueue *pkq,
+                                                     KeyIndexNode node);
+// Returns NULL if the priority queue is empty.
+KeyIndexNode       *keyed_priority_queue_top        (KeyedPriorityQueue *pkq);
+// Does nothing if the priority queue is empty.
+void                keyed_priority_queue_pop        (KeyedPriorityQueue *pkq);
+// Replaces the top by node with a single sift-down, in place of a pop and a
+// push.  Does nothing if the priority queue is empty.
+void                keyed_priority_queue_replace_top(KeyedPriorityQueue *pkq,
+                                                     KeyIndexNode node);
+void                keyed_priority_queue_free       (KeyedPriorityQueue *pkq);
+
+// The same for 64-bit unsigned keys; signed keys are stored with their sign
+// bit flipped, which keeps their order.  A node is 16 bytes, so the four
+// children of a node in the 4-ary heap fill one cache line.
+
+struct KeyIndexNode64_ {
+  uint64_t key;
+  int      src;  // index of the source array key was read from
+};
+typedef struct KeyIndexNode64_ KeyIndexNode64;
+
+struct Keyed64PriorityQueue_ {
+  int size;
+  int occupied;
+  int arity;
+  KeyIndexNode64 *nodes;       // the root is nodes[1] if arity 2, else nodes[0]
+  void           *allocation;  // for free
+};
+typedef struct Keyed64PriorityQueue_ Keyed64PriorityQueue;
+
+Keyed64PriorityQueue *keyed64_priority_queue_alloc(int size, int arity);
+void            keyed64_priority_queue_push       (Keyed64PriorityQueue *pkq,
+                                                   KeyIndexNode64 node);
+KeyIndexNode64 *keyed64_priority_queue_top        (Keyed64PriorityQueue *pkq);
+void            keyed64_priority_queue_pop        (Keyed64PriorityQueue *pkq);
+void            keyed64_priority_queue_replace_top(Keyed64PriorityQueue *pkq,
+                                                   KeyIndexNode64 node);
+void            keyed64_priority_queue_free       (Keyed64PriorityQueue *pkq);
+
 #endif  // _HOME_STUART_PROJECTS_SAMPLES_C_PQUEUE_H_
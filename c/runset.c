@@ -0,0 +1,162 @@
+// c/runset.c rev. 17 October 2026 by Stuart Ambler.  Run-set files.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "./runset.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char     run_set_magic[8]   = { 'M', 'M', 'R', 'U',
+                                             'N', 'S', 'E', 'T' };
+static const uint64_t run_set_alignment  = 64;
+
+// The format is little-endian, and values are written and mapped as they
+// are in memory, so only little-endian machines read and write it here.
+
+static bool is_little_endian() {
+  const uint32_t one = 1;
+  return *(const char *) &one == 1;
+}
+
+bool run_set_write(const char *path, int nr_arrays, size_t lens[nr_arrays],
+                   int *arrays[nr_arrays]) {
+  if (!is_little_endian()) {
+    (void) printf ("Run-set files are written only on little-endian "
+                   "machines\n");
+    return false;
+  }
+  RunSetHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, run_set_magic, sizeof(header.magic));
+  header.version        = RUN_SET_VERSION;
+  header.value_size     = sizeof(int);
+  header.nr_runs        = nr_arrays;
+  header.offsets_offset = sizeof(header);
+  header.payload_offset =   (  header.offsets_offset
+                             + (header.nr_runs + 1) * sizeof(uint64_t)
+                             + run_set_alignment - 1)
+                          / run_set_alignment * run_set_alignment;
+  for (int i = 0; i < nr_arrays; ++i)
+    header.nr_values += lens[i];
+
+  FILE *f = fopen(path, "wb");
+  if (f == NULL) {
+    (void) printf ("Unable to create run-set file %s: %s\n", path,
+                   strerror(errno));
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  uint64_t offset = 0;
+  for (int i = 0; ok && i <= nr_arrays; ++i) {
+    ok = fwrite(&offset, sizeof(offset), 1, f) == 1;
+    if (i < nr_arrays)
+      offset += lens[i];
+  }
+  uint64_t nr_padding =   header.payload_offset - header.offsets_offset
+                        - (header.nr_runs + 1) * sizeof(uint64_t);
+  for (uint64_t i = 0; ok && i < nr_padding; ++i)
+    ok = fputc(0, f) != EOF;
+  for (int i = 0; ok && i < nr_arrays; ++i)
+    ok = fwrite(arrays[i], sizeof(int), lens[i], f) == lens[i];
+  if (fclose(f) != 0)
+    ok = false;
+  if (!ok)
+    (void) printf ("Unable to write run-set file %s: %s\n", path,
+                   strerror(errno));
+  return ok;
+}
+
+bool run_set_open(const char *path, RunSet *prs) {
+  memset(prs, 0, sizeof(*prs));
+  if (!is_little_endian()) {
+    (void) printf ("Run-set files are read only on little-endian "
+                   "machines\n");
+    return false;
+  }
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    (void) printf ("Unable to open run-set file %s: %s\n", path,
+                   strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  if (size < sizeof(RunSetHeader)) {
+    (void) printf ("Run-set file %s is too short for its header\n", path);
+    close(fd);
+    return false;
+  }
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int mmap_errno = errno;
+  close(fd);
+  if (map == MAP_FAILED) {
+    (void) printf ("Unable to map run-set file %s: %s\n", path,
+                   strerror(mmap_errno));
+    return false;
+  }
+
+  // Check the header and offset table before trusting either; the values
+  // themselves are not read here.
+
+  RunSetHeader header;
+  memcpy(&header, map, sizeof(header));
+  const char *bytes   = map;
+  const char *problem = NULL;
+  if (memcmp(header.magic, run_set_magic, sizeof(header.magic)) != 0) {
+    problem = "has no run-set magic number";
+  } else if (header.version != RUN_SET_VERSION) {
+    problem = "has an unknown version";
+  } else if (header.value_size != 4 && header.value_size != 8) {
+    problem = "has a value size neither 4 nor 8";
+  } else if (   header.offsets_offset < sizeof(header)
+             || header.offsets_offset % sizeof(uint64_t) != 0
+             || header.offsets_offset > size - sizeof(uint64_t)
+             || header.nr_runs > (size - header.offsets_offset)
+                                 / sizeof(uint64_t) - 1
+             ||   header.offsets_offset
+                + (header.nr_runs + 1) * sizeof(uint64_t)
+                > header.payload_offset
+             || header.payload_offset % run_set_alignment != 0
+             || header.payload_offset > size
+             || header.nr_values > (size - header.payload_offset)
+                                   / header.value_size) {
+    problem = "has a header inconsistent with its size";
+  } else {
+    const uint64_t *offsets = (const uint64_t *) (bytes
+                                                  + header.offsets_offset);
+    bool ok = (   offsets[0] == 0
+               && offsets[header.nr_runs] == header.nr_values);
+    for (uint64_t i = 0; ok && i < header.nr_runs; ++i)
+      ok = offsets[i] <= offsets[i + 1];
+    if (!ok)
+      problem = "has run offsets out of order or not matching nr_values";
+  }
+  if (problem != NULL) {
+    munmap(map, size);
+    (void) printf ("Run-set file %s %s\n", path, problem);
+    return false;
+  }
+
+  prs->header   = header;
+  prs->offsets  = (const uint64_t *) (bytes + header.offsets_offset);
+  prs->payload  = bytes + header.payload_offset;
+  prs->map      = map;
+  prs->map_size = size;
+  return true;
+}
+
+void run_set_close(RunSet *prs) {
+  if (prs->map != NULL)
+    munmap(prs->map, prs->map_size);
+  memset(prs, 0, sizeof(*prs));
+}
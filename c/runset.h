@@ -0,0 +1,57 @@
+// c/runset.h rev. 17 October 2026 by Stuart Ambler.  Header for c/runset.c.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Run-set files: k sorted runs of ints in one binary file, in the format
+// specified in common/README.md and shared by all the language versions: a
+// 64-byte header, a table of k + 1 run offsets, and the runs' values one
+// after another, 32- or 64-bit little-endian.  run_set_open maps a file into
+// memory read-only, so the runs are read where they lie, with nothing
+// copied.  The functions print a message and return false on error.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_C_RUNSET_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_C_RUNSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RUN_SET_VERSION (1)
+
+// The fixed part of a run-set file, at its start.  offsets_offset and
+// payload_offset are byte offsets from the start of the file; the run
+// offsets are element indexes into the payload.
+
+struct RunSetHeader_ {
+  char     magic[8];        // "MMRUNSET", not null-terminated
+  uint32_t version;         // RUN_SET_VERSION
+  uint32_t value_size;      // 4 or 8
+  uint64_t nr_runs;
+  uint64_t nr_values;
+  uint64_t offsets_offset;  // of nr_runs + 1 uint64_t run offsets
+  uint64_t payload_offset;  // of the values, a multiple of 64
+  uint64_t reserved[2];     // 0
+};
+typedef struct RunSetHeader_ RunSetHeader;
+
+// A run-set file mapped into memory.  Run i is the values from
+// offsets[i] up to offsets[i + 1] of payload.
+
+struct RunSet_ {
+  RunSetHeader    header;
+  const uint64_t *offsets;
+  const void     *payload;
+  void           *map;
+  size_t          map_size;
+};
+typedef struct RunSet_ RunSet;
+
+// Writes the nr_arrays arrays, of lengths lens, to the file named path as a
+// run-set file of 32-bit values.
+bool run_set_write(const char *path, int nr_arrays, size_t lens[nr_arrays],
+                   int *arrays[nr_arrays]);
+// Maps the file named path into *prs, checking its header and offset table.
+bool run_set_open (const char *path, RunSet *prs);
+void run_set_close(RunSet *prs);
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_C_RUNSET_H_
@@ -1,4 +1,4 @@
-// c/testmmerge.c rev. 28 December 2013 by Stuart Ambler.  Tests c/mmerge.c
+// c/testmmerge.c rev. 17 October 2026 by Stuart Ambler.  Tests c/mmerge.c
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
@@ -7,6 +7,7 @@
 // uses a priority queue, logarithmic in k.  Either way, the dependence on n
 // is linear.  Minimal error handling.
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -16,6 +17,7 @@
 #include <argtable2.h>
 
 #include "./mmerge.h"
+#include "./runset.h"
 
 // Prints usage of program.
 
@@ -25,7 +27,8 @@ void usage() {
 "Usage:\n"
 "  ./testmmerge [-l]\n"
 "  ./testmmerge <nr_inputs> [-l]\n"
-"  ./testmmerge <nr_inputs> <ave_input_len> [-l]\n"
+"  ./testmmerge <nr_inputs> <ave_input_len> [-l] [-b] [-o <file>]\n"
+"  ./testmmerge -i <file> [-l]\n"
 "  ./testmmerge -h | --help\n"
 "\n"
 "Arguments:\n"
@@ -39,15 +42,25 @@ void usage() {
 "Options:\n"
 "  -h --help        Show this help message and exit.\n"
 "  -l               Test slower linear method as well as priority queue method."
-"\n";
+"\n"
+"  -i <file>        Instead of generating data, map the run-set file (see\n"
+"                   common/README.md) into memory and merge its runs in\n"
+"                   place; nr_inputs and ave_input_len are ignored.\n"
+"  -o <file>        Write the generated data to file as a run-set file.\n"
+"  -b               Also time the keyed priority queue method, and with -l\n"
+"                   the linear method, on the data widened to int64_t keys.\n";
   (void) printf("%s", s);
 }
 
 // Get and process command-line arguments.  See usage().  Set defaults before calling.
+// *p_input_path and *p_output_path are set to point into argv, or left as
+// they are if not given.
 
 void get_cfg(int argc, char *argv[], int max_nr_input_ints,
              int *p_nr_inputs, int *p_ave_input_len,
-             bool *p_do_multimerge_lin, bool *p_help_only, bool *p_error) {
+             bool *p_do_multimerge_lin, bool *p_do_wide_keys,
+             const char **p_input_path,
+             const char **p_output_path, bool *p_help_only, bool *p_error) {
   struct arg_lit *help = arg_lit0("h", "help",
                                   "Show help message and exit.");
   struct arg_lit *lin  = arg_lit0("l", NULL,
@@ -56,8 +69,14 @@ void get_cfg(int argc, char *argv[], int max_nr_input_ints,
                                   "Number of sorted input arrays to generate.");
   struct arg_int *len  = arg_int0(NULL, NULL, "<ave_input_len>",
                                   "Desired averagel length of sorted input arrays.");
+  struct arg_str *inp  = arg_str0("i", "input", "<file>",
+                                  "Run-set file to merge.");
+  struct arg_str *out  = arg_str0("o", "output", "<file>",
+                                  "Run-set file for the generated data.");
+  struct arg_lit *wid  = arg_lit0("b", "wide",
+                                  "Also time 64-bit keys.");
   struct arg_end *end  = arg_end(20);
-  void *argtable[]     = { help, lin, nr, len, end };
+  void *argtable[]     = { help, lin, inp, out, wid, nr, len, end };
   if (arg_nullcheck(argtable) != 0) {
     (void) printf("Insufficient memory to parse command-line arguments.\n");
     *p_error = true;
@@ -72,10 +91,16 @@ void get_cfg(int argc, char *argv[], int max_nr_input_ints,
     }
     if (lin->count > 0)
       *p_do_multimerge_lin = true;
+    if (wid->count > 0)
+      *p_do_wide_keys = true;
     if (nr->count > 0)
       *p_nr_inputs = nr->ival[0];
     if (len->count > 0)
       *p_ave_input_len = len->ival[0];
+    if (inp->count > 0)
+      *p_input_path = inp->sval[0];
+    if (out->count > 0)
+      *p_output_path = out->sval[0];
     if (   *p_nr_inputs <= 0 || *p_ave_input_len <= 0
            ||   (long) (*p_nr_inputs) * (long) (*p_ave_input_len)
               > (long) max_nr_input_ints) {
@@ -141,7 +166,7 @@ void free_mallocs() {
 // To replace malloc to track allocated memory, and to free all tracked memory
 // and display a string s in case malloc fails.  len is argument to malloc.
 
-void *handle_malloc (int len, const char *s) {
+void *handle_malloc (size_t len, const char *s) {
   if (nr_malloc_calls >= MAX_NR_MALLOC_CALLS) {
     free_mallocs();
     return NULL;
@@ -161,11 +186,11 @@ void *handle_malloc (int len, const char *s) {
 
 // Test that two integer arrays are equal.
 
-bool int_arrays_equal(int n0, int array0[n0], int n1, int array1[n1]) {
+bool int_arrays_equal(size_t n0, int array0[n0], size_t n1, int array1[n1]) {
   if (n0 != n1)
     return false;
 
-  for (int i = 0; i < n0; ++i) {
+  for (size_t i = 0; i < n0; ++i) {
     if (array0[i] != array1[i])
       return false;
   }
@@ -191,7 +216,7 @@ bool verify_small_data () {
   int a123[]   = {1, 2, 2, 3, 4, 5, 5, 6, 6, 7, 8, 10, 15, 20, 88, 688};
   int output[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,   0};
   int nr_inputs = 3;
-  int small_lens[] = { sizeof(a1) / sizeof(int),
+  size_t small_lens[] = { sizeof(a1) / sizeof(int),
                        sizeof(a2) / sizeof(int),
                        sizeof(a3) / sizeof(int) };
   int *small_arrays[] = { a1, a2, a3 };
@@ -210,6 +235,49 @@ bool verify_small_data () {
     retval = false;
   }
 
+  for (int arity = 2; arity <= 4; arity += 2) {
+    if (!multimerge_pq_keyed(nr_inputs, small_lens, small_arrays, tot_lens,
+                             output, arity))
+      (void) printf ("Error in multimerge_pq_keyed with small data\n");
+    if (!int_arrays_equal(tot_lens, output,
+                          sizeof(a123) / sizeof(a123[0]), a123)) {
+      print_iv("multimerge pq keyed small data", tot_lens, output);
+      (void) printf("multimerge pq keyed %d-ary differs from correctOutput\n",
+                    arity);
+      retval = false;
+    }
+  }
+
+  // Empty arrays, and enough arrays that the 4-ary heap has three levels.
+
+  size_t wide_lens[24];
+  int *wide_arrays[24];
+  int wide_values[24][2];
+  int wide_output[40];
+  int wide_correct[40];
+  int wide_tot_lens = 0;
+  for (int i = 0; i < 24; ++i) {
+    wide_lens[i]      = i % 3 == 1 ? 0 : 2;
+    wide_arrays[i]    = wide_values[i];
+    wide_values[i][0] = 23 - i;
+    wide_values[i][1] = 23 - i + 24;
+    wide_tot_lens    += wide_lens[i];
+  }
+  if (!multimerge(24, wide_lens, wide_arrays, wide_tot_lens, wide_correct))
+    (void) printf ("Error in multimerge (linear) with wide data\n");
+  for (int arity = 2; arity <= 4; arity += 2) {
+    if (!multimerge_pq_keyed(24, wide_lens, wide_arrays, wide_tot_lens,
+                             wide_output, arity))
+      (void) printf ("Error in multimerge_pq_keyed with wide data\n");
+    if (!int_arrays_equal(wide_tot_lens, wide_output,
+                          wide_tot_lens, wide_correct)) {
+      print_iv("multimerge pq keyed wide data ", wide_tot_lens, wide_output);
+      (void) printf("multimerge pq keyed %d-ary differs from linear\n",
+                    arity);
+      retval = false;
+    }
+  }
+
   if (!multimerge(nr_inputs, small_lens, small_arrays, tot_lens, output))
     (void) printf ("Error in multimerge (linear) with small data\n");
   print_iv("multimerge linear small data", tot_lens, output);
@@ -222,6 +290,58 @@ bool verify_small_data () {
   return retval;
 }
 
+// Test data for the 64-bit key functions: keys beyond 32 bits, at both ends
+// of their range, and, for unsigned keys, above 2^63, where they would be
+// negative if signed.
+
+bool verify_wide_data () {
+  const int64_t  big  = (int64_t) 1 << 40;
+  const uint64_t half = (uint64_t) 1 << 63;
+  int64_t  s1[]  = { INT64_MIN, -big, 3, big, INT64_MAX };
+  int64_t  s2[]  = { -big - 1, 3, INT64_MAX };
+  int64_t  s12[] = { INT64_MIN, -big - 1, -big, 3, 3, big, INT64_MAX,
+                     INT64_MAX };
+  uint64_t u1[]  = { 0, 7, half, UINT64_MAX };
+  uint64_t u2[]  = { half - 1, half + 1 };
+  uint64_t u12[] = { 0, 7, half - 1, half, half + 1, UINT64_MAX };
+  int64_t  *s_arrays[] = { s1, s2 };
+  uint64_t *u_arrays[] = { u1, u2 };
+  size_t    s_lens[]   = { 5, 3 };
+  size_t    u_lens[]   = { 4, 2 };
+  int64_t   s_output[8];
+  uint64_t  u_output[6];
+  bool retval = true;
+
+  for (int arity = 0; arity <= 4; arity += 2) {
+    // arity 0 for the linear method.
+    bool ok = arity == 0
+              ? multimerge_int64(2, s_lens, s_arrays, 8, s_output)
+              : multimerge_pq_int64(2, s_lens, s_arrays, 8, s_output, arity);
+    if (!ok || memcmp(s_output, s12, sizeof(s12)) != 0) {
+      (void) printf("multimerge int64 %d-ary differs from correctOutput\n",
+                    arity);
+      retval = false;
+    }
+    ok = arity == 0
+         ? multimerge_uint64(2, u_lens, u_arrays, 6, u_output)
+         : multimerge_pq_uint64(2, u_lens, u_arrays, 6, u_output, arity);
+    if (!ok || memcmp(u_output, u12, sizeof(u12)) != 0) {
+      (void) printf("multimerge uint64 %d-ary differs from correctOutput\n",
+                    arity);
+      retval = false;
+    }
+  }
+  (void) printf("multimerge int64   wide data");
+  for (int i = 0; i < 8; ++i)
+    (void) printf(" %" PRId64, s_output[i]);
+  (void) printf("\nmultimerge uint64  wide data");
+  for (int i = 0; i < 6; ++i)
+    (void) printf(" %" PRIu64, u_output[i]);
+  (void) printf("\n");
+
+  return retval;
+}
+
 // Generates random integers in a range; used to generate lengths for
 // input arrays of test data.
 
@@ -241,11 +361,12 @@ int int_rand_in_range(bool init, bool do_seed, int amin, int amax) {
 // Calculate and print statistics for list of ints, interpreted as
 // various lengths centered at ave_input_len; return total length.
 
-int calc_display_stats(int ave_input_len, int nr_inputs, int lens[nr_inputs]) {
-  int tot_lens  = 0;
-  int len;
-  int max_len  = INT_MIN;
-  int min_len  = INT_MAX;
+size_t calc_display_stats(int ave_input_len, int nr_inputs,
+                          size_t lens[nr_inputs]) {
+  size_t tot_lens = 0;
+  size_t len;
+  size_t max_len  = 0;
+  size_t min_len  = SIZE_MAX;
 
   for (int i = 0; i < nr_inputs; ++i) {
     len = lens[i];
@@ -260,14 +381,14 @@ int calc_display_stats(int ave_input_len, int nr_inputs, int lens[nr_inputs]) {
                     / (double) (nr_inputs);
   double sum_sq_dev = 0;
   for (int i = 0; i < nr_inputs; ++i) {
-    double diff = (double) (lens[i] - mean_len);
+    double diff = (double) lens[i] - mean_len;
     sum_sq_dev += (diff * diff);
   }
 
   (void) printf("nr_inputs %d, requested ave_input_len %d\n"
-                "their product %d, actual tot_lens %d\n"
-                "mean_len %d, std dev %d, min_len %d, max_len %d\n",
-                nr_inputs, ave_input_len, nr_inputs * ave_input_len,
+                "their product %ld, actual tot_lens %zu\n"
+                "mean_len %d, std dev %d, min_len %zu, max_len %zu\n",
+                nr_inputs, ave_input_len, (long) nr_inputs * ave_input_len,
                 tot_lens, (int) (round(mean_len)),
                 (int) (round(sqrt(sum_sq_dev / (double) (nr_inputs)))),
                 min_len, max_len);
@@ -277,7 +398,7 @@ int calc_display_stats(int ave_input_len, int nr_inputs, int lens[nr_inputs]) {
 
 // Swap of two elements of indices i, j, of an int array.
 
-static inline void shuffle_swap (int *array, int i, int j) {
+static inline void shuffle_swap (int *array, size_t i, size_t j) {
   int temp = array[i];
   array[i] = array[j];
   array[j] = temp;
@@ -288,9 +409,10 @@ static inline void shuffle_swap (int *array, int i, int j) {
 // edition, by Cormen, Leiserson, Rivest, and Stein, MIT, 2009, pp. 126-127,
 // which produces uniform random permutations.
 
-void random_shuffle (int n, int array[n]) {
-  for (int i = 0; i < n; i++) {
-    shuffle_swap (array, i, int_rand_in_range(true, false, i, n - 1));
+void random_shuffle (size_t n, int array[n]) {
+  for (size_t i = 0; i < n; i++) {
+    shuffle_swap (array, i,
+                  int_rand_in_range(true, false, (int) i, (int) (n - 1)));
   }
 }
 
@@ -312,19 +434,19 @@ int compare_int (const void *p0, const void *p1) {
 // distributed from about ave_input_len / 10 to 2 * ave_input_len minus that;
 // a range centered at ave_input_len.  Return false for failure.
 
-bool generate_data(int    nr_inputs,
-                   int    ave_input_len,
-                   int  **p_lens,
-                   int   *p_tot_lens,
-                   int  **p_input_copy,
-                   int ***p_arrays) {
+bool generate_data(int      nr_inputs,
+                   int      ave_input_len,
+                   size_t **p_lens,
+                   size_t  *p_tot_lens,
+                   int    **p_input_copy,
+                   int   ***p_arrays) {
   int amin = (ave_input_len + 5) / 10;
   if (amin < 1)
     amin = 1;
   int amax = 2 * ave_input_len - amin;
   int_rand_in_range(true, false, amin, amax);
-  int *lens = handle_malloc (nr_inputs * sizeof (int),
-                             "Unable to allocate memory for \"lens\".");
+  size_t *lens = handle_malloc (nr_inputs * sizeof (size_t),
+                                "Unable to allocate memory for \"lens\".");
   if (lens == NULL)
     return false;
   *p_lens = lens;
@@ -332,8 +454,8 @@ bool generate_data(int    nr_inputs,
   for (int i = 0; i < nr_inputs; ++i)
     lens[i] = int_rand_in_range(false, false, amin, amax);
 
-  int tot_lens = calc_display_stats(ave_input_len, nr_inputs, lens);
-  *p_tot_lens  = tot_lens;
+  size_t tot_lens = calc_display_stats(ave_input_len, nr_inputs, lens);
+  *p_tot_lens     = tot_lens;
 
   // Generate the input data by initializing an overall input array
   // sequentially, shuffling it, piecing it out into the individual input
@@ -357,18 +479,18 @@ bool generate_data(int    nr_inputs,
   if (*p_input_copy == NULL)
     return false;
 
-  for (int i = 0, j = 1; i < tot_lens; ++i, ++j) {
-    input[i] = j;
-    (*p_input_copy)[i] = j;  // for later comparison with merge result
+  for (size_t i = 0; i < tot_lens; ++i) {
+    input[i] = (int) i + 1;
+    (*p_input_copy)[i] = input[i];  // for later comparison with merge result
   }
 
   random_shuffle (tot_lens, input);
 
-  int k = 0;
+  size_t k = 0;
   int *array = *p_input_copy + tot_lens;
   for (int i = 0; i < nr_inputs; ++i) {
     (*p_arrays)[i] = array;
-    for (int j = 0; j < lens[i]; ++j, ++k)
+    for (size_t j = 0; j < lens[i]; ++j, ++k)
       array[j] = input[k];
     qsort(array, lens[i], sizeof (int), compare_int);
     array += lens[i];
@@ -378,6 +500,56 @@ bool generate_data(int    nr_inputs,
   return true;
 }
 
+// Set up merge input from the run-set file mapped in *prs: *p_lens and
+// *p_arrays describe its runs, pointing into the mapping, and *p_input_copy
+// is their concatenation, sorted, for comparison with merge results.
+// Return false for failure.
+
+bool run_set_data(const RunSet *prs,
+                  size_t      **p_lens,
+                  size_t       *p_tot_lens,
+                  int         **p_input_copy,
+                  int        ***p_arrays) {
+  if (prs->header.value_size != sizeof (int)) {
+    (void) printf ("Run-set values are %d-bit, not int\n",
+                   8 * (int) prs->header.value_size);
+    return false;
+  }
+  if (   prs->header.nr_runs == 0
+      || prs->header.nr_runs > INT_MAX
+      || prs->header.nr_values > SIZE_MAX / sizeof (int)) {
+    (void) printf ("Run set has no runs, too many runs, or too many values\n");
+    return false;
+  }
+  int    nr_inputs = prs->header.nr_runs;
+  size_t tot_lens  = prs->header.nr_values;
+  *p_tot_lens      = tot_lens;
+
+  *p_lens = handle_malloc (nr_inputs * sizeof (size_t),
+                           "Unable to allocate memory for \"lens\".");
+  if (*p_lens == NULL)
+    return false;
+  *p_arrays = (int **) handle_malloc (nr_inputs * sizeof (int *),
+                                      "Unable to allocate memory for arrays.");
+  if (*p_arrays == NULL)
+    return false;
+  *p_input_copy = handle_malloc (tot_lens * sizeof (int),
+                                 "Unable to allocate memory for input.");
+  if (*p_input_copy == NULL)
+    return false;
+
+  // The merge functions take non-const arrays but only read them.
+
+  int *values = (int *) prs->payload;
+  for (int i = 0; i < nr_inputs; ++i) {
+    (*p_lens)[i]   = prs->offsets[i + 1] - prs->offsets[i];
+    (*p_arrays)[i] = values + prs->offsets[i];
+  }
+  memcpy(*p_input_copy, values, tot_lens * sizeof (int));
+  qsort(*p_input_copy, tot_lens, sizeof (int), compare_int);
+  return true;
+}
+
 // For timing merges; in actual usage s is nonempty for start == false only.
 
 void stopwatch(bool start, const char *s) {
@@ -397,6 +569,68 @@ void stopwatch(bool start, const char *s) {
   }
 }
 
+// Times the keyed priority queue multimerge, and if do_lin the linear one,
+// on arrays widened to int64_t keys, each value times 2^32 so that the keys
+// fill the high half, checking the output against input_copy widened the
+// same way.  Returns false if any output was wrong or memory ran out.
+
+bool test_wide_keys(int nr_inputs, size_t lens[nr_inputs],
+                    int *arrays[nr_inputs], size_t tot_lens,
+                    int input_copy[tot_lens], bool do_lin) {
+  const int64_t scale = (int64_t) 1 << 32;
+  int64_t **wide_arrays = handle_malloc (nr_inputs * sizeof (int64_t *),
+                                         "Unable to allocate memory for "
+                                         "wide arrays.");
+  if (wide_arrays == NULL)
+    return false;
+  int64_t *wide_values = handle_malloc (2 * tot_lens * sizeof (int64_t),
+                                        "Unable to allocate memory for "
+                                        "wide values.");
+  if (wide_values == NULL)
+    return false;
+  int64_t *wide_output = wide_values + tot_lens;
+
+  int64_t *array = wide_values;
+  for (int i = 0; i < nr_inputs; ++i) {
+    wide_arrays[i] = array;
+    for (size_t j = 0; j < lens[i]; ++j)
+      array[j] = arrays[i][j] * scale;
+    array += lens[i];
+  }
+
+  bool retval = true;
+  for (int arity = (do_lin ? 0 : 2); arity <= 4; arity += 2) {
+    // arity 0 for the linear method.
+    char label[40];
+    if (arity == 0)
+      (void) snprintf (label, sizeof(label), "multimerge lin int64");
+    else
+      (void) snprintf (label, sizeof(label), "multimerge pq int64 %d-ary",
+                       arity);
+    (void) printf ("%s\n", label);
+    stopwatch(true, "");
+    bool ok = arity == 0
+              ? multimerge_int64(nr_inputs, lens, wide_arrays, tot_lens,
+                                 wide_output)
+              : multimerge_pq_int64(nr_inputs, lens, wide_arrays, tot_lens,
+                                    wide_output, arity);
+    if (!ok)
+      (void) printf ("Error in %s with large data\n", label);
+    stopwatch(false, label);
+    bool cmp_ok = ok;
+    for (size_t i = 0; cmp_ok && i < tot_lens; ++i)
+      cmp_ok = wide_output[i] == input_copy[i] * scale;
+    if (!cmp_ok)
+      retval = false;
+    (void) printf ("%s %s input_copy\n", label,
+                   cmp_ok ? "matches     " : "differs from");
+  }
+
+  free_malloc(wide_values);
+  free_malloc(wide_arrays);
+  return retval;
+}
+
 // Test program for mmerge.c.
 
 int testmmerge_main(int argc, char *argv[]) {
@@ -408,11 +642,15 @@ int testmmerge_main(int argc, char *argv[]) {
   int  nr_inputs         = 1000;
   int  ave_input_len     = 10000;
   bool do_multimerge_lin = false;
+  bool do_wide_keys      = false;
+  const char *input_path  = NULL;
+  const char *output_path = NULL;
   bool help_only         = false;
   bool error             = false;
 
   get_cfg(argc, argv, max_nr_input_ints, &nr_inputs, &ave_input_len,
-          &do_multimerge_lin, &help_only, &error);
+          &do_multimerge_lin, &do_wide_keys, &input_path, &output_path,
+          &help_only, &error);
   if (help_only)
     return 0;
   else if (error)
@@ -421,16 +659,36 @@ int testmmerge_main(int argc, char *argv[]) {
   bool retval = true;  // set to false if any errors in merge output
   if (!verify_small_data())
     retval = false;
+  if (!verify_wide_data())
+    retval = false;
 
   // Do the larger tests.
 
-  int  *lens;
-  int   tot_lens;
-  int  *input_copy;
-  int **arrays;
-  if (!generate_data(nr_inputs, ave_input_len, &lens, &tot_lens,
-                     &input_copy, &arrays))
-    return -1;
+  size_t *lens;
+  size_t  tot_lens;
+  int    *input_copy;
+  int   **arrays;
+  RunSet run_set;
+  memset(&run_set, 0, sizeof(run_set));
+  if (input_path != NULL) {
+    if (   !run_set_open(input_path, &run_set)
+        || !run_set_data(&run_set, &lens, &tot_lens, &input_copy, &arrays)) {
+      run_set_close(&run_set);
+      free_mallocs();
+      return -1;
+    }
+    nr_inputs = run_set.header.nr_runs;
+    calc_display_stats((int) (tot_lens / nr_inputs), nr_inputs, lens);
+  } else {
+    if (!generate_data(nr_inputs, ave_input_len, &lens, &tot_lens,
+                       &input_copy, &arrays))
+      return -1;
+    if (   output_path != NULL
+        && !run_set_write(output_path, nr_inputs, lens, arrays)) {
+      free_mallocs();
+      return -1;
+    }
+  }
 
   int *output = handle_malloc (tot_lens * sizeof (int),
                                "Unable to allocate memory for output.");
@@ -448,6 +706,23 @@ int testmmerge_main(int argc, char *argv[]) {
   (void) printf ("multimerge pq       %s input_copy\n",
                  cmp_ok ? "matches     " : "differs from");
 
+  // The keyed heaps against the pointer-pair heap above.
+
+  for (int arity = 2; arity <= 4; arity += 2) {
+    char label[40];
+    (void) snprintf (label, sizeof(label), "multimerge pq keyed %d-ary", arity);
+    (void) printf ("%s\n", label);
+    stopwatch(true, "");
+    if (!multimerge_pq_keyed(nr_inputs, lens, arrays, tot_lens, output, arity))
+      (void) printf ("Error in multimerge_pq_keyed with large data\n");
+    stopwatch(false, label);
+    cmp_ok = int_arrays_equal (tot_lens, output, tot_lens, input_copy);
+    if (!cmp_ok)
+      retval = false;
+    (void) printf ("multimerge pq keyed %d %s input_copy\n", arity,
+                   cmp_ok ? "matches     " : "differs from");
+  }
+
   if (do_multimerge_lin) {
     (void) printf ("multimerge (linear)\n");
     stopwatch(true, "");
@@ -461,6 +736,12 @@ int testmmerge_main(int argc, char *argv[]) {
                    cmp_ok ? "matches     " : "differs from");
   }
 
+  if (   do_wide_keys
+      && !test_wide_keys(nr_inputs, lens, arrays, tot_lens, input_copy,
+                         do_multimerge_lin))
+    retval = false;
+
+  run_set_close(&run_set);
   free_mallocs();
 
   return retval ? 0 : -1;
@@ -1,176 +1,385 @@
-// cc/mmerge.cc rev. 22 July 2013 by Stuart Ambler.
+// cc/mmerge.cc rev. 17 October 2026 by Stuart Ambler.
 // Merge of k sorted arrays of ints.  See cc/mmerge.h for further comments.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
 #include "./mmerge.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MMERGE_X86_SIMD 1
+#endif
+
 namespace com_zulazon_samples_cc_mmerge {
 
-// Typedefs for both methods of merge.
-
-typedef std::vector<IntVectorConstIterator> IntVectorConstIteratorVector;
-typedef std::vector<IntVectorConstIterator>::iterator
-                                           IntVectorConstIteratorVectorIterator;
-
-// Classes and typedef only for the priority queue method.
-
-class IteratorPointerPair {
- public:
-  // The second argument to the first constructor could be a const ptr for
-  // that constructor, but later elsewhere is used as a plain ptr.
-  IteratorPointerPair(const IntVectorVectorConstIterator &i,
-                      IntVectorConstIterator *p) : it_to_vec_(i),
-                                                   ptr_const_it_(p) {}
-  // To comply with Google style guidelines, this code should define a
-  // copy constructor and assignment operator, also getter functions to
-  // use in place of direct access to fields, which should be private.
-  // However, experiment showed that these things cost about an 18% increase
-  // in execution time, so they're commented out as follows, and uses in
-  // multimerge_pq of the getters are replaced with direct access.
-  // IteratorPointerPair(const IteratorPointerPair &ipp)
-  //                                          : it_to_vec_(ipp.it_to_vec_),
-  //                                         ptr_const_it_(ipp.ptr_const_it_) {}
-  // IteratorPointerPair & operator= (const IteratorPointerPair &ipp) {
-  //   it_to_vec_    = ipp.it_to_vec_;
-  //   ptr_const_it_ = ipp.ptr_const_it_;
-  // }
-  //  IntVectorVectorConstIterator &it_to_vec() {
-  //    return it_to_vec_;
-  //  }
-  //  IntVectorConstIterator *ptr_const_it() {
-  //    return ptr_const_it_;
-  //  }
-
-  // private:
-  //  friend class IteratorPointerPairReverseCompare;
-  IntVectorVectorConstIterator it_to_vec_;  //  *it_to_vec_ is a vector
-  IntVectorConstIterator *ptr_const_it_;    // **ptr_const_it_ must be an
-                                            // element of *it_to_vec
+// The functions below are thin instantiations of the templates in
+// cc/mmergetemplate.h for int keys compared by std::less, writing through a
+// pointer into *poutput, which is sized first.
+
+// Multimerge, linear in k.
+
+void multimerge(const IntVectorVector &arrays, IntVector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int>(arrays, poutput->data(), kLinear);
+}
+
+void multimerge(const FlatRuns &runs, IntVector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int>(runs, poutput->data(), kLinear);
+}
+
+// Priority queue multimerge, logarithmic in k.
+
+void multimerge_pq(const IntVectorVector &arrays, IntVector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int>(arrays, poutput->data(), kPriorityQueue);
+}
+
+void multimerge_pq(const FlatRuns &runs, IntVector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int>(runs, poutput->data(), kPriorityQueue);
+}
+
+// Loser tree multimerge, logarithmic in k.
+
+void multimerge_lt(const IntVectorVector &arrays, IntVector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int>(arrays, poutput->data(), kLoserTree);
+}
+
+void multimerge_lt(const FlatRuns &runs, IntVector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int>(runs, poutput->data(), kLoserTree);
+}
+
+// Galloping loser tree multimerge.
+
+void multimerge_gallop(const IntVectorVector &arrays, IntVector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int>(arrays, poutput->data(), kGalloping);
+}
+
+void multimerge_gallop(const FlatRuns &runs, IntVector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int>(runs, poutput->data(), kGalloping);
+}
+
+// Fenced multimerge, copying the parts of arrays no other overlaps.
+
+void multimerge_fenced(const IntVectorVector &arrays, IntVector *poutput,
+                       MergeMethod method, FenceStats *pstats) {
+  poutput->resize(total_length(arrays));
+  multimerge_fenced<int>(arrays, poutput->data(), pstats, method);
+}
+
+void multimerge_fenced(const FlatRuns &runs, IntVector *poutput,
+                       MergeMethod method, FenceStats *pstats) {
+  poutput->resize(runs.values.size());
+  multimerge_fenced<int>(runs, poutput->data(), pstats, method);
+}
+
+// Multimerge into a caller's buffer with reusable storage.
+
+bool multimerge(const IntVectorVector &arrays, int *output,
+                size_t output_size, MergeContext *pcontext,
+                MergeMethod method) {
+  if (output_size < total_length(arrays))
+    return false;
+  pcontext->merge(arrays, output, method);
+  return true;
+}
+
+bool multimerge(const FlatRuns &runs, int *output, size_t output_size,
+                FlatMergeContext *pcontext, MergeMethod method) {
+  if (output_size < runs.values.size())
+    return false;
+  pcontext->merge(runs, output, method);
+  return true;
+}
+
+// Parallel multimerge.
+
+void multimerge_par(const IntVectorVector &arrays, IntVector *poutput,
+                    int nr_threads, MergeMethod method) {
+  poutput->resize(total_length(arrays));
+  multimerge_par<int>(arrays, poutput->data(), nr_threads, method);
+}
+
+void multimerge_par(const FlatRuns &runs, IntVector *poutput,
+                    int nr_threads, MergeMethod method) {
+  poutput->resize(runs.values.size());
+  multimerge_par<int>(runs, poutput->data(), nr_threads, method);
+}
+
+// The same for 64-bit keys.
+
+void multimerge(const Int64VectorVector &arrays, Int64Vector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int64_t>(arrays, poutput->data(), kLinear);
+}
+
+void multimerge_pq(const Int64VectorVector &arrays, Int64Vector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int64_t>(arrays, poutput->data(), kPriorityQueue);
+}
+
+void multimerge_lt(const Int64VectorVector &arrays, Int64Vector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<int64_t>(arrays, poutput->data(), kLoserTree);
+}
+
+void multimerge_par(const Int64VectorVector &arrays, Int64Vector *poutput,
+                    int nr_threads, MergeMethod method) {
+  poutput->resize(total_length(arrays));
+  multimerge_par<int64_t>(arrays, poutput->data(), nr_threads, method);
+}
+
+void multimerge(const Int64FlatRuns &runs, Int64Vector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int64_t>(runs, poutput->data(), kLinear);
+}
+
+void multimerge_pq(const Int64FlatRuns &runs, Int64Vector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int64_t>(runs, poutput->data(), kPriorityQueue);
+}
+
+void multimerge_lt(const Int64FlatRuns &runs, Int64Vector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<int64_t>(runs, poutput->data(), kLoserTree);
+}
+
+void multimerge_par(const Int64FlatRuns &runs, Int64Vector *poutput,
+                    int nr_threads, MergeMethod method) {
+  poutput->resize(runs.values.size());
+  multimerge_par<int64_t>(runs, poutput->data(), nr_threads, method);
+}
+
+void multimerge(const UInt64VectorVector &arrays, UInt64Vector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<uint64_t>(arrays, poutput->data(), kLinear);
+}
+
+void multimerge_pq(const UInt64VectorVector &arrays, UInt64Vector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<uint64_t>(arrays, poutput->data(), kPriorityQueue);
+}
+
+void multimerge_lt(const UInt64VectorVector &arrays, UInt64Vector *poutput) {
+  poutput->resize(total_length(arrays));
+  multimerge<uint64_t>(arrays, poutput->data(), kLoserTree);
+}
+
+void multimerge_par(const UInt64VectorVector &arrays, UInt64Vector *poutput,
+                    int nr_threads, MergeMethod method) {
+  poutput->resize(total_length(arrays));
+  multimerge_par<uint64_t>(arrays, poutput->data(), nr_threads, method);
+}
+
+void multimerge(const UInt64FlatRuns &runs, UInt64Vector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<uint64_t>(runs, poutput->data(), kLinear);
+}
+
+void multimerge_pq(const UInt64FlatRuns &runs, UInt64Vector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<uint64_t>(runs, poutput->data(), kPriorityQueue);
+}
+
+void multimerge_lt(const UInt64FlatRuns &runs, UInt64Vector *poutput) {
+  poutput->resize(runs.values.size());
+  multimerge<uint64_t>(runs, poutput->data(), kLoserTree);
+}
+
+void multimerge_par(const UInt64FlatRuns &runs, UInt64Vector *poutput,
+                    int nr_threads, MergeMethod method) {
+  poutput->resize(runs.values.size());
+  multimerge_par<uint64_t>(runs, poutput->data(), nr_threads, method);
+}
+
+// Struct and functions only for the SIMD linear method.
+
+// The current head of each input, in a dense aligned array padded to a
+// multiple of 8 entries with INT_MAX, which also marks exhausted inputs, so
+// that the minimum and its slot can be found with vector instructions and
+// no test for end of input.
+
+struct SimdHeads {
+  alignas(32) int heads[kMaxSimdInputs];
+  const int      *its[kMaxSimdInputs];
+  const int      *ends[kMaxSimdInputs];
+  int             nr_inputs;
+  int             nr_padded;
 };
 
-class IteratorPointerPairReverseCompare {
- public:
-  // As in the IteratorPointPair comment, the following are commented out,
-  // though the difference in execution time measured was 1%, which may have
-  // been normal variation.
-  // IteratorPointerPairReverseCompare() = default;
-  // IteratorPointerPairReverseCompare
-  //                                const IteratorPointerPairReverseCompare &) {
-  // }
-  // IteratorPointerPairReverseCompare & operator= (
-  //                        const IteratorPointerPairReverseCompare &) = delete;
-
-  bool operator()(const IteratorPointerPair &it0,
-                  const IteratorPointerPair &it1) const {
-    return (**(it0.ptr_const_it_) > **(it1.ptr_const_it_));
+// Called when the minimum head is INT_MAX, which may be padding or an
+// exhausted input rather than a value: returns the first input not
+// exhausted, whose head must then be INT_MAX too.
+
+static int simd_int_max_slot(const SimdHeads &h, int slot) {
+  for (int i = 0; i < h.nr_inputs; ++i) {
+    if (h.its[i] != h.ends[i])
+      return i;
   }
-};
+  return slot;
+}
 
-typedef std::priority_queue<IteratorPointerPair,
-                            std::vector<IteratorPointerPair>,
-                            IteratorPointerPairReverseCompare> IntPriorityQueue;
-
-// In C rather than STL terms (i.e. loosely speaking), minptrix is a function
-// to find the minimum value pointed to by an array pvcits of pointers
-// that point to elements of the corresponding (vector) elements of arrays.
-// Thus the number of (vector) elements of arrays must equal the number of
-// elements of pvcits.  Execution time is linear in this number.  After
-// finding the minimum value, the (iterator) element of pvcits that points
-// to it is incremented.  minptrix is designed to be called repeatedly by
-// function multimerge, until all elements of pvcits are at the ends of the
-// corresponding (vector) elements of arrays.  It returns true if not all the
-// pointers were at the ends (past the ends) of their vectors and *pminval
-// has been set to a value in an element of arrays; otherwise *pminval is set
-// to INT_MAX.
-
-static bool minptrix(const IntVectorVector   &arrays,
-                     IntVectorConstIteratorVector *pvcits,
-                     int *pminval) {
-  bool did_examine = false;  // did examine an element of an element of arrays
-  IntVectorConstIteratorVectorIterator minit;
-  int  minval;
-
-  IntVectorVectorConstIterator                ia = arrays.begin();
-  for (IntVectorConstIteratorVectorIterator iits = pvcits->begin();
-       iits != pvcits->end(); ++iits, ++ia) {
-    if (*iits == ia->end()) {
-      continue;
-    }
+// Returns the head of input slot and advances that input.
+
+static inline int simd_take(SimdHeads *ph, int slot) {
+  int value = ph->heads[slot];
+  const int *it = ++ph->its[slot];
+  ph->heads[slot] = (it != ph->ends[slot]) ? *it : INT_MAX;
+  return value;
+}
 
-    int curval = **iits;
+#ifdef MMERGE_X86_SIMD
 
-    if ((!did_examine) || minval > curval) {
-      did_examine = true;
-      minval      = curval;
-      minit       = iits;
-    }
-  }
+// Slot of the first minimum of heads[0] through heads[nr_padded - 1] (a
+// multiple of 8, 32 at most): reduce by vector minimum to one vector, then
+// to one value by shuffles, broadcast it, and find the first lane equal to
+// it with a compare and movemask.
 
-  if (did_examine) {
-    *pminval = minval;
-    ++(*minit);
-  } else {
-    *pminval = INT_MAX;
+__attribute__((target("avx2")))
+static inline int min_slot_avx2(const int *heads, int nr_padded) {
+  __m256i m = _mm256_load_si256(reinterpret_cast<const __m256i *>(heads));
+  for (int i = 8; i < nr_padded; i += 8) {
+    m = _mm256_min_epi32(m, _mm256_load_si256(
+                                reinterpret_cast<const __m256i *>(heads + i)));
   }
+  __m128i m4 = _mm_min_epi32(_mm256_castsi256_si128(m),
+                             _mm256_extracti128_si256(m, 1));
+  m4 = _mm_min_epi32(m4, _mm_shuffle_epi32(m4, _MM_SHUFFLE(1, 0, 3, 2)));
+  m4 = _mm_min_epi32(m4, _mm_shuffle_epi32(m4, _MM_SHUFFLE(2, 3, 0, 1)));
+  __m256i b = _mm256_broadcastd_epi32(m4);
+  for (int i = 0; i < nr_padded; i += 8) {
+    __m256i eq = _mm256_cmpeq_epi32(b, _mm256_load_si256(
+                                        reinterpret_cast<const __m256i *>(
+                                            heads + i)));
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+    if (mask != 0)
+      return i + __builtin_ctz(mask);
+  }
+  return 0;
+}
 
-  return did_examine;
+__attribute__((target("sse4.1")))
+static inline int min_slot_sse41(const int *heads, int nr_padded) {
+  __m128i m = _mm_load_si128(reinterpret_cast<const __m128i *>(heads));
+  for (int i = 4; i < nr_padded; i += 4) {
+    m = _mm_min_epi32(m, _mm_load_si128(
+                             reinterpret_cast<const __m128i *>(heads + i)));
+  }
+  m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+  m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+  for (int i = 0; i < nr_padded; i += 4) {
+    __m128i eq = _mm_cmpeq_epi32(m, _mm_load_si128(
+                                        reinterpret_cast<const __m128i *>(
+                                            heads + i)));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+    if (mask != 0)
+      return i + __builtin_ctz(mask);
+  }
+  return 0;
 }
 
-// Multimerge, linear in k.
+// The merge loops, one per instruction set so that the kernel inlines.
 
-void multimerge(const IntVectorVector &arrays, IntVector *poutput) {
-  IntVectorConstIteratorVector its;
-  int total_nr = 0;
-
-  its.reserve(arrays.size());
-  for (IntVectorVectorConstIterator ia = arrays.begin();
-       ia != arrays.end(); ++ia) {
-    its.push_back(ia->begin());
-    total_nr += ia->size();
+__attribute__((target("avx2")))
+static void merge_simd_avx2(SimdHeads *ph, size_t total_nr,
+                            int *output) {
+  for (size_t i = 0; i < total_nr; ++i) {
+    int slot = min_slot_avx2(ph->heads, ph->nr_padded);
+    if (ph->heads[slot] == INT_MAX)
+      slot = simd_int_max_slot(*ph, slot);
+    *output++ = simd_take(ph, slot);
   }
+}
 
-  poutput->clear();
-  poutput->reserve(total_nr);
-
-  int minval;
-  while (minptrix(arrays, &its, &minval)) {
-    poutput->push_back(minval);
+__attribute__((target("sse4.1")))
+static void merge_simd_sse41(SimdHeads *ph, size_t total_nr,
+                             int *output) {
+  for (size_t i = 0; i < total_nr; ++i) {
+    int slot = min_slot_sse41(ph->heads, ph->nr_padded);
+    if (ph->heads[slot] == INT_MAX)
+      slot = simd_int_max_slot(*ph, slot);
+    *output++ = simd_take(ph, slot);
   }
 }
 
-// Priority queue multimerge, logarithmic in k.
+#endif  // MMERGE_X86_SIMD
 
-void multimerge_pq(const IntVectorVector &arrays, IntVector *poutput) {
-  IntVectorVectorConstIterator ia;
-  IntVectorConstIteratorVector its;
-  IntPriorityQueue pq;
-  int total_nr = 0;
-
-  its.reserve(arrays.size());
-  for (ia = arrays.begin(); (ia != arrays.end()); ++ia) {
-    its.push_back(ia->begin());
-    pq.push(IteratorPointerPair(ia, &(its.back())));
-    total_nr += ia->size();
+// The first element of an input array or flat run.
+
+static inline const int *range_data(const IntVector &array) {
+  return array.data();
+}
+
+static inline const int *range_data(const FlatRuns::Range &run) {
+  return run.first;
+}
+
+// SIMD multimerge, linear in k, for k up to kMaxSimdInputs nonempty inputs;
+// otherwise, or without SSE4.1, the scalar linear method.  Empty inputs are
+// left out of the heads, so that they cost nothing and do not count
+// against kMaxSimdInputs; the order of the rest, and so of equal values, is
+// kept.  For a vector of vectors or flat runs.
+
+template <typename Ranges>
+static void multimerge_simd_ranges(const Ranges &arrays, IntVector *poutput) {
+  int nr_inputs = 0;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    if (std::begin(arrays[i]) != std::end(arrays[i]))
+      ++nr_inputs;
   }
-  poutput->clear();
-  poutput->reserve(total_nr);
-
-  IntVectorVectorConstIterator  it_to_vec;
-  IntVectorConstIterator       *ptr_const_it = nullptr;
-  IteratorPointerPair  it_pval(it_to_vec, ptr_const_it);
-  int minval;
-
-  for (int i = 0; i < total_nr; ++i) {
-    it_pval = pq.top();
-    pq.pop();
-    minval = **(it_pval.ptr_const_it_);
-    ++(*(it_pval.ptr_const_it_));
-    if (*(it_pval.ptr_const_it_) != it_pval.it_to_vec_->end()) {
-      pq.push(IteratorPointerPair(it_pval));
-    }
-    poutput->push_back(minval);
+#ifdef MMERGE_X86_SIMD
+  bool has_avx2  = __builtin_cpu_supports("avx2");
+  bool has_sse41 = __builtin_cpu_supports("sse4.1");
+#else
+  bool has_avx2  = false;
+  bool has_sse41 = false;
+#endif
+  if (nr_inputs == 0 || nr_inputs > kMaxSimdInputs
+      || !(has_avx2 || has_sse41)) {
+    multimerge(arrays, poutput);
+    return;
   }
+
+  SimdHeads h;
+  h.nr_inputs = nr_inputs;
+  h.nr_padded = (nr_inputs + 7) / 8 * 8;
+  for (int i = 0; i < h.nr_padded; ++i) {
+    h.heads[i] = INT_MAX;
+    h.its[i]   = h.ends[i] = nullptr;
+  }
+  size_t total_nr = 0;
+  int    slot     = 0;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    size_t len = std::end(arrays[i]) - std::begin(arrays[i]);
+    if (len == 0)
+      continue;
+    h.its[slot]   = range_data(arrays[i]);
+    h.ends[slot]  = h.its[slot] + len;
+    h.heads[slot] = *h.its[slot];
+    total_nr += len;
+    ++slot;
+  }
+
+  poutput->resize(total_nr);
+#ifdef MMERGE_X86_SIMD
+  if (has_avx2)
+    merge_simd_avx2(&h, total_nr, poutput->data());
+  else
+    merge_simd_sse41(&h, total_nr, poutput->data());
+#endif
+}
+
+void multimerge_simd(const IntVectorVector &arrays, IntVector *poutput) {
+  multimerge_simd_ranges(arrays, poutput);
+}
+
+void multimerge_simd(const FlatRuns &runs, IntVector *poutput) {
+  multimerge_simd_ranges(runs, poutput);
 }
 
 }  // namespace com_zulazon_samples_cc_mmerge
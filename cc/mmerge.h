@@ -1,26 +1,30 @@
-// cc/mmerge.h rev. 22 July 2013 by Stuart Ambler.  Header for cc/mmerge.cc.
+// cc/mmerge.h rev. 17 October 2026 by Stuart Ambler.  Header for cc/mmerge.cc.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
 // Merge of k sorted arrays of ints, given in the form of a vector of vectors,
 // using either a simple algorithm linear in k, the number of vectors, or
-// instead an algorithm that uses a priority queue, logarithmic in k.  Either
-// way, the dependence on n, the total length of all the vectors, is linear.
-// Minimal exception or other error handling.
+// instead an algorithm that uses a priority queue or a loser tree, both
+// logarithmic in k.  Either way, the dependence on n, the total length of all
+// the vectors, is linear.  Minimal exception or other error handling.
 
 #ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGE_H_
 #define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGE_H_
 
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
 
 #include <algorithm>
 #include <queue>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "./mmergetemplate.h"
+
 namespace com_zulazon_samples_cc_mmerge {
 
 // Typedefs for both methods of merge; linear and priority queue.
@@ -32,17 +36,189 @@ typedef std::vector<int>::const_iterator IntVectorConstIterator;
 typedef std::vector<IntVector>                 IntVectorVector;
 typedef std::vector<IntVector>::const_iterator IntVectorVectorConstIterator;
 
+// Typedefs for the 64-bit key overloads below.
+
+typedef std::vector<int64_t>      Int64Vector;
+typedef std::vector<Int64Vector>  Int64VectorVector;
+typedef std::vector<uint64_t>     UInt64Vector;
+typedef std::vector<UInt64Vector> UInt64VectorVector;
+
+// Typedefs for the flat layout of runs; see BasicFlatRuns in
+// cc/mmergetemplate.h.  Each function below taking a vector of vectors has
+// an overload taking the same runs flat, with the same contract.
+
+typedef BasicFlatRuns<int>      FlatRuns;
+typedef BasicFlatRuns<int64_t>  Int64FlatRuns;
+typedef BasicFlatRuns<uint64_t> UInt64FlatRuns;
+
 // Multimerge, linear in k.  Each element of arrays must be a sorted
 // vector of int.  On return, *poutput will be a sorted vector containing
 // all the values in all the elements of arrays.
 
 void multimerge(const IntVectorVector &arrays, IntVector *poutput);
+void multimerge(const FlatRuns &runs, IntVector *poutput);
+
+// SIMD multimerge, linear in k, for small k.  Same contract as multimerge.
+// For up to kMaxSimdInputs elements of arrays, the current heads are kept in
+// a dense array and the minimum found with AVX2 or SSE4.1 vector minimum
+// instructions, chosen at run time by CPU detection; for more, or on a CPU
+// with neither, this calls multimerge.
+
+const int kMaxSimdInputs = 32;
+
+void multimerge_simd(const IntVectorVector &arrays, IntVector *poutput);
+void multimerge_simd(const FlatRuns &runs, IntVector *poutput);
 
 // Priority queue multimerge, logarithmic in k. Each element of arrays must be
 // a sorted vector of int.  On return, *poutput will be a sorted vector
 // containing all the values in all the elements of arrays.
 
 void multimerge_pq(const IntVectorVector &arrays, IntVector *poutput);
+void multimerge_pq(const FlatRuns &runs, IntVector *poutput);
+
+// Loser tree (tournament tree) multimerge, logarithmic in k.  Each element of
+// arrays must be a sorted vector of int.  On return, *poutput will be a sorted
+// vector containing all the values in all the elements of arrays.  Each output
+// element costs one leaf-to-root replay of about log2(k) comparisons, against
+// about 2 * log2(k) for a priority queue pop and push, and the current head
+// values are kept in the tree nodes rather than reached through iterators.
+// Equal values are output in the order of the elements of arrays holding them.
+
+void multimerge_lt(const IntVectorVector &arrays, IntVector *poutput);
+void multimerge_lt(const FlatRuns &runs, IntVector *poutput);
+
+// Galloping loser tree multimerge.  Same contract and output as
+// multimerge_lt.  Once one element of arrays has supplied kMinGallop output
+// values in a row, the rest of its values that come before the next-best
+// head are found by exponential search, in about 2 * log2(m) comparisons
+// for m values, and copied as one block, with one replay for the lot.  For
+// clustered data, such as time-partitioned logs, where each array supplies
+// long stretches of the output; on interleaved data it costs one test per
+// element over multimerge_lt.
+
+void multimerge_gallop(const IntVectorVector &arrays, IntVector *poutput);
+void multimerge_gallop(const FlatRuns &runs, IntVector *poutput);
+
+// Fenced multimerge.  Same contract as multimerge_lt, and the same output
+// when method is kLoserTree or kGalloping.  Each element of arrays is first
+// reduced to its fences, its first and last values, and a sweep of the
+// sorted fences finds the windows of values that two or more elements
+// cover.  The parts of elements outside every window, whole elements that
+// overlap no other, such as daily files, are copied as blocks; only the
+// windows are merged, by method.  If pstats is not null, *pstats is set to
+// the numbers of values copied and merged and of windows.
+
+void multimerge_fenced(const IntVectorVector &arrays, IntVector *poutput,
+                       MergeMethod method, FenceStats *pstats);
+void multimerge_fenced(const FlatRuns &runs, IntVector *poutput,
+                       MergeMethod method, FenceStats *pstats);
+
+// Pull-based priority queue multimerge: MergeCursor cursor(arrays), then
+// cursor.next_batch(buffer, n) repeatedly writes up to n more elements of the
+// sorted output to buffer[0], ... and returns how many, 0 when all are done.
+// The heap persists between calls, so the output need never be held whole.
+// arrays must outlive the cursor and not change while it is used.
+
+typedef BasicMergeCursor<IntVectorConstIterator, int> MergeCursor;
+typedef BasicMergeCursor<const int *, int>             FlatMergeCursor;
+
+// Reusable storage for repeated merges: the iterators, heap, and loser tree
+// the methods above allocate on every call.  Used with the multimerge
+// overload below, so that repeated merges, such as many small ones, perform
+// no allocation once the context has grown to the largest number of arrays
+// merged, or after reserve(nr_arrays).  One context per thread.
+
+typedef BasicMergeContext<IntVectorConstIterator, int> MergeContext;
+typedef BasicMergeContext<const int *, int>             FlatMergeContext;
+
+// Multimerge by method into output[0], ..., output[output_size - 1], a buffer
+// supplied by the caller, using the storage in *pcontext.  Each element of
+// arrays must be a sorted vector of int.  Returns false, writing nothing, if
+// output_size is less than the total length of arrays.
+
+bool multimerge(const IntVectorVector &arrays, int *output,
+                size_t output_size, MergeContext *pcontext,
+                MergeMethod method = kLoserTree);
+bool multimerge(const FlatRuns &runs, int *output, size_t output_size,
+                FlatMergeContext *pcontext, MergeMethod method = kLoserTree);
+
+// Parallel multimerge.  Each element of arrays must be a sorted vector of int.
+// On return, *poutput will be a sorted vector containing all the values in all
+// the elements of arrays, in the same order as from multimerge_lt.  The output
+// is split into nr_threads equal parts (nr_threads <= 0 means one per hardware
+// thread); co-ranking by binary search finds the slice of each element of
+// arrays that belongs in each part, and one thread per part merges its slices
+// by method, which must be kPriorityQueue, kLoserTree, or kGalloping.
+
+void multimerge_par(const IntVectorVector &arrays, IntVector *poutput,
+                    int nr_threads, MergeMethod method);
+void multimerge_par(const FlatRuns &runs, IntVector *poutput,
+                    int nr_threads, MergeMethod method);
+
+// Fused multimerge: each value of the merge of arrays by method, in the
+// order multimerge_lt gives, is handed to (*psink)(value) as it is merged,
+// and none is stored, for reductions of the output such as the counts
+// below.  multimerge_par_sink merges on nr_threads threads as does
+// multimerge_par, the first part into *psink and each other into its own
+// copy of *psink emptied by copy.clear(), the copies then joined in order
+// by psink->join(copy); a sink already handed values ends as if handed the
+// merge after them.  Sinks are function objects; see SinkIterator in
+// cc/mmergetemplate.h.
+
+typedef BasicDistinctCount<int> DistinctCount;  // number of distinct values
+typedef BasicGroupCount<int>    GroupCount;     // each value and its count
+typedef BasicHistogram<int>     Histogram;      // counts in fixed buckets
+
+template <typename Sink>
+void multimerge_sink(const IntVectorVector &arrays, Sink *psink,
+                     MergeMethod method = kLoserTree) {
+  multimerge_sink<int>(arrays, psink, method);
+}
+template <typename Sink>
+void multimerge_sink(const FlatRuns &runs, Sink *psink,
+                     MergeMethod method = kLoserTree) {
+  multimerge_sink<int>(runs, psink, method);
+}
+
+template <typename Sink>
+void multimerge_par_sink(const IntVectorVector &arrays, Sink *psink,
+                         int nr_threads, MergeMethod method = kLoserTree) {
+  multimerge_par_sink<int>(arrays, psink, nr_threads, method);
+}
+template <typename Sink>
+void multimerge_par_sink(const FlatRuns &runs, Sink *psink, int nr_threads,
+                         MergeMethod method = kLoserTree) {
+  multimerge_par_sink<int>(runs, psink, nr_threads, method);
+}
+
+// The linear, priority queue, loser tree, and parallel methods for 64-bit
+// keys, signed and unsigned, with the same contracts as for int.  Lengths
+// and counts are size_t throughout, for int keys as well, so that a merge
+// may hold more than 2^31 elements.  A 64-bit key doubles the bytes read and
+// written per element, and the loser tree nodes are no larger, since each
+// already pads its key to the size_t beside it.
+
+void multimerge(const Int64VectorVector &arrays, Int64Vector *poutput);
+void multimerge_pq(const Int64VectorVector &arrays, Int64Vector *poutput);
+void multimerge_lt(const Int64VectorVector &arrays, Int64Vector *poutput);
+void multimerge_par(const Int64VectorVector &arrays, Int64Vector *poutput,
+                    int nr_threads, MergeMethod method);
+void multimerge(const Int64FlatRuns &runs, Int64Vector *poutput);
+void multimerge_pq(const Int64FlatRuns &runs, Int64Vector *poutput);
+void multimerge_lt(const Int64FlatRuns &runs, Int64Vector *poutput);
+void multimerge_par(const Int64FlatRuns &runs, Int64Vector *poutput,
+                    int nr_threads, MergeMethod method);
+
+void multimerge(const UInt64VectorVector &arrays, UInt64Vector *poutput);
+void multimerge_pq(const UInt64VectorVector &arrays, UInt64Vector *poutput);
+void multimerge_lt(const UInt64VectorVector &arrays, UInt64Vector *poutput);
+void multimerge_par(const UInt64VectorVector &arrays, UInt64Vector *poutput,
+                    int nr_threads, MergeMethod method);
+void multimerge(const UInt64FlatRuns &runs, UInt64Vector *poutput);
+void multimerge_pq(const UInt64FlatRuns &runs, UInt64Vector *poutput);
+void multimerge_lt(const UInt64FlatRuns &runs, UInt64Vector *poutput);
+void multimerge_par(const UInt64FlatRuns &runs, UInt64Vector *poutput,
+                    int nr_threads, MergeMethod method);
 
 }  // namespace com_zulazon_samples_cc_mmerge
 
@@ -0,0 +1,252 @@
+// cc/mmergeauto.cc rev. 17 October 2026 by Stuart Ambler.
+// Automatic choice of merge method.  See cc/mmergeauto.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergeauto.h"
+
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+static const char *const kEngineNames[kNrMergeEngines] = {
+  "lin", "simd", "pq", "lt"
+};
+
+// Calibration points, and the largest k at which the linear method, which
+// would take longest there, is measured.
+
+static const int kCalibrationKs[] = { 2, 4, 8, 16, 32, 64, 128, 256, 1024 };
+static const int kMaxLinearCalibrationK = 128;
+
+const char *merge_engine_name(MergeEngine engine) {
+  return kEngineNames[engine];
+}
+
+void multimerge_engine(MergeEngine engine, const IntVectorVector &arrays,
+                       IntVector *poutput) {
+  switch (engine) {
+    case kEngineLinear:
+      multimerge(arrays, poutput);
+      break;
+    case kEngineSimd:
+      multimerge_simd(arrays, poutput);
+      break;
+    case kEnginePriorityQueue:
+      multimerge_pq(arrays, poutput);
+      break;
+    default:
+      multimerge_lt(arrays, poutput);
+      break;
+  }
+}
+
+// Whether the cost of engine grows as k, rather than as log2(k).
+
+static bool is_linear_engine(MergeEngine engine) {
+  return engine == kEngineLinear || engine == kEngineSimd;
+}
+
+void MergeCalibration::calibrate(size_t nr_ints) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> dist(0, INT_MAX - 1);
+  rows_.clear();
+  for (size_t r = 0; r < sizeof(kCalibrationKs) / sizeof(kCalibrationKs[0]);
+       ++r) {
+    int k = kCalibrationKs[r];
+    IntVectorVector arrays(k, IntVector(std::max<size_t>(nr_ints / k, 1)));
+    for (int i = 0; i < k; ++i) {
+      std::generate(arrays[i].begin(), arrays[i].end(),
+                    [&]() { return dist(gen); });
+      std::sort(arrays[i].begin(), arrays[i].end());
+    }
+    size_t n = total_length(arrays);
+
+    CalibrationRow row;
+    row.k = k;
+    IntVector output;
+    for (int e = 0; e < kNrMergeEngines; ++e) {
+      MergeEngine engine = static_cast<MergeEngine>(e);
+      row.ns_per_int[e] = -1.0;
+      if (   (engine == kEngineLinear && k > kMaxLinearCalibrationK)
+          || (engine == kEngineSimd   && k > kMaxSimdInputs))
+        continue;
+      for (int trial = 0; trial < 3; ++trial) {
+        auto start = std::chrono::steady_clock::now();
+        multimerge_engine(engine, arrays, &output);
+        double ns  = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start).count()
+                     / n;
+        if (row.ns_per_int[e] < 0.0 || ns < row.ns_per_int[e])
+          row.ns_per_int[e] = ns;
+      }
+    }
+    rows_.push_back(row);
+  }
+}
+
+bool MergeCalibration::load(const std::string &path,
+                            std::string *perror_msg) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    *perror_msg = "Unable to open calibration file " + path;
+    return false;
+  }
+  std::vector<CalibrationRow> rows;
+  bool        have_header = false;
+  std::string line;
+  for (int line_nr = 1; std::getline(in, line); ++line_nr) {
+    std::istringstream fields(line);
+    std::string        field;
+    if (!(fields >> field) || field[0] == '#')
+      continue;
+    std::string where = "Calibration file " + path + " line "
+                        + std::to_string(line_nr) + ": ";
+    if (!have_header) {
+      bool ok = (field == "k");
+      for (int e = 0; ok && e < kNrMergeEngines; ++e)
+        ok = (fields >> field) && field == kEngineNames[e];
+      if (!ok || (fields >> field)) {
+        *perror_msg = where + "expected header \"k lin simd pq lt\"";
+        return false;
+      }
+      have_header = true;
+      continue;
+    }
+    CalibrationRow row;
+    char *end;
+    row.k = strtol(field.c_str(), &end, 10);
+    bool ok = (*end == '\0' && row.k >= 1
+               && (rows.empty() || row.k > rows.back().k));
+    for (int e = 0; ok && e < kNrMergeEngines; ++e) {
+      ok = static_cast<bool>(fields >> field);
+      if (ok && field == "NA") {
+        row.ns_per_int[e] = -1.0;
+      } else if (ok) {
+        row.ns_per_int[e] = strtod(field.c_str(), &end);
+        ok = (*end == '\0' && row.ns_per_int[e] >= 0.0);
+      }
+    }
+    if (!ok || (fields >> field)) {
+      *perror_msg = where + "expected k, increasing, then "
+                    + std::to_string(kNrMergeEngines)
+                    + " nanosecond figures or NA";
+      return false;
+    }
+    rows.push_back(row);
+  }
+  if (rows.empty()) {
+    *perror_msg = "Calibration file " + path + " has no rows";
+    return false;
+  }
+  rows_.swap(rows);
+  return true;
+}
+
+bool MergeCalibration::save(const std::string &path,
+                            std::string *perror_msg) const {
+  std::ofstream out(path.c_str());
+  out << "# multimerge_auto calibration, nanoseconds per output element\n"
+      << "k";
+  for (int e = 0; e < kNrMergeEngines; ++e)
+    out << " " << kEngineNames[e];
+  out << "\n";
+  for (size_t r = 0; r < rows_.size(); ++r) {
+    out << rows_[r].k;
+    for (int e = 0; e < kNrMergeEngines; ++e) {
+      if (rows_[r].ns_per_int[e] < 0.0)
+        out << " NA";
+      else
+        out << " " << rows_[r].ns_per_int[e];
+    }
+    out << "\n";
+  }
+  out.close();
+  if (!out) {
+    *perror_msg = "Unable to write calibration file " + path;
+    return false;
+  }
+  return true;
+}
+
+double MergeCalibration::estimate_ns(MergeEngine engine, double k) const {
+  const CalibrationRow *below = nullptr;
+  for (size_t r = 0; r < rows_.size(); ++r) {
+    const CalibrationRow &row = rows_[r];
+    if (row.ns_per_int[engine] < 0.0)
+      continue;
+    if (row.k >= k) {
+      if (below == nullptr || row.k == k)
+        return row.ns_per_int[engine];
+      double t = (std::log2(k) - std::log2(below->k))
+                 / (std::log2(row.k) - std::log2(below->k));
+      return   (1.0 - t) * below->ns_per_int[engine]
+             + t * row.ns_per_int[engine];
+    }
+    below = &row;
+  }
+  if (below == nullptr)
+    return HUGE_VAL;
+  if (is_linear_engine(engine))
+    return below->ns_per_int[engine] * k / below->k;
+  return below->k > 1
+         ? below->ns_per_int[engine] * std::log2(k) / std::log2(below->k)
+         : below->ns_per_int[engine];
+}
+
+double effective_nr_inputs(const IntVectorVector &arrays) {
+  double n = static_cast<double>(total_length(arrays));
+  double entropy = 0.0;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    if (!arrays[i].empty()) {
+      double p = arrays[i].size() / n;
+      entropy -= p * std::log2(p);
+    }
+  }
+  return n > 0.0 ? std::exp2(entropy) : 0.0;
+}
+
+MergeEngine choose_merge_engine(const IntVectorVector &arrays,
+                                const MergeCalibration &calibration,
+                                double *pestimate_sec) {
+  int nr_nonempty = 0;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    if (!arrays[i].empty())
+      ++nr_nonempty;
+  }
+  double      k_eff = effective_nr_inputs(arrays);
+  MergeEngine best  = kEngineLoserTree;
+  double      best_ns = HUGE_VAL;
+  for (int e = 0; e < kNrMergeEngines; ++e) {
+    MergeEngine engine = static_cast<MergeEngine>(e);
+    if (engine == kEngineSimd && nr_nonempty > kMaxSimdInputs)
+      continue;
+    // multimerge_simd leaves empty arrays out, but the scalar linear method
+    // scans every array, empty or not.
+    double k = engine == kEngineSimd   ? nr_nonempty
+               : engine == kEngineLinear ? static_cast<double>(arrays.size())
+                                         : k_eff;
+    double ns = calibration.estimate_ns(engine, k);
+    if (ns < best_ns) {
+      best    = engine;
+      best_ns = ns;
+    }
+  }
+  if (pestimate_sec != nullptr) {
+    *pestimate_sec = best_ns < HUGE_VAL
+                     ? best_ns * 1.0e-9 * total_length(arrays) : 0.0;
+  }
+  return best;
+}
+
+MergeEngine multimerge_auto(const IntVectorVector &arrays, IntVector *poutput,
+                            const MergeCalibration &calibration) {
+  MergeEngine engine = choose_merge_engine(arrays, calibration, nullptr);
+  multimerge_engine(engine, arrays, poutput);
+  return engine;
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
@@ -0,0 +1,116 @@
+// cc/mmergeauto.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergeauto.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Automatic choice among the single-threaded merge methods of cc/mmerge.h,
+// from a calibration table of measured nanoseconds per output element at a
+// few values of k.  The table is made by a small built-in calibration run on
+// the machine at hand and may be saved to and loaded from a text file, so
+// the run need not be repeated.
+//
+// The cost model: the time of a method is n times its table entry at some k,
+// interpolated between rows in log2(k) and extrapolated past the last
+// measured row as k for the linear methods and log2(k) for the others.  The
+// linear methods look at every head for every element, so for them k is the
+// number of heads: every run for the scalar method, and the nonempty runs
+// for the SIMD method, which leaves the empty ones out.  For the priority
+// queue and loser tree it is the effective k, 2 to the power of the entropy
+// in bits of the run lengths, len[i] / n: k itself when the lengths are
+// equal, near 1 when one run holds nearly everything, which is when the
+// same run keeps winning and branches are well predicted.  The SIMD method
+// is a candidate only for at most kMaxSimdInputs nonempty runs.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEAUTO_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEAUTO_H_
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include "./mmerge.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// The methods multimerge_auto chooses among, in the column order of the
+// calibration table.
+
+enum MergeEngine {
+  kEngineLinear,
+  kEngineSimd,
+  kEnginePriorityQueue,
+  kEngineLoserTree,
+  kNrMergeEngines
+};
+
+// Short name of engine, as in the calibration file and testmmerge output:
+// lin, simd, pq, or lt.
+
+const char *merge_engine_name(MergeEngine engine);
+
+// Merges arrays into *poutput by engine.
+
+void multimerge_engine(MergeEngine engine, const IntVectorVector &arrays,
+                       IntVector *poutput);
+
+// One row of the calibration table: nanoseconds per output element for each
+// engine at k equal-length runs, negative where not measured.
+
+struct CalibrationRow {
+  int    k;
+  double ns_per_int[kNrMergeEngines];
+};
+
+// The calibration table.  The file format is text: lines starting with # are
+// comments; the first other line is the header "k lin simd pq lt", and each
+// line after it a row, k then the four entries, NA where not measured.
+
+class MergeCalibration {
+ public:
+  MergeCalibration() {}
+  // A table of the given rows, in increasing order of k.
+  explicit MergeCalibration(const std::vector<CalibrationRow> &rows)
+      : rows_(rows) {}
+
+  // Replaces the table by measurements of every engine at k = 2, 4, 8, ...,
+  // 256, and 1024, merging about nr_ints random ints in equal-length runs,
+  // best of three times each.  The linear method is measured only up to
+  // k = 128 and the SIMD method only up to kMaxSimdInputs.
+  void calibrate(size_t nr_ints);
+
+  // Return false on error, with a message in *perror_msg.
+  bool load(const std::string &path, std::string *perror_msg);
+  bool save(const std::string &path, std::string *perror_msg) const;
+
+  // Estimated nanoseconds per output element for engine at effective k, or
+  // HUGE_VAL if the table has no entry for engine.
+  double estimate_ns(MergeEngine engine, double k) const;
+
+  const std::vector<CalibrationRow> &rows() const { return rows_; }
+
+ private:
+  std::vector<CalibrationRow> rows_;
+};
+
+// Effective number of runs: 2 to the power of the entropy of the run lengths;
+// 0 if all are empty.
+
+double effective_nr_inputs(const IntVectorVector &arrays);
+
+// The engine with the least estimated time for arrays.  If pestimate_sec is
+// not null, *pestimate_sec is set to that time in seconds.
+
+MergeEngine choose_merge_engine(const IntVectorVector &arrays,
+                                const MergeCalibration &calibration,
+                                double *pestimate_sec);
+
+// Multimerge by the engine choose_merge_engine picks; returns that engine.
+// Same contract otherwise as multimerge.
+
+MergeEngine multimerge_auto(const IntVectorVector &arrays, IntVector *poutput,
+                            const MergeCalibration &calibration);
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEAUTO_H_
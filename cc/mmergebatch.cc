@@ -0,0 +1,99 @@
+// cc/mmergebatch.cc rev. 17 October 2026 by Stuart Ambler.
+// Batches of independent merges on a thread pool.  See cc/mmergebatch.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergebatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+void multimerge_batch(const std::vector<const IntVectorVector *> &jobs,
+                      WorkStealingPool *ppool, MergeMethod method,
+                      BatchOutput *poutput, BatchStats *pstats) {
+  size_t nr_jobs = jobs.size();
+  size_t steals_start = ppool->nr_steals();
+  if (method == kLinear)
+    method = kLoserTree;
+  auto start = std::chrono::steady_clock::now();
+
+  // The arena, with each job's offset in the order given.
+  std::vector<size_t> &offsets = poutput->offsets;
+  offsets.resize(nr_jobs + 1);
+  offsets[0] = 0;
+  for (size_t j = 0; j < nr_jobs; ++j) {
+    size_t n = 0;
+    for (size_t i = 0; i < jobs[j]->size(); ++i)
+      n += (*jobs[j])[i].size();
+    offsets[j + 1] = offsets[j] + n;
+  }
+  poutput->arena.resize(offsets[nr_jobs]);
+  if (pstats != nullptr)
+    pstats->job_sec.assign(nr_jobs, 0.0);
+
+  // The jobs by size, largest first, cut into tasks of about
+  // kBatchTaskValues values.
+  std::vector<size_t> order(nr_jobs);
+  for (size_t j = 0; j < nr_jobs; ++j)
+    order[j] = j;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return offsets[a + 1] - offsets[a] > offsets[b + 1] - offsets[b];
+  });
+  std::vector<size_t> task_starts;
+  size_t task_values = kBatchTaskValues;
+  for (size_t o = 0; o < nr_jobs; ++o) {
+    if (task_values >= kBatchTaskValues) {
+      task_starts.push_back(o);
+      task_values = 0;
+    }
+    task_values += offsets[order[o] + 1] - offsets[order[o]];
+  }
+  task_starts.push_back(nr_jobs);
+
+  int *arena = poutput->arena.data();
+  for (size_t t = 0; t + 1 < task_starts.size(); ++t) {
+    size_t first = task_starts[t];
+    size_t last  = task_starts[t + 1];
+    ppool->submit([&, first, last, arena]() {
+      // Reused by the task's jobs, which are of about the same k.
+      std::vector<const int *> its;
+      std::vector<const int *> ends;
+      for (size_t o = first; o < last; ++o) {
+        size_t j = order[o];
+        size_t n = offsets[j + 1] - offsets[j];
+        if (n > 0) {
+          its.clear();
+          ends.clear();
+          const IntVectorVector &arrays = *jobs[j];
+          for (size_t i = 0; i < arrays.size(); ++i) {
+            its.push_back(arrays[i].data());
+            ends.push_back(arrays[i].data() + arrays[i].size());
+          }
+          internal::merge_ranges<int>(&its, ends, n, arena + offsets[j],
+                                      method, std::less<int>(),
+                                      KeyOfValue<int, int>());
+        }
+        if (pstats != nullptr)
+          pstats->job_sec[j] = std::chrono::duration<double>(
+              std::chrono::steady_clock::now() - start).count();
+      }
+    });
+  }
+  ppool->wait();
+
+  if (pstats != nullptr) {
+    pstats->nr_tasks  = task_starts.size() - 1;
+    pstats->nr_steals = ppool->nr_steals() - steals_start;
+  }
+}
+
+void multimerge_batch(const std::vector<const IntVectorVector *> &jobs,
+                      BatchOutput *poutput, int nr_threads) {
+  WorkStealingPool pool(nr_threads);
+  multimerge_batch(jobs, &pool, kLoserTree, poutput, nullptr);
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
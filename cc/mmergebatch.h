@@ -0,0 +1,65 @@
+// cc/mmergebatch.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergebatch.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Batches of many independent small merges, such as the merges of a few
+// dozen short lists that request handlers each need, run together on a
+// WorkStealingPool.  One merge per call, one call at a time, leaves the
+// other cores idle and pays for an output vector per merge; a batch is
+// merged into one arena, each job's output at its own offset, so the
+// outputs are allocated once.  The jobs are grouped by size, largest first,
+// into tasks of about kBatchTaskValues values, so that tasks are few enough
+// for the pool's overhead not to matter and each holds jobs of similar
+// cost; workers that run out of tasks steal the rest.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEBATCH_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEBATCH_H_
+
+#include <cstddef>
+
+#include <vector>
+
+#include "./mmerge.h"
+#include "./mmergepool.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Values merged by one task of a batch, about; a job larger than this is a
+// task of its own.
+
+const size_t kBatchTaskValues = 1 << 14;
+
+// The outputs of a batch: job j's merge is arena[offsets[j]], ... up to
+// arena[offsets[j + 1]], in the order the jobs were given.
+
+struct BatchOutput {
+  IntVector           arena;
+  std::vector<size_t> offsets;  // one more than the number of jobs
+};
+
+struct BatchStats {
+  size_t              nr_tasks;
+  size_t              nr_steals;  // tasks stolen by another worker
+  // Seconds from the start of the batch until each job's output was
+  // written, by job, for the latency a job sees.
+  std::vector<double> job_sec;
+};
+
+// Merges each job, the arrays *jobs[j], into *poutput, on the threads of
+// *ppool, by method, which must be kPriorityQueue, kLoserTree, or
+// kGalloping.  If pstats is not null, sets *pstats.
+
+void multimerge_batch(const std::vector<const IntVectorVector *> &jobs,
+                      WorkStealingPool *ppool, MergeMethod method,
+                      BatchOutput *poutput, BatchStats *pstats);
+
+// The same on a pool of nr_threads threads made for the call (nr_threads
+// <= 0 means one per hardware thread), by loser tree.
+
+void multimerge_batch(const std::vector<const IntVectorVector *> &jobs,
+                      BatchOutput *poutput, int nr_threads = 0);
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEBATCH_H_
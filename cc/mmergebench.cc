@@ -0,0 +1,251 @@
+// cc/mmergebench.cc rev. 17 October 2026 by Stuart Ambler.
+// Benchmark harness.  See cc/mmergebench.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergebench.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Two-sided 95% quantiles of Student's t distribution for 1 through 30
+// degrees of freedom; the normal quantile beyond.
+
+static const double kStudentT95[] = {
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+static const double kNormal95 = 1.960;
+
+static double student_t95(size_t degrees_of_freedom) {
+  size_t nr = sizeof(kStudentT95) / sizeof(kStudentT95[0]);
+  return degrees_of_freedom <= nr ? kStudentT95[degrees_of_freedom - 1]
+                                  : kNormal95;
+}
+
+BenchmarkResult run_benchmark(const std::string &name, size_t nr_elements,
+                              size_t nr_bytes, const BenchmarkCfg &cfg,
+                              const std::function<void()> &body) {
+  BenchmarkResult result;
+  result.name        = name;
+  result.ok          = true;
+  result.nr_elements = nr_elements;
+  result.nr_bytes    = nr_bytes;
+
+  double totals[kNrPerfCounters];
+  for (int c = 0; c < kNrPerfCounters; ++c)
+    totals[c] = 0.0;
+
+  for (int i = 0; i < cfg.nr_warmups; ++i)
+    body();
+  for (int i = 0; i < cfg.nr_trials; ++i) {
+    if (cfg.pcounters != nullptr)
+      cfg.pcounters->start();
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto stop  = std::chrono::steady_clock::now();
+    if (cfg.pcounters != nullptr) {
+      double counts[kNrPerfCounters];
+      cfg.pcounters->stop(counts);
+      for (int c = 0; c < kNrPerfCounters; ++c)
+        totals[c] = (counts[c] < 0.0 || totals[c] < 0.0) ? -1.0
+                    : totals[c] + counts[c];
+    }
+    result.trial_secs.push_back(
+        std::chrono::duration<double>(stop - start).count());
+  }
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    result.per_element[c] =
+        (cfg.pcounters == nullptr || totals[c] < 0.0) ? -1.0
+        : totals[c] / cfg.nr_trials / std::max<size_t>(nr_elements, 1);
+  }
+
+  std::vector<double> sorted(result.trial_secs);
+  std::sort(sorted.begin(), sorted.end());
+  size_t nr  = sorted.size();
+  result.median_sec = (nr % 2 == 1) ? sorted[nr / 2]
+                      : (sorted[nr / 2 - 1] + sorted[nr / 2]) / 2.0;
+  result.p95_sec    = sorted[static_cast<size_t>(std::ceil(0.95 * nr)) - 1];
+
+  double sum = 0.0;
+  for (size_t i = 0; i < nr; ++i)
+    sum += sorted[i];
+  result.mean_sec = sum / nr;
+  double half_width = 0.0;
+  if (nr > 1) {
+    double sum_sq_dev = 0.0;
+    for (size_t i = 0; i < nr; ++i) {
+      double dev = sorted[i] - result.mean_sec;
+      sum_sq_dev += dev * dev;
+    }
+    half_width = student_t95(nr - 1) * std::sqrt(sum_sq_dev / (nr - 1) / nr);
+  }
+  result.ci_low_sec  = result.mean_sec - half_width;
+  result.ci_high_sec = result.mean_sec + half_width;
+
+  result.elements_per_sec = result.median_sec > 0.0
+                            ? nr_elements / result.median_sec : 0.0;
+  result.bytes_per_sec    = result.median_sec > 0.0
+                            ? nr_bytes / result.median_sec : 0.0;
+  return result;
+}
+
+const BenchmarkResult *BenchmarkReport::find(const std::string &name) const {
+  for (size_t i = 0; i < results_.size(); ++i) {
+    if (results_[i].name == name)
+      return &results_[i];
+  }
+  return nullptr;
+}
+
+// Whether result has any hardware counts.
+
+static bool has_counts(const BenchmarkResult &result) {
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    if (result.per_element[c] >= 0.0)
+      return true;
+  }
+  return false;
+}
+
+void BenchmarkReport::print(const BenchmarkResult &result, std::ostream &out) {
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize         precision = out.precision();
+  out.setf(std::ios_base::fixed, std::ios_base::floatfield);
+  out.precision(4);
+  out << "benchmark " << result.name << " median " << result.median_sec
+      << " sec, p95 " << result.p95_sec << " sec, mean " << result.mean_sec
+      << " sec, 95% CI [" << result.ci_low_sec << ", " << result.ci_high_sec
+      << "], " << result.trial_secs.size() << " trials" << std::endl;
+  out.precision(2);
+  out << "benchmark " << result.name << " "
+      << result.elements_per_sec / 1.0e6 << " M elements/s, "
+      << result.bytes_per_sec / 1.0e6 << " MB/s" << std::endl;
+  if (has_counts(result)) {
+    out.precision(3);
+    out << "benchmark " << result.name << " per element";
+    const char *sep = " ";
+    for (int c = 0; c < kNrPerfCounters; ++c) {
+      if (result.per_element[c] >= 0.0) {
+        out << sep << perf_counter_name(static_cast<PerfCounter>(c)) << " "
+            << result.per_element[c];
+        sep = ", ";
+      }
+    }
+    out << std::endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+// A string as a JSON string literal.  Names here are plain ASCII, but quotes,
+// backslashes, and control characters are escaped all the same.
+
+static std::string json_string(const std::string &s) {
+  std::string quoted("\"");
+  for (size_t i = 0; i < s.size(); ++i) {
+    unsigned char c = s[i];
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (c < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      quoted += escape;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+// A double as a JSON number; JSON has no infinities or NaN, so null for
+// those.
+
+static std::string json_number(double x) {
+  if (!std::isfinite(x))
+    return "null";
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.9g", x);
+  return buf;
+}
+
+void BenchmarkReport::set(const std::string &key, double value) {
+  set_json(key, json_number(value));
+}
+
+void BenchmarkReport::set(const std::string &key, const std::string &value) {
+  set_json(key, json_string(value));
+}
+
+void BenchmarkReport::set_json(const std::string &key,
+                               const std::string &json_value) {
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].first == key) {
+      fields_[i].second = json_value;
+      return;
+    }
+  }
+  fields_.push_back(std::make_pair(key, json_value));
+}
+
+void BenchmarkReport::write_json(std::ostream &out) const {
+  out << "{";
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    out << "\n  " << json_string(fields_[i].first) << ": "
+        << fields_[i].second << ",";
+  }
+  out << "\n  \"results\": [";
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const BenchmarkResult &r = results_[i];
+    out << (i > 0 ? "," : "") << "\n    {"
+        << "\"name\": " << json_string(r.name)
+        << ", \"ok\": " << (r.ok ? "true" : "false")
+        << ", \"elements\": " << r.nr_elements
+        << ", \"bytes\": " << r.nr_bytes
+        << ",\n     \"trial_sec\": [";
+    for (size_t j = 0; j < r.trial_secs.size(); ++j)
+      out << (j > 0 ? ", " : "") << json_number(r.trial_secs[j]);
+    out << "]"
+        << ",\n     \"median_sec\": " << json_number(r.median_sec)
+        << ", \"p95_sec\": " << json_number(r.p95_sec)
+        << ", \"mean_sec\": " << json_number(r.mean_sec)
+        << ", \"ci95_low_sec\": " << json_number(r.ci_low_sec)
+        << ", \"ci95_high_sec\": " << json_number(r.ci_high_sec)
+        << ",\n     \"elements_per_sec\": " << json_number(r.elements_per_sec)
+        << ", \"bytes_per_sec\": " << json_number(r.bytes_per_sec);
+    if (has_counts(r)) {
+      out << ",\n     \"per_element\": {";
+      for (int c = 0; c < kNrPerfCounters; ++c) {
+        out << (c > 0 ? ", " : "")
+            << json_string(perf_counter_name(static_cast<PerfCounter>(c)))
+            << ": " << (r.per_element[c] >= 0.0
+                        ? json_number(r.per_element[c]) : "null");
+      }
+      out << "}";
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+bool BenchmarkReport::write_json(const std::string &path,
+                                 std::string *perror_msg) const {
+  std::ofstream out(path.c_str());
+  write_json(out);
+  out.close();
+  if (!out) {
+    *perror_msg = "Unable to write benchmark JSON file " + path;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
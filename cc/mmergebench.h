@@ -0,0 +1,97 @@
+// cc/mmergebench.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergebench.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Benchmark harness for the merge tests: runs a body of code some warmup
+// times untimed, then some trial times each timed by std::chrono::
+// steady_clock wall time, and summarizes the trials by median, 95th
+// percentile, mean with a 95% confidence interval (Student's t), and
+// elements and bytes per second at the median, and optionally the hardware
+// counts per element of cc/mmergeperf.h.  Results are collected in a
+// report that prints a line of text per result and writes the whole as JSON
+// for common/runtests.py and common/analyze.R.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEBENCH_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEBENCH_H_
+
+#include <cstddef>
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./mmergeperf.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// How many times to run a body of code: nr_warmups untimed, then nr_trials,
+// which must be positive, timed, and counted by *pcounters if that is not
+// null.
+
+struct BenchmarkCfg {
+  int           nr_warmups;
+  int           nr_trials;
+  PerfCounters *pcounters;
+};
+
+// Timings of one body of code.  nr_elements and nr_bytes are those processed
+// by one run, for the rates.  ok is for the caller to record whether the
+// output was correct.
+
+struct BenchmarkResult {
+  std::string         name;
+  bool                ok;
+  size_t              nr_elements;
+  size_t              nr_bytes;
+  std::vector<double> trial_secs;
+  double              median_sec;
+  double              p95_sec;
+  double              mean_sec;
+  double              ci_low_sec;   // 95% confidence interval for the mean;
+  double              ci_high_sec;  // the mean itself if only one trial
+  double              elements_per_sec;
+  double              bytes_per_sec;
+  // Mean count per element over the trials of each hardware counter,
+  // negative where not counted.
+  double              per_element[kNrPerfCounters];
+};
+
+// Runs body per cfg and returns its timings, with ok true.
+
+BenchmarkResult run_benchmark(const std::string &name, size_t nr_elements,
+                              size_t nr_bytes, const BenchmarkCfg &cfg,
+                              const std::function<void()> &body);
+
+// Results of a test program run, with fields describing the run, such as k
+// and n, in the order set.
+
+class BenchmarkReport {
+ public:
+  void set(const std::string &key, double value);
+  void set(const std::string &key, const std::string &value);
+  void add(const BenchmarkResult &result) { results_.push_back(result); }
+
+  // The result named name, or null if none.
+  const BenchmarkResult *find(const std::string &name) const;
+
+  // Prints lines of text for result.
+  static void print(const BenchmarkResult &result, std::ostream &out);
+
+  void write_json(std::ostream &out) const;
+  // Returns false on error, with a message in *perror_msg.
+  bool write_json(const std::string &path, std::string *perror_msg) const;
+
+ private:
+  // Keys and values as JSON text.
+  void set_json(const std::string &key, const std::string &json_value);
+
+  std::vector<std::pair<std::string, std::string> > fields_;
+  std::vector<BenchmarkResult>                       results_;
+};
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEBENCH_H_
@@ -0,0 +1,339 @@
+// cc/mmergeext.cc rev. 17 October 2026 by Stuart Ambler.
+// External memory merge of sorted run files.  See cc/mmergeext.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergeext.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <future>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+typedef internal::PriorityQueueMerger<const int *, std::less<int>,
+                                      KeyOfValue<int, int> > IntPointerMerger;
+
+// Message for a failed system call on a file.
+
+static std::string file_error(const char *what, const std::string &path) {
+  return std::string(what) + " " + path + ": " + strerror(errno);
+}
+
+// Reads into buf up to nr_bytes bytes, fewer only at end of file; returns the
+// number read, or -1 on error.
+
+static ssize_t read_fully(int fd, char *buf, size_t nr_bytes,
+                          size_t *pnr_reads) {
+  size_t done = 0;
+  while (done < nr_bytes) {
+    ssize_t nr = read(fd, buf + done, nr_bytes - done);
+    ++*pnr_reads;
+    if (nr < 0 && errno == EINTR)
+      continue;
+    if (nr < 0)
+      return -1;
+    if (nr == 0)
+      break;
+    done += nr;
+  }
+  return done;
+}
+
+// Writes nr_bytes bytes from buf; returns false on error.
+
+static bool write_fully(int fd, const char *buf, size_t nr_bytes,
+                        size_t *pnr_writes) {
+  while (nr_bytes > 0) {
+    ssize_t nr = write(fd, buf, nr_bytes);
+    ++*pnr_writes;
+    if (nr < 0 && errno == EINTR)
+      continue;
+    if (nr < 0)
+      return false;
+    buf      += nr;
+    nr_bytes -= nr;
+  }
+  return true;
+}
+
+// Buffered reader of a run file.  Each refill reads the next buffer's worth
+// and asks the kernel to start reading the buffer after it (read-ahead), so
+// that by the time the merge has consumed this buffer the next is in the
+// page cache.
+
+class RunReader {
+ public:
+  RunReader() : fd_(-1), offset_(0), at_eof_(false) {}
+  RunReader(const RunReader &) = delete;
+  RunReader & operator= (const RunReader &) = delete;
+  ~RunReader() {
+    if (fd_ >= 0)
+      close(fd_);
+  }
+
+  bool open_run(const std::string &path, size_t buffer_ints,
+                std::string *perror_msg) {
+    path_ = path;
+    fd_   = open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      *perror_msg = file_error("Unable to open run file", path);
+      return false;
+    }
+    (void) posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    buffer_.resize(buffer_ints);
+    begin_ = end_ = buffer_.data();
+    return true;
+  }
+
+  // Replaces the buffer contents, which must all have been consumed, by the
+  // next part of the file.
+  bool refill(size_t *pnr_reads, std::string *perror_msg) {
+    size_t  nr_bytes = buffer_.size() * sizeof(int);
+    (void) posix_fadvise(fd_, offset_ + nr_bytes, nr_bytes,
+                         POSIX_FADV_WILLNEED);
+    ssize_t nr = read_fully(fd_, reinterpret_cast<char *>(buffer_.data()),
+                            nr_bytes, pnr_reads);
+    if (nr < 0) {
+      *perror_msg = file_error("Unable to read run file", path_);
+      return false;
+    }
+    if (nr % sizeof(int) != 0) {
+      *perror_msg = "Run file " + path_ + " length not a multiple of "
+                    + std::to_string(sizeof(int)) + " bytes";
+      return false;
+    }
+    offset_ += nr;
+    at_eof_  = static_cast<size_t>(nr) < nr_bytes;
+    begin_   = buffer_.data();
+    end_     = begin_ + nr / sizeof(int);
+    if (begin_ == end_)
+      at_eof_ = true;
+    return true;
+  }
+
+  const int *begin()  const { return begin_; }
+  const int *end()    const { return end_; }
+  bool       at_eof() const { return at_eof_; }
+
+ private:
+  std::string path_;
+  int         fd_;
+  off_t       offset_;
+  bool        at_eof_;  // nothing in the file after the buffer contents
+  IntVector   buffer_;
+  const int  *begin_;
+  const int  *end_;
+};
+
+// Double-buffered writer of the output file: the merge fills one buffer
+// while the other is written by an asynchronous task.
+
+class DoubleBufferedWriter {
+ public:
+  DoubleBufferedWriter() : fd_(-1), current_(0), filled_(0), nr_writes_(0) {}
+  DoubleBufferedWriter(const DoubleBufferedWriter &) = delete;
+  DoubleBufferedWriter & operator= (const DoubleBufferedWriter &) = delete;
+  ~DoubleBufferedWriter() {
+    if (pending_.valid())
+      pending_.wait();
+    if (fd_ >= 0)
+      close(fd_);
+  }
+
+  bool open_output(const std::string &path, size_t buffer_ints,
+                   std::string *perror_msg) {
+    path_ = path;
+    fd_   = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      *perror_msg = file_error("Unable to create output file", path);
+      return false;
+    }
+    buffers_[0].resize(buffer_ints);
+    buffers_[1].resize(buffer_ints);
+    return true;
+  }
+
+  int   *space()      { return buffers_[current_].data() + filled_; }
+  size_t space_size() { return buffers_[current_].size() - filled_; }
+
+  // Records that nr ints were put at space(); starts writing the buffer if
+  // that filled it.
+  bool commit(size_t nr, std::string *perror_msg) {
+    filled_ += nr;
+    if (filled_ == buffers_[current_].size())
+      return flush(perror_msg);
+    return true;
+  }
+
+  // Writes what remains and waits for all writes to finish.
+  bool finish(std::string *perror_msg) {
+    if (!flush(perror_msg) || !wait(perror_msg))
+      return false;
+    if (close(fd_) != 0) {
+      fd_ = -1;
+      *perror_msg = file_error("Unable to close output file", path_);
+      return false;
+    }
+    fd_ = -1;
+    return true;
+  }
+
+  size_t nr_writes() const { return nr_writes_; }
+
+ private:
+  // Waits for the write in progress, if any.
+  bool wait(std::string *perror_msg) {
+    if (pending_.valid()) {
+      int write_errno = pending_.get();
+      if (write_errno != 0) {
+        errno = write_errno;
+        *perror_msg = file_error("Unable to write output file", path_);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Starts writing the current buffer, after the previous write finishes,
+  // and switches to the other buffer.
+  bool flush(std::string *perror_msg) {
+    if (!wait(perror_msg))
+      return false;
+    if (filled_ == 0)
+      return true;
+    const char *buf      = reinterpret_cast<const char *>(
+                               buffers_[current_].data());
+    size_t      nr_bytes = filled_ * sizeof(int);
+    int         fd       = fd_;
+    size_t     *pwrites  = &nr_writes_;
+    pending_ = std::async(std::launch::async, [=]() {
+      return write_fully(fd, buf, nr_bytes, pwrites) ? 0 : errno;
+    });
+    current_ = 1 - current_;
+    filled_  = 0;
+    return true;
+  }
+
+  std::string       path_;
+  int               fd_;
+  IntVector         buffers_[2];
+  int               current_;
+  size_t            filled_;
+  size_t            nr_writes_;  // updated only by the writing task
+  std::future<int>  pending_;    // errno of the write, or 0
+};
+
+// External merge.  Each round, every run whose buffer is empty is refilled;
+// then, with bound the least last element of a buffer of a run with more on
+// disk, every element no greater than bound in any buffer precedes all that
+// remains on disk, so those elements are merged by the priority queue and
+// written.  That empties the buffer holding bound, for the next round.  When
+// every run is at end of file, the rest of the buffers are merged.
+
+bool multimerge_files(const std::vector<std::string> &input_paths,
+                      const std::string &output_path, size_t memory_budget,
+                      ExternalMergeStats *pstats, std::string *perror_msg) {
+  size_t nr_runs     = input_paths.size();
+  size_t buffer_ints = memory_budget / ((nr_runs + 2) * sizeof(int));
+  memset(pstats, 0, sizeof(*pstats));
+  pstats->buffer_ints = buffer_ints;
+  if (buffer_ints < kMinExternalBufferInts) {
+    *perror_msg = "Memory budget " + std::to_string(memory_budget)
+                  + " bytes too small for " + std::to_string(nr_runs)
+                  + " runs; need at least "
+                  + std::to_string((nr_runs + 2) * kMinExternalBufferInts
+                                   * sizeof(int));
+    return false;
+  }
+
+  std::vector<RunReader> readers(nr_runs);
+  for (size_t i = 0; i < nr_runs; ++i) {
+    if (!readers[i].open_run(input_paths[i], buffer_ints, perror_msg))
+      return false;
+  }
+  DoubleBufferedWriter writer;
+  if (!writer.open_output(output_path, buffer_ints, perror_msg))
+    return false;
+
+  std::vector<const int *> its(nr_runs);
+  std::vector<const int *> ends(nr_runs);
+  for (size_t i = 0; i < nr_runs; ++i) {
+    if (!readers[i].refill(&pstats->nr_reads, perror_msg))
+      return false;
+    its[i]  = readers[i].begin();
+    ends[i] = readers[i].end();
+  }
+
+  for (;;) {
+    bool has_bound = false;
+    int  bound     = INT_MAX;
+    for (size_t i = 0; i < nr_runs; ++i) {
+      if (its[i] == ends[i] && !readers[i].at_eof()) {
+        if (!readers[i].refill(&pstats->nr_reads, perror_msg))
+          return false;
+        its[i]  = readers[i].begin();
+        ends[i] = readers[i].end();
+      }
+      if (!readers[i].at_eof() && (!has_bound || ends[i][-1] < bound)) {
+        has_bound = true;
+        bound     = ends[i][-1];
+      }
+    }
+
+    size_t nr_safe = 0;
+    for (size_t i = 0; i < nr_runs; ++i) {
+      nr_safe += (has_bound ? std::upper_bound(its[i], ends[i], bound)
+                            : ends[i]) - its[i];
+    }
+    if (nr_safe == 0)
+      break;
+
+    IntPointerMerger merger((std::less<int>()), KeyOfValue<int, int>());
+    merger.push_ranges(&its, ends);
+    ++pstats->nr_rounds;
+    while (nr_safe > 0) {
+      size_t nr = std::min(nr_safe, writer.space_size());
+      merger.merge(nr, writer.space());
+      if (!writer.commit(nr, perror_msg))
+        return false;
+      nr_safe         -= nr;
+      pstats->nr_ints += nr;
+    }
+    if (!has_bound)
+      break;
+  }
+
+  if (!writer.finish(perror_msg))
+    return false;
+  pstats->nr_writes = writer.nr_writes();
+  return true;
+}
+
+// Writes a run file.
+
+bool write_run_file(const std::string &path, const IntVector &run,
+                    std::string *perror_msg) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    *perror_msg = file_error("Unable to create run file", path);
+    return false;
+  }
+  size_t nr_writes = 0;
+  bool ok = write_fully(fd, reinterpret_cast<const char *>(run.data()),
+                        run.size() * sizeof(int), &nr_writes);
+  if (!ok)
+    *perror_msg = file_error("Unable to write run file", path);
+  if (close(fd) != 0 && ok) {
+    *perror_msg = file_error("Unable to close run file", path);
+    ok = false;
+  }
+  return ok;
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
@@ -0,0 +1,57 @@
+// cc/mmergeext.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergeext.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// External memory merge of k sorted run files into one sorted output file,
+// for data larger than memory.  A run file is a sequence of ints in native
+// byte order, sorted, with no header.  The runs are read through buffers
+// with read-ahead, merged by the priority queue method of cc/mmerge.h, and
+// the output written through two buffers, one filled while the other is
+// written by another thread.  Memory used for buffers is bounded by a budget
+// given by the caller, not by the sizes of the files.  Errors are reported by
+// returning false with a message in *perror_msg.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEEXT_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEEXT_H_
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include "./mmerge.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Counts from an external merge, for reporting throughput.
+
+struct ExternalMergeStats {
+  size_t nr_ints;          // total number of ints merged
+  size_t buffer_ints;      // ints per run buffer, and per output buffer
+  size_t nr_reads;         // read calls on run files
+  size_t nr_writes;        // write calls on the output file
+  size_t nr_rounds;        // times the priority queue was rebuilt
+};
+
+// Merges the sorted run files named in input_paths into the file named
+// output_path, which is created or truncated, using about memory_budget
+// bytes for buffers: one buffer per run and two for output, all the same
+// size, which must come to at least kMinExternalBufferInts ints each.
+// Returns false on error, with a message in *perror_msg.
+
+const size_t kMinExternalBufferInts = 1024;
+
+bool multimerge_files(const std::vector<std::string> &input_paths,
+                      const std::string &output_path, size_t memory_budget,
+                      ExternalMergeStats *pstats, std::string *perror_msg);
+
+// Writes a vector of ints to the file named path, as a run file for
+// multimerge_files.  Returns false on error, with a message in *perror_msg.
+
+bool write_run_file(const std::string &path, const IntVector &run,
+                    std::string *perror_msg);
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEEXT_H_
@@ -0,0 +1,228 @@
+// cc/mmergeinplace.cc rev. 17 October 2026 by Stuart Ambler.
+// In-place multimerge of flat runs.  See cc/mmergeinplace.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergeinplace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Pairs of fewer values are not cut into parts for the parallel merge.
+
+static const size_t kMinInplaceSplit = 1 << 16;
+
+// Swaps [first, middle) and [middle, last) through buffer if the shorter
+// fits, otherwise by std::rotate, and returns where first's value went.
+
+static int *rotate_buffered(int *first, int *middle, int *last, int *buffer,
+                            size_t buffer_len) {
+  size_t len1 = middle - first;
+  size_t len2 = last - middle;
+  if (len1 <= len2 && len1 <= buffer_len) {
+    std::copy(first, middle, buffer);
+    std::copy(middle, last, first);
+    std::copy(buffer, buffer + len1, first + len2);
+    return first + len2;
+  }
+  if (len2 <= buffer_len) {
+    std::copy(middle, last, buffer);
+    std::copy_backward(first, middle, last);
+    std::copy(buffer, buffer + len2, first);
+    return first + len2;
+  }
+  std::rotate(first, middle, last);
+  return first + len2;
+}
+
+// Stable merge of the sorted [first, middle) and [middle, last) in place.
+
+static void merge_adjacent(int *first, int *middle, int *last, int *buffer,
+                           size_t buffer_len) {
+  while (first != middle && middle != last) {
+    // Values already in place at either end stay.
+    first = std::upper_bound(first, middle, *middle);
+    if (first == middle)
+      return;
+    last = std::lower_bound(middle, last, middle[-1]);
+    size_t len1 = middle - first;
+    size_t len2 = last - middle;
+
+    if (len1 <= len2 && len1 <= buffer_len) {
+      int *a     = buffer;
+      int *a_end = std::copy(first, middle, buffer);
+      int *b     = middle;
+      int *out   = first;
+      while (a != a_end && b != last)
+        *out++ = *b < *a ? *b++ : *a++;
+      std::copy(a, a_end, out);
+      return;
+    }
+    if (len2 <= buffer_len) {
+      int *a   = middle;
+      int *b   = std::copy(middle, last, buffer);
+      int *out = last;
+      while (a != first && b != buffer)
+        *--out = b[-1] < a[-1] ? *--a : *--b;
+      std::copy_backward(buffer, b, out);
+      return;
+    }
+
+    int *cut1;
+    int *cut2;
+    if (len1 >= len2) {
+      cut1 = first + len1 / 2;
+      cut2 = std::lower_bound(middle, last, *cut1);
+    } else {
+      cut2 = middle + len2 / 2;
+      cut1 = std::upper_bound(first, middle, *cut2);
+    }
+    int *new_middle = rotate_buffered(cut1, middle, cut2, buffer, buffer_len);
+    // The shorter half by recursion, the longer by the loop, so that the
+    // recursion is O(log n) deep.
+    if (new_middle - first < last - new_middle) {
+      merge_adjacent(first, cut1, new_middle, buffer, buffer_len);
+      first  = new_middle;
+      middle = cut2;
+    } else {
+      merge_adjacent(new_middle, cut2, last, buffer, buffer_len);
+      last   = new_middle;
+      middle = cut1;
+    }
+  }
+}
+
+// The offsets of the runs left by merging each pair of neighbors in
+// *poffsets, an odd run out at the end kept as it is.
+
+static void halve_offsets(std::vector<size_t> *poffsets) {
+  std::vector<size_t> &offsets = *poffsets;
+  size_t k = offsets.size() - 1;
+  size_t j = 0;
+  for (size_t i = 0; i < k; i += 2)
+    offsets[j++] = offsets[i];
+  offsets[j++] = offsets[k];
+  offsets.resize(j);
+}
+
+static size_t sqrt_buffer_len(const FlatRuns &runs) {
+  return static_cast<size_t>(
+             std::sqrt(static_cast<double>(runs.values.size()))) + 1;
+}
+
+void multimerge_inplace(FlatRuns *pruns, size_t buffer_len) {
+  IntVector            buffer(buffer_len);
+  int                 *values  = pruns->values.data();
+  std::vector<size_t> &offsets = pruns->offsets;
+  while (offsets.size() > 2) {
+    for (size_t r = 0; r + 2 < offsets.size(); r += 2) {
+      merge_adjacent(values + offsets[r], values + offsets[r + 1],
+                     values + offsets[r + 2], buffer.data(), buffer_len);
+    }
+    halve_offsets(&offsets);
+  }
+}
+
+void multimerge_inplace(FlatRuns *pruns) {
+  multimerge_inplace(pruns, sqrt_buffer_len(*pruns));
+}
+
+// Merges [first, middle) and [middle, last) as nr_parts parts, each with
+// its own buffer of buffer_len ints, the first at buffers.  Co-ranking
+// finds the i values of the first run and j of the second that come first
+// among the left parts' share of the values; rotating the rest of the
+// first run past those j makes the left parts' values one pair and the
+// right parts' another, the latter merged as another task.
+
+static void merge_parts(WorkStealingPool *ppool, int *first, int *middle,
+                        int *last, size_t nr_parts, int *buffers,
+                        size_t buffer_len) {
+  while (nr_parts > 1 && static_cast<size_t>(last - first)
+                         >= kMinInplaceSplit) {
+    size_t nr_left = nr_parts / 2;
+    size_t len1    = middle - first;
+    size_t len2    = last - middle;
+    size_t target  = (len1 + len2) / nr_parts * nr_left;
+    // The least i, within bounds, such that no more values of the first
+    // run belong among the target least, ties going to the first run.
+    size_t lo = target > len2 ? target - len2 : 0;
+    size_t hi = std::min(target, len1);
+    while (lo < hi) {
+      size_t i = lo + (hi - lo) / 2;
+      size_t j = target - i;
+      if (j > 0 && first[i] <= middle[j - 1])
+        lo = i + 1;
+      else
+        hi = i;
+    }
+    int *cut1 = first + lo;
+    int *cut2 = middle + (target - lo);
+    int *new_middle = rotate_buffered(cut1, middle, cut2, buffers,
+                                      buffer_len);
+    size_t nr_right = nr_parts - nr_left;
+    int   *right_buffers = buffers + nr_left * buffer_len;
+    ppool->submit([=]() {
+      merge_parts(ppool, new_middle, cut2, last, nr_right, right_buffers,
+                  buffer_len);
+    });
+    middle   = cut1;
+    last     = new_middle;
+    nr_parts = nr_left;
+  }
+  merge_adjacent(first, middle, last, buffers, buffer_len);
+}
+
+void multimerge_inplace_par(FlatRuns *pruns, WorkStealingPool *ppool,
+                            size_t buffer_len) {
+  size_t               nr_threads = ppool->nr_threads();
+  IntVector            buffers(nr_threads * buffer_len);
+  int                 *values  = pruns->values.data();
+  std::vector<size_t> &offsets = pruns->offsets;
+  while (offsets.size() > 2) {
+    size_t nr_pairs = (offsets.size() - 1) / 2;
+    if (nr_pairs >= nr_threads) {
+      // Groups of pairs of about n / nr_threads values each.
+      size_t nr_values = offsets[2 * nr_pairs];
+      size_t p = 0;
+      for (size_t t = 0; t < nr_threads; ++t) {
+        size_t first_pair = p;
+        size_t limit      = nr_values / nr_threads * (t + 1);
+        if (t + 1 == nr_threads)
+          p = nr_pairs;
+        while (p < nr_pairs && offsets[2 * p + 2] <= limit)
+          ++p;
+        const size_t *bounds = offsets.data();
+        int          *buffer = buffers.data() + t * buffer_len;
+        ppool->submit([=]() {
+          for (size_t q = first_pair; q < p; ++q) {
+            merge_adjacent(values + bounds[2 * q], values + bounds[2 * q + 1],
+                           values + bounds[2 * q + 2], buffer, buffer_len);
+          }
+        });
+      }
+    } else {
+      size_t nr_parts = nr_threads / nr_pairs;
+      for (size_t q = 0; q < nr_pairs; ++q) {
+        int *first  = values + offsets[2 * q];
+        int *middle = values + offsets[2 * q + 1];
+        int *last   = values + offsets[2 * q + 2];
+        int *buffer = buffers.data() + q * nr_parts * buffer_len;
+        ppool->submit([=]() {
+          merge_parts(ppool, first, middle, last, nr_parts, buffer,
+                      buffer_len);
+        });
+      }
+    }
+    ppool->wait();
+    halve_offsets(&offsets);
+  }
+}
+
+void multimerge_inplace_par(FlatRuns *pruns, int nr_threads) {
+  WorkStealingPool pool(nr_threads);
+  multimerge_inplace_par(pruns, &pool, sqrt_buffer_len(*pruns));
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
@@ -0,0 +1,63 @@
+// cc/mmergeinplace.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergeinplace.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// In-place multimerge of runs stored one after another in one buffer, as in
+// FlatRuns, for machines where an output as large as the input will not
+// fit.  The runs are merged by pairs of neighbors, round after round, until
+// one is left, so each value is moved in about log2(k) rounds.  Each pair is
+// merged stably as in libstdc++'s adaptive merge: when the shorter run fits
+// in a buffer of buffer_len ints it is moved there and the two merged
+// straight back; otherwise the longer run is cut at its middle, the other at
+// the same value by binary search, the two pieces between the cuts swapped
+// by a rotation, and the two halves merged the same way.  The values at
+// either end of a pair that are already in place are left unmoved.
+//
+// With a buffer of b ints, a pair of m values costs O(m log(m / b)) moves
+// at worst, against O(m) for a merge into separate output; with none it is
+// the merge of Dudzinski and Dydek, O(1) extra memory but for a recursion
+// O(log m) deep.  About sqrt(n) ints of buffer removes most of the
+// rotations while costing nothing measurable.  The offsets of the runs are
+// reused for those of the merged runs of each round, so the only memory
+// allocated is the buffer.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEINPLACE_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEINPLACE_H_
+
+#include <cstddef>
+
+#include "./mmerge.h"
+#include "./mmergepool.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Merges the runs of *pruns in place, leaving it one run of all the values,
+// in the same order as from multimerge_lt, using a buffer of buffer_len
+// ints; 0 means none.
+
+void multimerge_inplace(FlatRuns *pruns, size_t buffer_len);
+
+// The same with a buffer of about sqrt(n) ints.
+
+void multimerge_inplace(FlatRuns *pruns);
+
+// Parallel in-place multimerge: the same result, on the threads of *ppool,
+// each with its own buffer of buffer_len ints.  While a round has at least
+// as many pairs as threads, the pairs are dealt to one task per thread in
+// groups of about equal size; in the last rounds each pair is cut into one
+// part per thread, as in multimerge_par, by co-ranking and a rotation at
+// each cut, and the parts merged as tasks.
+
+void multimerge_inplace_par(FlatRuns *pruns, WorkStealingPool *ppool,
+                            size_t buffer_len);
+
+// The same on a pool of nr_threads threads made for the call (nr_threads <=
+// 0 means one per hardware thread), each with a buffer of about sqrt(n)
+// ints.
+
+void multimerge_inplace_par(FlatRuns *pruns, int nr_threads = 0);
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEINPLACE_H_
@@ -0,0 +1,304 @@
+// cc/mmergepack.cc rev. 17 October 2026 by Stuart Ambler.
+// Compressed sorted runs and their merge.  See cc/mmergepack.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergepack.h"
+
+#include <algorithm>
+#include <functional>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Packing and unpacking of one block of kPackBlockLen differences, width
+// bits each, into 4 * width words.  Difference i is in lane i % 4, at bit
+// (i / 4) * width of the lane's bits, which run on from word to word of the
+// lane.
+
+static const size_t kPackRows = kPackBlockLen / 4;  // differences per lane
+
+#ifdef __SSE2__
+
+// With SSE2, row j, differences 4j to 4j + 3, is one vector: each row is
+// shifted into the lanes' current words, and the words stored as they fill.
+
+static void pack_block(const uint32_t *deltas, uint32_t width,
+                       uint32_t *words) {
+  if (width == 0)
+    return;
+  __m128i *out = reinterpret_cast<__m128i *>(words);
+  __m128i  acc = _mm_setzero_si128();
+  uint32_t shift = 0;
+  for (size_t j = 0; j < kPackRows; ++j) {
+    __m128i row = _mm_loadu_si128(
+                      reinterpret_cast<const __m128i *>(deltas + 4 * j));
+    acc = _mm_or_si128(acc, _mm_sll_epi32(row, _mm_cvtsi32_si128(shift)));
+    shift += width;
+    if (shift >= 32) {
+      _mm_storeu_si128(out++, acc);
+      shift -= 32;
+      acc = shift > 0
+            ? _mm_srl_epi32(row, _mm_cvtsi32_si128(width - shift))
+            : _mm_setzero_si128();
+    }
+  }
+}
+
+// Also undoes the differences from base: a prefix sum of each row's four
+// lanes by two shifted adds, plus the last value of the row before.
+
+static void unpack_block(const uint32_t *words, uint32_t width, int base,
+                         int *out) {
+  const __m128i *in    = reinterpret_cast<const __m128i *>(words);
+  __m128i        mask  = _mm_set1_epi32(width == 32 ? ~0U
+                                                    : (1U << width) - 1);
+  __m128i        prev  = _mm_set1_epi32(base);
+  uint32_t       shift = 0;
+  __m128i        word  = width > 0 ? _mm_loadu_si128(in)
+                                   : _mm_setzero_si128();
+  for (size_t j = 0; j < kPackRows; ++j) {
+    __m128i row = _mm_srl_epi32(word, _mm_cvtsi32_si128(shift));
+    shift += width;
+    if (shift >= 32) {
+      shift -= 32;
+      if (j + 1 < kPackRows || shift > 0)
+        word = _mm_loadu_si128(++in);
+      if (shift > 0)
+        row = _mm_or_si128(row, _mm_sll_epi32(
+                                    word, _mm_cvtsi32_si128(width - shift)));
+    }
+    row = _mm_and_si128(row, mask);
+    row = _mm_add_epi32(row, _mm_slli_si128(row, 4));
+    row = _mm_add_epi32(row, _mm_slli_si128(row, 8));
+    row = _mm_add_epi32(row, prev);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4 * j), row);
+    prev = _mm_shuffle_epi32(row, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+}
+
+#else  // __SSE2__
+
+static void pack_block(const uint32_t *deltas, uint32_t width,
+                       uint32_t *words) {
+  if (width == 0)
+    return;
+  std::fill(words, words + 4 * width, 0);
+  for (size_t i = 0; i < kPackBlockLen; ++i) {
+    size_t   lane  = i % 4;
+    size_t   bit   = (i / 4) * width;
+    size_t   w     = bit / 32;
+    uint32_t shift = bit % 32;
+    words[4 * w + lane] |= deltas[i] << shift;
+    if (shift + width > 32)
+      words[4 * (w + 1) + lane] |= deltas[i] >> (32 - shift);
+  }
+}
+
+static void unpack_block(const uint32_t *words, uint32_t width, int base,
+                         int *out) {
+  uint32_t mask  = width == 32 ? ~0U : (1U << width) - 1;
+  uint32_t value = base;
+  for (size_t i = 0; i < kPackBlockLen; ++i) {
+    uint32_t delta = 0;
+    if (width > 0) {
+      size_t   lane  = i % 4;
+      size_t   bit   = (i / 4) * width;
+      size_t   w     = bit / 32;
+      uint32_t shift = bit % 32;
+      delta = words[4 * w + lane] >> shift;
+      if (shift + width > 32)
+        delta |= words[4 * (w + 1) + lane] << (32 - shift);
+    }
+    value += delta & mask;
+    out[i] = value;
+  }
+}
+
+#endif  // __SSE2__
+
+void PackedRun::add_block(const int *values, size_t n, int base) {
+  uint32_t deltas[kPackBlockLen];
+  uint32_t prev = base;
+  uint32_t bits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    deltas[i] = static_cast<uint32_t>(values[i]) - prev;
+    prev      = values[i];
+    bits     |= deltas[i];
+  }
+  std::fill(deltas + n, deltas + kPackBlockLen, 0);
+  Block block;
+  block.base   = base;
+  block.width  = bits == 0 ? 0 : 32 - __builtin_clz(bits);
+  block.offset = words_.size();
+  blocks_.push_back(block);
+  words_.resize(words_.size() + 4 * block.width);
+  pack_block(deltas, block.width, words_.data() + block.offset);
+  size_ += n;
+}
+
+void PackedRun::assign(const int *first, const int *last) {
+  clear();
+  append(first, last);
+}
+
+void PackedRun::append(const int *first, const int *last) {
+  if (first == last)
+    return;
+  // A short last block is decoded and packed again with the new values.
+  int    tail[kPackBlockLen];
+  size_t nr_tail = size_ % kPackBlockLen;
+  if (nr_tail > 0) {
+    const Block &block = blocks_.back();
+    int buffer[kPackBlockLen];
+    unpack_block(words_.data() + block.offset, block.width, block.base,
+                 buffer);
+    std::copy(buffer, buffer + nr_tail, tail);
+    words_.resize(block.offset);
+    blocks_.pop_back();
+    size_ -= nr_tail;
+    size_t nr_new = std::min(kPackBlockLen - nr_tail,
+                             static_cast<size_t>(last - first));
+    std::copy(first, first + nr_new, tail + nr_tail);
+    first += nr_new;
+    nr_tail += nr_new;
+  }
+  int base = size_ == 0 ? (nr_tail > 0 ? tail[0] : *first)
+                        : last_value();
+  if (nr_tail > 0) {
+    add_block(tail, nr_tail, base);
+    base = tail[nr_tail - 1];
+  }
+  while (first != last) {
+    size_t n = std::min(kPackBlockLen, static_cast<size_t>(last - first));
+    add_block(first, n, base);
+    base   = first[n - 1];
+    first += n;
+  }
+}
+
+void PackedRun::clear() {
+  size_ = 0;
+  blocks_.clear();
+  words_.clear();
+}
+
+size_t PackedRun::nr_bytes() const {
+  return words_.size() * sizeof(uint32_t) + blocks_.size() * sizeof(Block);
+}
+
+size_t PackedRun::decode_block(size_t b, int *out) const {
+  const Block &block = blocks_[b];
+  unpack_block(words_.data() + block.offset, block.width, block.base, out);
+  return std::min(kPackBlockLen, size_ - b * kPackBlockLen);
+}
+
+void PackedRun::decode(IntVector *pvalues) const {
+  pvalues->resize(blocks_.size() * kPackBlockLen);
+  for (size_t b = 0; b < blocks_.size(); ++b)
+    decode_block(b, pvalues->data() + b * kPackBlockLen);
+  pvalues->resize(size_);
+}
+
+int PackedRun::last_value() const {
+  int buffer[kPackBlockLen];
+  return buffer[decode_block(blocks_.size() - 1, buffer) - 1];
+}
+
+void pack_runs(const IntVectorVector &arrays, PackedRunVector *pruns) {
+  pruns->resize(arrays.size());
+  for (size_t i = 0; i < arrays.size(); ++i)
+    (*pruns)[i].assign(arrays[i].data(), arrays[i].data() + arrays[i].size());
+}
+
+// The merge, by loser tree over one decoded block of each run, writing the
+// output kPackBlockLen values at a time: to out.begin(), then calling
+// out.end(n) with the number written.
+
+template <typename Output>
+static void merge_packed(const PackedRunVector &runs, Output out) {
+  typedef internal::LoserTree<int, std::less<int> > Tree;
+  struct Source {
+    size_t block;   // next to decode
+    size_t pos;
+    size_t end;
+    int    buffer[kPackBlockLen];
+  };
+  size_t k = runs.size();
+  std::vector<Source>     sources(k);
+  std::vector<Tree::Node> leaves(k);
+  Tree tree(k, std::less<int>());
+  for (size_t i = 0; i < k; ++i) {
+    Source &source = sources[i];
+    source.block = 0;
+    source.pos   = 0;
+    source.end   = 0;
+    if (runs[i].size() > 0) {
+      source.end = runs[i].decode_block(source.block++, source.buffer);
+      tree.leaf(source.buffer[0], i, &leaves[i]);
+    } else {
+      tree.exhausted_leaf(i, &leaves[i]);
+    }
+  }
+  tree.build(&leaves);
+
+  Tree::Node node;
+  while (k > 0 && !tree.winner_exhausted()) {
+    int   *output    = out.begin();
+    size_t nr_output = 0;
+    while (nr_output < kPackBlockLen && !tree.winner_exhausted()) {
+      size_t  src    = tree.winner().src;
+      Source &source = sources[src];
+      output[nr_output++] = source.buffer[source.pos++];
+      if (   source.pos == source.end
+          && source.block < runs[src].nr_blocks()) {
+        source.end = runs[src].decode_block(source.block++, source.buffer);
+        source.pos = 0;
+      }
+      if (source.pos < source.end)
+        tree.leaf(source.buffer[source.pos], src, &node);
+      else
+        tree.exhausted_leaf(src, &node);
+      tree.replay(src, node);
+    }
+    out.end(nr_output);
+  }
+}
+
+// Output straight to an array with room for all the values.
+
+struct ArrayOutput {
+  int *next;
+  int *begin() { return next; }
+  void end(size_t n) { next += n; }
+};
+
+// Output through a buffer, packed as it fills.
+
+struct PackedOutput {
+  PackedRun *prun;
+  int        buffer[kPackBlockLen];
+  int *begin() { return buffer; }
+  void end(size_t n) { prun->append(buffer, buffer + n); }
+};
+
+void multimerge_packed(const PackedRunVector &runs, IntVector *poutput) {
+  size_t n = 0;
+  for (size_t i = 0; i < runs.size(); ++i)
+    n += runs[i].size();
+  poutput->resize(n);
+  ArrayOutput out = { poutput->data() };
+  merge_packed<ArrayOutput &>(runs, out);
+}
+
+void multimerge_packed(const PackedRunVector &runs, PackedRun *poutput) {
+  poutput->clear();
+  PackedOutput out;
+  out.prun = poutput;
+  merge_packed<PackedOutput &>(runs, out);
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
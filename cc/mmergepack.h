@@ -0,0 +1,93 @@
+// cc/mmergepack.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergepack.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Compressed sorted runs of int, and their merge.  At large n the merge is
+// bound by memory bandwidth, and sorted ints compress well: the differences
+// of successive values are small.  A PackedRun holds a run in blocks of
+// kPackBlockLen values, each block the differences of its values from their
+// predecessors, bit-packed with the width of the block's largest, after the
+// layout of Lemire and Boytsov's SIMD-BP128: four lanes, value i of the
+// block in lane i % 4, so that SSE2 packs and unpacks four values at once
+// with the same shifts, and undoes the differences with a prefix sum of
+// four lanes.  Without SSE2 the same layout is packed by scalar code.
+//
+// multimerge_packed decodes one block of each run at a time into a buffer
+// in front of a loser tree, so that only the compressed runs are read from
+// memory, and may pack its output in the same format as it goes.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPACK_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPACK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "./mmerge.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+const size_t kPackBlockLen = 128;
+
+class PackedRun {
+ public:
+  PackedRun() : size_(0) {}
+
+  // Replaces the run by the sorted values [first, last).
+  void assign(const int *first, const int *last);
+  // Appends the sorted values [first, last), none less than the run's last.
+  void append(const int *first, const int *last);
+  void clear();
+
+  size_t size() const { return size_; }
+  size_t nr_blocks() const { return blocks_.size(); }
+  // Bytes the run takes, its packed words and block headers.
+  size_t nr_bytes() const;
+
+  // Writes the values of block b to out[0], ..., at most kPackBlockLen of
+  // them, and returns how many; out must have room for kPackBlockLen.
+  size_t decode_block(size_t b, int *out) const;
+  // Writes all the values to *pvalues.
+  void decode(IntVector *pvalues) const;
+
+  // The packed words, block after block; block b is 4 * bit width words,
+  // lane l's bits of word w at words()[4 * w + l].
+  const std::vector<uint32_t> &words() const { return words_; }
+
+ private:
+  struct Block {
+    int      base;    // value before the block's first; the first, for
+                      // block 0
+    uint32_t width;   // bits per difference
+    size_t   offset;  // of the block's first word
+  };
+
+  // Packs the n <= kPackBlockLen values as a new block after base.
+  void add_block(const int *values, size_t n, int base);
+  // The last value of a nonempty run.
+  int last_value() const;
+
+  size_t                size_;
+  std::vector<Block>    blocks_;
+  std::vector<uint32_t> words_;
+};
+
+typedef std::vector<PackedRun> PackedRunVector;
+
+// Packs each of arrays into *pruns.
+
+void pack_runs(const IntVectorVector &arrays, PackedRunVector *pruns);
+
+// Packed multimerge: same output as multimerge_lt, of the runs decoded.
+
+void multimerge_packed(const PackedRunVector &runs, IntVector *poutput);
+
+// The same, packed into *poutput as it is merged.
+
+void multimerge_packed(const PackedRunVector &runs, PackedRun *poutput);
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPACK_H_
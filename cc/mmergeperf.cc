@@ -0,0 +1,179 @@
+// cc/mmergeperf.cc rev. 17 October 2026 by Stuart Ambler.
+// Hardware performance counters.  See cc/mmergeperf.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergeperf.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <fstream>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+static const char *const kPerfCounterNames[kNrPerfCounters] = {
+  "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+  "dtlb_misses"
+};
+
+const char *perf_counter_name(PerfCounter counter) {
+  return kPerfCounterNames[counter];
+}
+
+PerfCounters::PerfCounters() {
+  for (int c = 0; c < kNrPerfCounters; ++c)
+    fds_[c] = -1;
+}
+
+#ifdef __linux__
+
+// perf_event_open type and config of each counter; cache events are
+// cache id | operation << 8 | result << 16.
+
+static const struct {
+  uint32_t type;
+  uint64_t config;
+} kPerfEvents[kNrPerfCounters] = {
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { PERF_TYPE_HW_CACHE,   PERF_COUNT_HW_CACHE_L1D
+                        | PERF_COUNT_HW_CACHE_OP_READ << 8
+                        | PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { PERF_TYPE_HW_CACHE,   PERF_COUNT_HW_CACHE_DTLB
+                        | PERF_COUNT_HW_CACHE_OP_READ << 8
+                        | PERF_COUNT_HW_CACHE_RESULT_MISS << 16 }
+};
+
+PerfCounters::~PerfCounters() {
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    if (fds_[c] >= 0)
+      close(fds_[c]);
+  }
+}
+
+bool PerfCounters::open(std::string *perror_msg) {
+  int nr_open = 0;
+  int error   = 0;
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = kPerfEvents[c].type;
+    attr.config         = kPerfEvents[c].config;
+    attr.disabled       = 1;
+    attr.inherit        = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    =   PERF_FORMAT_TOTAL_TIME_ENABLED
+                          | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fds_[c] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fds_[c] >= 0)
+      ++nr_open;
+    else
+      error = errno;
+  }
+  if (nr_open == 0) {
+    *perror_msg = std::string("perf_event_open: ") + strerror(error);
+    return false;
+  }
+  return true;
+}
+
+void PerfCounters::start() {
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    if (fds_[c] >= 0) {
+      ioctl(fds_[c], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds_[c], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+}
+
+void PerfCounters::stop(double counts[kNrPerfCounters]) {
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    if (fds_[c] >= 0)
+      ioctl(fds_[c], PERF_EVENT_IOC_DISABLE, 0);
+  }
+  for (int c = 0; c < kNrPerfCounters; ++c) {
+    counts[c] = -1.0;
+    uint64_t values[3];  // value, time enabled, time running
+    if (   fds_[c] >= 0
+        && read(fds_[c], values, sizeof(values)) == sizeof(values)) {
+      counts[c] = values[2] > 0
+                  ? static_cast<double>(values[0]) * values[1] / values[2]
+                  : 0.0;
+    }
+  }
+}
+
+// The value of field, such as "VmHWM:", of /proc/self/status, in bytes.
+
+static size_t status_bytes(const std::string &field) {
+  std::ifstream status("/proc/self/status");
+  std::string   name;
+  while (status >> name) {
+    if (name == field) {
+      size_t kb = 0;
+      status >> kb;
+      return kb * 1024;
+    }
+    status.ignore(1 << 16, '\n');
+  }
+  return 0;
+}
+
+size_t rss_bytes() {
+  return status_bytes("VmRSS:");
+}
+
+size_t peak_rss_bytes() {
+  return status_bytes("VmHWM:");
+}
+
+bool reset_peak_rss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5" << std::endl;
+  return clear_refs.good();
+}
+
+#else  // !__linux__
+
+PerfCounters::~PerfCounters() {}
+
+bool PerfCounters::open(std::string *perror_msg) {
+  *perror_msg = "hardware counters are read only on Linux";
+  return false;
+}
+
+void PerfCounters::start() {}
+
+void PerfCounters::stop(double counts[kNrPerfCounters]) {
+  for (int c = 0; c < kNrPerfCounters; ++c)
+    counts[c] = -1.0;
+}
+
+size_t rss_bytes() {
+  return 0;
+}
+
+size_t peak_rss_bytes() {
+  return 0;
+}
+
+bool reset_peak_rss() {
+  return false;
+}
+
+#endif  // __linux__
+
+}  // namespace com_zulazon_samples_cc_mmerge
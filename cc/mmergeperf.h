@@ -0,0 +1,76 @@
+// cc/mmergeperf.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergeperf.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Hardware performance counters for the benchmark harness, read through the
+// Linux perf_event_open system call: cycles, instructions, L1 data cache,
+// last level cache, and data TLB misses, and branch mispredictions, counted
+// in user mode for the calling thread and any threads it starts while
+// counting.  Each counter is opened on its own, so that those the processor
+// or kernel lacks, or a perf_event_paranoid setting forbids, are simply
+// missing; when the kernel multiplexes more counters than the processor has,
+// counts are scaled by the fraction of the time each was running.  Elsewhere
+// than Linux no counter is available.  Also the resident set size and its
+// peak, from /proc, for the memory a merge takes.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPERF_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPERF_H_
+
+#include <cstddef>
+
+#include <string>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+enum PerfCounter {
+  kPerfCycles,
+  kPerfInstructions,
+  kPerfL1dMisses,
+  kPerfLlcMisses,
+  kPerfBranchMisses,
+  kPerfDtlbMisses,
+  kNrPerfCounters
+};
+
+// Short name of counter, as in testmmerge output and JSON: cycles,
+// instructions, l1d_misses, llc_misses, branch_misses, or dtlb_misses.
+
+const char *perf_counter_name(PerfCounter counter);
+
+class PerfCounters {
+ public:
+  PerfCounters();
+  ~PerfCounters();
+
+  // Opens the counters.  Returns false, with a message in *perror_msg, if
+  // none could be opened.
+  bool open(std::string *perror_msg);
+
+  bool available(PerfCounter counter) const { return fds_[counter] >= 0; }
+
+  // Zero and start the counters, and stop them and set counts[c] to the
+  // count of each counter c since start, or to -1 if c is not available.
+  void start();
+  void stop(double counts[kNrPerfCounters]);
+
+ private:
+  PerfCounters(const PerfCounters &);
+  PerfCounters &operator=(const PerfCounters &);
+
+  int fds_[kNrPerfCounters];
+};
+
+// The process's resident set size, VmRSS in /proc/self/status, and its peak,
+// VmHWM, in bytes, or 0 if not known, as elsewhere than Linux.
+// reset_peak_rss sets the peak to the current size by writing 5 to
+// /proc/self/clear_refs (Linux 4.0 and later), and returns false if it could
+// not, when the peak is that of the whole run.
+
+size_t rss_bytes();
+size_t peak_rss_bytes();
+bool reset_peak_rss();
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPERF_H_
@@ -0,0 +1,116 @@
+// cc/mmergepool.cc rev. 17 October 2026 by Stuart Ambler.
+// Work-stealing thread pool.  See cc/mmergepool.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergepool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// The pool and index of the worker running on this thread, if any, so that
+// a task's submissions go to its own deque.
+
+static thread_local const WorkStealingPool *current_pool   = nullptr;
+static thread_local int                     current_worker = -1;
+
+WorkStealingPool::WorkStealingPool(int nr_threads)
+    : nr_queued_(0), nr_pending_(0), stopping_(false), next_worker_(0),
+      nr_steals_(0) {
+  if (nr_threads <= 0)
+    nr_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (int w = 0; w < nr_threads; ++w)
+    workers_.push_back(std::unique_ptr<Worker>(new Worker));
+  for (int w = 0; w < nr_threads; ++w)
+    threads_.push_back(std::thread(&WorkStealingPool::run, this, w));
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  for (size_t t = 0; t < threads_.size(); ++t)
+    threads_[t].join();
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+  size_t w = current_pool == this ? current_worker
+                                  : next_worker_++ % workers_.size();
+  // Counted before it is queued, so that the counts never go below the
+  // tasks a worker may already have taken.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++nr_queued_;
+    ++nr_pending_;
+  }
+  {
+    std::lock_guard<std::mutex> lock(workers_[w]->mutex);
+    workers_[w]->tasks.push_back(std::move(task));
+  }
+  work_cv_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return nr_pending_ == 0; });
+}
+
+// Takes a task for worker w: its own newest, or else the oldest of the next
+// worker after w that has any.  Returns false if every deque was empty.
+
+bool WorkStealingPool::take(int w, std::function<void()> *ptask) {
+  size_t nr_workers = workers_.size();
+  for (size_t i = 0; i < nr_workers; ++i) {
+    Worker &worker = *workers_[(w + i) % nr_workers];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+      continue;
+    if (i == 0) {
+      *ptask = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+    } else {
+      *ptask = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      ++nr_steals_;
+    }
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::run(int w) {
+  current_pool   = this;
+  current_worker = w;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this]() { return nr_queued_ > 0 || stopping_; });
+      if (nr_queued_ == 0)
+        return;
+    }
+    // The task counted may not be queued yet, or another worker may take
+    // it first; then look again.
+    std::function<void()> task;
+    if (!take(w, &task)) {
+      std::this_thread::yield();
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --nr_queued_;
+    }
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--nr_pending_ == 0)
+        done_cv_.notify_all();
+    }
+  }
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
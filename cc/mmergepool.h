@@ -0,0 +1,75 @@
+// cc/mmergepool.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergepool.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// A work-stealing thread pool for the parallel sort and batch merges.  Each
+// worker thread has its own deque of tasks: it takes its own newest task
+// from the back, and when its deque is empty steals the oldest task from
+// the front of another's, so that a worker given slow tasks is relieved by
+// those that finish early.  Tasks submitted from outside the pool are dealt
+// to the workers in turn; tasks submitted by a task go to its own worker.
+// Tasks must not throw.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPOOL_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPOOL_H_
+
+#include <cstddef>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+class WorkStealingPool {
+ public:
+  // Starts nr_threads workers; nr_threads <= 0 means one per hardware
+  // thread.
+  explicit WorkStealingPool(int nr_threads);
+  // Waits for the tasks submitted, then stops the workers.
+  ~WorkStealingPool();
+
+  int nr_threads() const { return threads_.size(); }
+
+  void submit(std::function<void()> task);
+
+  // Blocks until every task submitted so far, and every task those submit,
+  // has finished.  Not to be called from a task.
+  void wait();
+
+  // Tasks taken from another worker's deque since the pool started.
+  size_t nr_steals() const { return nr_steals_; }
+
+ private:
+  WorkStealingPool(const WorkStealingPool &);
+  WorkStealingPool &operator=(const WorkStealingPool &);
+
+  struct Worker {
+    std::mutex                        mutex;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  void run(int w);
+  bool take(int w, std::function<void()> *ptask);
+
+  std::vector<std::unique_ptr<Worker> > workers_;
+  std::vector<std::thread>              threads_;
+  std::mutex                            mutex_;    // for the fields below
+  std::condition_variable               work_cv_;  // nr_queued_ > 0, or stop
+  std::condition_variable               done_cv_;  // nr_pending_ == 0
+  size_t                                nr_queued_;   // not yet taken
+  size_t                                nr_pending_;  // not yet finished
+  bool                                  stopping_;
+  std::atomic<size_t>                   next_worker_;
+  std::atomic<size_t>                   nr_steals_;
+};
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGEPOOL_H_
@@ -0,0 +1,223 @@
+// cc/mmergerunset.cc rev. 17 October 2026 by Stuart Ambler.
+// Run-set files.  See cc/mmergerunset.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergerunset.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+static const char kRunSetMagic[8] = { 'M', 'M', 'R', 'U', 'N', 'S', 'E', 'T' };
+static const uint64_t kRunSetAlignment = 64;
+
+// The format is little-endian, and values are written and mapped as they
+// are in memory, so only little-endian machines read and write it here.
+
+static bool is_little_endian() {
+  const uint32_t one = 1;
+  return *reinterpret_cast<const char *>(&one) == 1;
+}
+
+static std::string run_set_error(const std::string &what,
+                                 const std::string &path) {
+  return what + " " + path + ": " + strerror(errno);
+}
+
+// Writes arrays, a vector of vectors of Value, as a run-set file of
+// sizeof(Value)-byte values.
+
+template <typename Value>
+static bool write_run_set_values(const std::string &path,
+                                 const std::vector<std::vector<Value> >
+                                     &arrays,
+                                 std::string *perror_msg) {
+  if (!is_little_endian()) {
+    *perror_msg = "Run-set files are written only on little-endian machines";
+    return false;
+  }
+  RunSetHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kRunSetMagic, sizeof(header.magic));
+  header.version        = kRunSetVersion;
+  header.value_size     = sizeof(Value);
+  header.nr_runs        = arrays.size();
+  header.nr_values      = total_length(arrays);
+  header.offsets_offset = sizeof(header);
+  header.payload_offset = header.offsets_offset
+                          + (header.nr_runs + 1) * sizeof(uint64_t);
+  header.payload_offset = (header.payload_offset + kRunSetAlignment - 1)
+                          / kRunSetAlignment * kRunSetAlignment;
+
+  std::vector<uint64_t> offsets(1, 0);
+  for (size_t i = 0; i < arrays.size(); ++i)
+    offsets.push_back(offsets.back() + arrays[i].size());
+  std::vector<char> padding(header.payload_offset - header.offsets_offset
+                            - offsets.size() * sizeof(uint64_t), 0);
+
+  std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(offsets.data()),
+            offsets.size() * sizeof(uint64_t));
+  out.write(padding.data(), padding.size());
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    out.write(reinterpret_cast<const char *>(arrays[i].data()),
+              arrays[i].size() * sizeof(Value));
+  }
+  out.close();
+  if (!out) {
+    *perror_msg = run_set_error("Unable to write run-set file", path);
+    return false;
+  }
+  return true;
+}
+
+bool write_run_set(const std::string &path, const IntVectorVector &arrays,
+                   std::string *perror_msg) {
+  return write_run_set_values(path, arrays, perror_msg);
+}
+
+bool write_run_set(const std::string &path, const Int64VectorVector &arrays,
+                   std::string *perror_msg) {
+  return write_run_set_values(path, arrays, perror_msg);
+}
+
+RunSetFile::RunSetFile() : map_(nullptr), map_size_(0), offsets_(nullptr),
+                           payload_(nullptr) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+RunSetFile::~RunSetFile() {
+  close();
+}
+
+void RunSetFile::close() {
+  if (map_ != nullptr)
+    munmap(map_, map_size_);
+  map_      = nullptr;
+  map_size_ = 0;
+  offsets_  = nullptr;
+  payload_  = nullptr;
+  memset(&header_, 0, sizeof(header_));
+}
+
+bool RunSetFile::open(const std::string &path, std::string *perror_msg) {
+  close();
+  if (!is_little_endian()) {
+    *perror_msg = "Run-set files are read only on little-endian machines";
+    return false;
+  }
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    *perror_msg = run_set_error("Unable to open run-set file", path);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    *perror_msg = run_set_error("Unable to stat run-set file", path);
+    ::close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void  *map  = size >= sizeof(RunSetHeader)
+                ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                : MAP_FAILED;
+  int mmap_errno = errno;
+  ::close(fd);
+  if (size < sizeof(RunSetHeader)) {
+    *perror_msg = "Run-set file " + path + " is too short for its header";
+    return false;
+  }
+  if (map == MAP_FAILED) {
+    errno = mmap_errno;
+    *perror_msg = run_set_error("Unable to map run-set file", path);
+    return false;
+  }
+
+  // Check the header and offset table before trusting either; the values
+  // themselves are not read here.
+
+  RunSetHeader header;
+  memcpy(&header, map, sizeof(header));
+  const char *bytes = static_cast<const char *>(map);
+  std::string problem;
+  if (memcmp(header.magic, kRunSetMagic, sizeof(header.magic)) != 0) {
+    problem = "has no run-set magic number";
+  } else if (header.version != kRunSetVersion) {
+    problem = "has version " + std::to_string(header.version) + ", not "
+              + std::to_string(kRunSetVersion);
+  } else if (header.value_size != 4 && header.value_size != 8) {
+    problem = "has value size " + std::to_string(header.value_size);
+  } else if (   header.offsets_offset < sizeof(header)
+             || header.offsets_offset % sizeof(uint64_t) != 0
+             || header.offsets_offset > size - sizeof(uint64_t)
+             || header.nr_runs > (size - header.offsets_offset)
+                                 / sizeof(uint64_t) - 1
+             ||   header.offsets_offset
+                + (header.nr_runs + 1) * sizeof(uint64_t)
+                > header.payload_offset
+             || header.payload_offset % kRunSetAlignment != 0
+             || header.payload_offset > size
+             || header.nr_values > (size - header.payload_offset)
+                                   / header.value_size) {
+    problem = "has a header inconsistent with its size";
+  } else {
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(
+                                  bytes + header.offsets_offset);
+    bool ok = (offsets[0] == 0 && offsets[header.nr_runs] == header.nr_values);
+    for (uint64_t i = 0; ok && i < header.nr_runs; ++i)
+      ok = offsets[i] <= offsets[i + 1];
+    if (!ok)
+      problem = "has run offsets out of order or not matching nr_values";
+  }
+  if (!problem.empty()) {
+    munmap(map, size);
+    *perror_msg = "Run-set file " + path + " " + problem;
+    return false;
+  }
+
+  header_   = header;
+  map_      = map;
+  map_size_ = size;
+  offsets_  = reinterpret_cast<const uint64_t *>(bytes
+                                                 + header.offsets_offset);
+  payload_  = bytes + header.payload_offset;
+  return true;
+}
+
+// The runs of the file with the given header, offset table, and payload, as
+// ranges of const Value *, if the values are sizeof(Value) bytes; otherwise
+// none.
+
+template <typename Value>
+static std::vector<IteratorRange<const Value *> > value_ranges(
+    const RunSetHeader &header, const uint64_t *offsets, const char *payload) {
+  std::vector<IteratorRange<const Value *> > ranges;
+  if (header.value_size != sizeof(Value))
+    return ranges;
+  const Value *values = reinterpret_cast<const Value *>(payload);
+  ranges.reserve(header.nr_runs);
+  for (uint64_t i = 0; i < header.nr_runs; ++i) {
+    ranges.push_back(make_iterator_range(values + offsets[i],
+                                         values + offsets[i + 1]));
+  }
+  return ranges;
+}
+
+IntPointerRangeVector RunSetFile::int_ranges() const {
+  return value_ranges<int>(header_, offsets_, payload_);
+}
+
+Int64PointerRangeVector RunSetFile::int64_ranges() const {
+  return value_ranges<int64_t>(header_, offsets_, payload_);
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
@@ -0,0 +1,95 @@
+// cc/mmergerunset.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergerunset.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Run-set files: a whole merge input, k sorted runs, in one binary file that
+// every language version can read, so that all merge the same data and a
+// large dataset need not be generated again for each run.  The format,
+// specified in common/README.md, is a 64-byte header, a table of k + 1 run
+// offsets, and the runs' values one after another, 32- or 64-bit
+// little-endian.  RunSetFile maps a file into memory read-only and gives the
+// runs as ranges of pointers into the mapping, with nothing copied; pages
+// are read from the file as the merge first touches them.  Errors are
+// reported by returning false with a message in *perror_msg.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGERUNSET_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGERUNSET_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "./mmerge.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+typedef IteratorRange<const int *>      IntPointerRange;
+typedef std::vector<IntPointerRange>     IntPointerRangeVector;
+typedef IteratorRange<const int64_t *>  Int64PointerRange;
+typedef std::vector<Int64PointerRange>   Int64PointerRangeVector;
+
+// The fixed part of a run-set file, at its start.  offsets_offset and
+// payload_offset are byte offsets from the start of the file; the run
+// offsets are element indexes into the payload.
+
+struct RunSetHeader {
+  char     magic[8];        // "MMRUNSET", not null-terminated
+  uint32_t version;         // kRunSetVersion
+  uint32_t value_size;      // 4 or 8
+  uint64_t nr_runs;
+  uint64_t nr_values;
+  uint64_t offsets_offset;  // of nr_runs + 1 uint64_t run offsets
+  uint64_t payload_offset;  // of the values, a multiple of 64
+  uint64_t reserved[2];     // 0
+};
+
+const uint32_t kRunSetVersion = 1;
+
+// Writes arrays to the file named path as a run-set file of 32-bit values,
+// or of 64-bit values for the second overload.
+
+bool write_run_set(const std::string &path, const IntVectorVector &arrays,
+                   std::string *perror_msg);
+bool write_run_set(const std::string &path, const Int64VectorVector &arrays,
+                   std::string *perror_msg);
+
+// A run-set file mapped into memory.  The runs are valid until close or
+// destruction.
+
+class RunSetFile {
+ public:
+  RunSetFile();
+  ~RunSetFile();
+
+  // Maps the file named path, checking its header and offset table; closes
+  // any file already open first.
+  bool open(const std::string &path, std::string *perror_msg);
+  void close();
+
+  size_t nr_runs()    const { return header_.nr_runs; }
+  size_t nr_values()  const { return header_.nr_values; }
+  int    value_size() const { return header_.value_size; }
+  size_t run_length(size_t i) const { return offsets_[i + 1] - offsets_[i]; }
+
+  // The runs, if the values are 32-bit, or 64-bit for int64_ranges;
+  // otherwise none.
+  IntPointerRangeVector   int_ranges()   const;
+  Int64PointerRangeVector int64_ranges() const;
+
+ private:
+  RunSetFile(const RunSetFile &);
+  RunSetFile &operator=(const RunSetFile &);
+
+  RunSetHeader    header_;
+  void           *map_;
+  size_t          map_size_;
+  const uint64_t *offsets_;
+  const char     *payload_;
+};
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGERUNSET_H_
@@ -0,0 +1,90 @@
+// cc/mmergesort.cc rev. 17 October 2026 by Stuart Ambler.
+// Parallel sort by chunk sorts and a merge.  See cc/mmergesort.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+#include "./mmergesort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                       - start).count();
+}
+
+void parallel_sort(IntVector *pvalues, WorkStealingPool *ppool,
+                   MergeMethod method, SortStats *pstats) {
+  typedef std::vector<const int *> PointerVector;
+  IntVector &values     = *pvalues;
+  size_t     n          = values.size();
+  int        nr_threads = ppool->nr_threads();
+  size_t     nr_chunks  = nr_threads > 1 && n >= kMinParallelSortSize
+                          ? nr_threads * kSortChunksPerThread
+                          : 1;
+  size_t     steals_start = ppool->nr_steals();
+  if (method == kLinear)
+    method = kLoserTree;
+
+  auto start = std::chrono::steady_clock::now();
+  PointerVector its(nr_chunks);
+  PointerVector ends(nr_chunks);
+  for (size_t c = 0; c < nr_chunks; ++c) {
+    int *first = values.data() + n / nr_chunks * c
+                               + n % nr_chunks * c / nr_chunks;
+    int *last  = values.data() + n / nr_chunks * (c + 1)
+                               + n % nr_chunks * (c + 1) / nr_chunks;
+    its[c]  = first;
+    ends[c] = last;
+    ppool->submit([first, last]() { std::sort(first, last); });
+  }
+  ppool->wait();
+  double sort_sec = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  if (nr_chunks > 1) {
+    // The same division of the output as multimerge_par's, with the parts
+    // merged on the pool.
+    IntVector                  output(n);
+    std::vector<PointerVector> splits(nr_threads + 1);
+    std::vector<size_t>        ranks(nr_threads + 1);
+    splits[0]          = its;
+    ranks[0]           = 0;
+    splits[nr_threads] = ends;
+    ranks[nr_threads]  = n;
+    for (int t = 1; t < nr_threads; ++t) {
+      ranks[t] = n / nr_threads * t + n % nr_threads * t / nr_threads;
+      internal::corank(its, ends, ranks[t], std::less<int>(),
+                       KeyOfValue<int, int>(), &splits[t]);
+    }
+    for (int t = 0; t < nr_threads; ++t) {
+      ppool->submit([&, t]() {
+        PointerVector slice_its(splits[t]);
+        internal::merge_ranges<int>(&slice_its, splits[t + 1],
+                                    ranks[t + 1] - ranks[t],
+                                    output.data() + ranks[t], method,
+                                    std::less<int>(), KeyOfValue<int, int>());
+      });
+    }
+    ppool->wait();
+    values.swap(output);
+  }
+
+  if (pstats != nullptr) {
+    pstats->nr_chunks = nr_chunks;
+    pstats->nr_steals = ppool->nr_steals() - steals_start;
+    pstats->sort_sec  = sort_sec;
+    pstats->merge_sec = seconds_since(start);
+  }
+}
+
+void parallel_sort(IntVector *pvalues, int nr_threads) {
+  WorkStealingPool pool(nr_threads);
+  parallel_sort(pvalues, &pool, kLoserTree, nullptr);
+}
+
+}  // namespace com_zulazon_samples_cc_mmerge
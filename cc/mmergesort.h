@@ -0,0 +1,56 @@
+// cc/mmergesort.h rev. 17 October 2026 by Stuart Ambler.
+// Header for cc/mmergesort.cc.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Parallel sort of a vector of int with a merge as its final phase, the use
+// this code is most often put to.  The vector is cut into
+// kSortChunksPerThread equal chunks per thread of a WorkStealingPool, and
+// each chunk is sorted by std::sort as a task of the pool; more chunks than
+// threads let workers that finish early steal the chunks of those that do
+// not.  The sorted chunks are then merged as in multimerge_par: co-ranking
+// cuts the output into one part per thread, and each part is merged by the
+// method given as another task of the pool, into a buffer that replaces the
+// vector.  The buffer makes the peak memory twice the vector's.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGESORT_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGESORT_H_
+
+#include <cstddef>
+
+#include "./mmerge.h"
+#include "./mmergepool.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+const int kSortChunksPerThread = 4;
+
+// Vectors shorter than this, or sorted with a pool of one thread, are
+// sorted by std::sort alone.
+
+const size_t kMinParallelSortSize = 1 << 16;
+
+// The phases of a parallel sort, to see which dominates.
+
+struct SortStats {
+  size_t nr_chunks;   // 1 if sorted by std::sort alone
+  size_t nr_steals;   // chunk sorts and merges stolen by another worker
+  double sort_sec;    // wall time sorting the chunks
+  double merge_sec;   // wall time merging them
+};
+
+// Sorts *pvalues on the threads of *ppool, merging by method, which must be
+// kPriorityQueue, kLoserTree, or kGalloping.  If pstats is not null, sets
+// *pstats.
+
+void parallel_sort(IntVector *pvalues, WorkStealingPool *ppool,
+                   MergeMethod method, SortStats *pstats);
+
+// Sorts *pvalues on a pool of nr_threads threads made for the call
+// (nr_threads <= 0 means one per hardware thread), merging by loser tree.
+
+void parallel_sort(IntVector *pvalues, int nr_threads = 0);
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGESORT_H_
@@ -0,0 +1,259 @@
+// cc/mmergestream.h rev. 17 October 2026 by Stuart Ambler.
+// Header-only streaming merge of sorted streams fed by producer threads.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Merge of k sorted streams whose values arrive while the merge runs, each
+// from its own producer thread, as sorted chunks through a lock-free
+// single-producer single-consumer ring buffer, so that no stream need be
+// buffered whole before merging.  The merger keeps the streams' current
+// heads in a loser tree, as the loser tree method does.  A stream whose
+// chunk is used up and whose ring is empty stays in the tree as a pending
+// leaf, keyed by the last value taken from it, a lower bound on its next:
+// only when a pending leaf wins, that is when the stream could hold the
+// next value of the merge, does the merger wait for it, and then only if it
+// has no output to hand back first.  Equal values are output in the order
+// of the streams, as by the loser tree method.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGESTREAM_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGESTREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "./mmergetemplate.h"
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Lock-free bounded ring buffer for one producer thread and one consumer
+// thread.  The producer alone writes tail_ and the consumer alone head_;
+// each publishes its slot by a release store that the other's acquire load
+// sees, so no lock is needed.  The two indexes are kept on separate cache
+// lines so that the threads do not contend for one line.
+
+template <typename T>
+class SpscRing {
+ public:
+  // Holds capacity items, rounded up to a power of two.
+  explicit SpscRing(size_t capacity) : head_(0), tail_(0) {
+    size_t size = 1;
+    while (size < capacity)
+      size *= 2;
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+  SpscRing(const SpscRing &) = delete;
+  SpscRing & operator= (const SpscRing &) = delete;
+
+  // Producer: moves *pitem into the ring, or returns false if it is full.
+  bool try_push(T *pitem) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+      return false;
+    slots_[tail & mask_] = std::move(*pitem);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: moves the oldest item to *pitem, or returns false if empty.
+  bool try_pop(T *pitem) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    *pitem = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static const size_t kCacheLine = 64;
+
+  std::vector<T>      slots_;
+  size_t              mask_;
+  char                pad0_[kCacheLine];
+  std::atomic<size_t> head_;  // next slot to pop
+  char                pad1_[kCacheLine];
+  std::atomic<size_t> tail_;  // next slot to push
+  char                pad2_[kCacheLine];
+};
+
+// One sorted stream: a ring of chunks, vectors of values, that one producer
+// thread pushes and the merger pops.  Each chunk must be sorted and begin
+// no lower than the last chunk ended.
+
+template <typename Value>
+class BasicSortedStream {
+ public:
+  typedef std::vector<Value> Chunk;
+
+  // Holds up to capacity chunks before push waits.
+  explicit BasicSortedStream(size_t capacity) : ring_(capacity),
+                                                closed_(false) {}
+
+  // Producer: queues *pchunk, moving from it, waiting while the ring is
+  // full; empty chunks are allowed and skipped by the merger.
+  void push(Chunk *pchunk) {
+    while (!ring_.try_push(pchunk))
+      std::this_thread::yield();
+  }
+
+  // Producer: no more chunks follow.
+  void close() { closed_.store(true, std::memory_order_release); }
+
+  // Consumer: pops the next chunk into *pchunk, or returns false if there is
+  // none now.
+  bool try_pop(Chunk *pchunk) { return ring_.try_pop(pchunk); }
+
+  // Consumer: whether close was called; a chunk pushed before it may still
+  // be in the ring.
+  bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+ private:
+  SpscRing<Chunk>   ring_;
+  std::atomic<bool> closed_;
+};
+
+// Merger of the streams given, which must outlive it.  One consumer thread
+// only.
+
+template <typename Value, typename Compare = std::less<Value> >
+class BasicStreamMerger {
+ public:
+  typedef BasicSortedStream<Value> Stream;
+
+  explicit BasicStreamMerger(const std::vector<Stream *> &streams,
+                             Compare comp = Compare())
+      : streams_(streams), sources_(streams.size()),
+        tree_(streams.size(), comp), started_(false), nr_waits_(0) {}
+  BasicStreamMerger(const BasicStreamMerger &) = delete;
+  BasicStreamMerger & operator= (const BasicStreamMerger &) = delete;
+
+  // Writes up to n more values of the merge to out[0], ... and returns how
+  // many, as soon as it has n or would otherwise have to wait for a stream;
+  // it waits only when it has written nothing.  Returns 0 once every stream
+  // is closed and all its values merged.
+  size_t next_chunk(Value *out, size_t n) {
+    typedef typename internal::LoserTree<Value, Compare>::Node Node;
+    if (sources_.empty())
+      return 0;
+    if (!started_)
+      start();
+    Node   node;
+    size_t i = 0;
+    while (i < n && !tree_.winner_exhausted()) {
+      size_t  src    = tree_.winner().src;
+      Source &source = sources_[src];
+      if (source.pending) {
+        // The stream could hold the next value: only its next chunk tells.
+        if (!refill(src, i == 0))
+          break;
+      } else {
+        out[i++] = source.chunk[source.pos++];
+        if (source.pos == source.chunk.size())
+          refill(src, false);
+      }
+      leaf(src, &node);
+      tree_.replay(src, node);
+    }
+    return i;
+  }
+
+  // Times the merger waited for a stream that could hold the next value.
+  size_t nr_waits() const { return nr_waits_; }
+
+ private:
+  struct Source {
+    typename Stream::Chunk chunk;
+    size_t                 pos;
+    bool                   pending;    // chunk used up, next not yet here
+    bool                   exhausted;  // closed and all merged
+    Value                  last;       // last value merged, if pending
+  };
+
+  // Every stream could hold the first value, so all are waited for.
+  void start() {
+    std::vector<typename internal::LoserTree<Value, Compare>::Node>
+        leaves(sources_.size());
+    for (size_t src = 0; src < sources_.size(); ++src) {
+      sources_[src].pos       = 0;
+      sources_[src].pending   = true;
+      sources_[src].exhausted = false;
+      refill(src, true);
+      leaf(src, &leaves[src]);
+    }
+    tree_.build(&leaves);
+    started_ = true;
+  }
+
+  // Replaces the used-up chunk of stream src by its next nonempty one, or
+  // marks it exhausted if it is closed and has none; otherwise, if wait,
+  // waits for one of those, and if not, marks it pending and returns false.
+  bool refill(size_t src, bool wait) {
+    Source &source = sources_[src];
+    if (!source.chunk.empty())
+      source.last = source.chunk.back();
+    bool waited = false;
+    for (;;) {
+      bool popped = streams_[src]->try_pop(&source.chunk);
+      if (!popped && streams_[src]->closed()) {
+        // A chunk pushed before close is seen on this second look.
+        popped = streams_[src]->try_pop(&source.chunk);
+        if (!popped) {
+          source.pending   = false;
+          source.exhausted = true;
+          return true;
+        }
+      }
+      if (popped) {
+        if (!source.chunk.empty()) {
+          source.pos     = 0;
+          source.pending = false;
+          return true;
+        }
+        continue;
+      }
+      if (!wait) {
+        source.pending = true;
+        return false;
+      }
+      if (!waited)
+        ++nr_waits_;
+      waited = true;
+      std::this_thread::yield();
+    }
+  }
+
+  // Sets *pnode to the leaf of stream src: its head, or for a pending
+  // stream the last value merged from it.
+  void leaf(size_t src,
+            typename internal::LoserTree<Value, Compare>::Node *pnode) const {
+    const Source &source = sources_[src];
+    if (source.exhausted)
+      tree_.exhausted_leaf(src, pnode);
+    else if (source.pending)
+      tree_.leaf(source.last, src, pnode);
+    else
+      tree_.leaf(source.chunk[source.pos], src, pnode);
+  }
+
+  std::vector<Stream *>                   streams_;
+  std::vector<Source>                     sources_;
+  internal::LoserTree<Value, Compare>     tree_;
+  bool                                    started_;
+  size_t                                  nr_waits_;
+};
+
+typedef BasicSortedStream<int>          SortedStream;
+typedef BasicStreamMerger<int>          StreamMerger;
+typedef BasicSortedStream<int64_t>      Int64SortedStream;
+typedef BasicStreamMerger<int64_t>      Int64StreamMerger;
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGESTREAM_H_
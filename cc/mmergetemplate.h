@@ -0,0 +1,1310 @@
+// cc/mmergetemplate.h rev. 17 October 2026 by Stuart Ambler.
+// Header-only generic multimerge; cc/mmerge.cc instantiates it for int.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Merge of k sorted sequences of any element type Value, ordered by a Key
+// extracted from each element and a comparison Compare on keys, writing to an
+// output iterator.  The inputs are a container of ranges, each anything with
+// std::begin and std::end giving random access iterators: vectors, arrays,
+// or IteratorRange for parts of sequences.  Compare and KeyOf are template
+// parameters held by value, so calls to them can be inlined, unlike calls
+// through a function pointer.  As in cc/mmerge.h, the linear method is linear
+// in k and the priority queue and loser tree methods logarithmic in k.
+
+#ifndef _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGETEMPLATE_H_
+#define _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGETEMPLATE_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace com_zulazon_samples_cc_mmerge {
+
+// Choice of single-threaded merge method, where a function offers one.
+// kGalloping is the loser tree method with galloping: once one input has
+// won kMinGallop times in a row, the rest of its elements that would win in
+// turn are found by exponential search and copied as a block, as TimSort's
+// merge does for two runs.  It gains on clustered inputs, with long
+// stretches from one input, and costs little elsewhere.
+
+enum MergeMethod { kLinear, kPriorityQueue, kLoserTree, kGalloping };
+
+const size_t kMinGallop = 7;
+
+// A range [first, last) of a sequence, for merging parts of sequences.
+
+template <typename Iterator>
+struct IteratorRange {
+  Iterator first;
+  Iterator last;
+
+  Iterator begin() const { return first; }
+  Iterator end()   const { return last; }
+};
+
+template <typename Iterator>
+inline IteratorRange<Iterator> make_iterator_range(Iterator first,
+                                                   Iterator last) {
+  IteratorRange<Iterator> range = { first, last };
+  return range;
+}
+
+// Runs laid out flat, in compressed sparse row form: the values of all the
+// runs in one array, run i being values[offsets[i]] up to
+// values[offsets[i + 1]].  Two allocations however many runs, against one
+// per run for a vector of vectors, and the runs lie one after another in
+// memory, so that building a million tiny runs costs little and the
+// merge's iterators point into one block.  A container of ranges for the
+// templates below: iterating it gives each run as an IteratorRange of
+// pointers.
+
+template <typename Value>
+struct BasicFlatRuns {
+  typedef IteratorRange<const Value *> Range;
+
+  class const_iterator {
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef Range                   value_type;
+    typedef std::ptrdiff_t          difference_type;
+    typedef const Range            *pointer;
+    typedef Range                   reference;
+
+    const_iterator(const BasicFlatRuns *pruns, size_t i)
+        : pruns_(pruns), i_(i) {}
+    Range operator*() const { return (*pruns_)[i_]; }
+    const_iterator &operator++() { ++i_; return *this; }
+    bool operator==(const const_iterator &other) const {
+      return i_ == other.i_;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return i_ != other.i_;
+    }
+
+   private:
+    const BasicFlatRuns *pruns_;
+    size_t               i_;
+  };
+
+  BasicFlatRuns() : offsets(1, 0) {}
+
+  // The number of runs.
+  size_t size() const { return offsets.size() - 1; }
+  Range operator[](size_t i) const {
+    return make_iterator_range(values.data() + offsets[i],
+                               values.data() + offsets[i + 1]);
+  }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end()   const { return const_iterator(this, size()); }
+
+  void clear() {
+    values.clear();
+    offsets.assign(1, 0);
+  }
+  void reserve(size_t nr_runs, size_t nr_values) {
+    offsets.reserve(nr_runs + 1);
+    values.reserve(nr_values);
+  }
+  // Appends the run [first, last).
+  template <typename Iterator>
+  void push_back(Iterator first, Iterator last) {
+    values.insert(values.end(), first, last);
+    offsets.push_back(values.size());
+  }
+
+  std::vector<Value>  values;
+  std::vector<size_t> offsets;  // one more than the runs, the first 0
+};
+
+// Default key extraction: the element itself when Key and Value are the same
+// type, otherwise the first member, as for std::pair<Key, Payload>.
+
+template <typename Key, typename Value>
+struct KeyOfValue {
+  const Key &operator()(const Value &v) const { return v.first; }
+};
+
+template <typename Key>
+struct KeyOfValue<Key, Key> {
+  const Key &operator()(const Key &v) const { return v; }
+};
+
+// Whether keys have a greatest value that the loser tree can give exhausted
+// inputs, saving a test per comparison.  True for integer keys compared by
+// std::less.
+
+template <typename Key, typename Compare>
+struct MergeKeyTraits {
+  static const bool kHasSentinel = false;
+  static Key sentinel() { return Key(); }
+};
+
+template <typename Key>
+struct MergeKeyTraits<Key, std::less<Key> > {
+  static const bool kHasSentinel = std::is_integral<Key>::value;
+  static Key sentinel() { return std::numeric_limits<Key>::max(); }
+};
+
+// The iterator type of the ranges in a container of ranges.
+
+template <typename Ranges>
+using RangeIterator = decltype(std::begin(*std::begin(
+                                   std::declval<const Ranges &>())));
+
+// Total length of a container of ranges.
+
+template <typename Ranges>
+size_t total_length(const Ranges &inputs) {
+  size_t total_nr = 0;
+  for (auto ia = std::begin(inputs); ia != std::end(inputs); ++ia)
+    total_nr += std::distance(std::begin(*ia), std::end(*ia));
+  return total_nr;
+}
+
+// What multimerge_fenced did: the elements it copied whole, from parts of
+// runs that no other run overlaps, the elements it merged, and the windows
+// of overlapping runs it merged them in.
+
+struct FenceStats {
+  size_t nr_copied;
+  size_t nr_merged;
+  size_t nr_windows;
+};
+
+namespace internal {
+
+// Classes and typedef only for the priority queue method.
+
+template <typename Iterator>
+class IteratorPointerPair {
+ public:
+  IteratorPointerPair(const Iterator *e, Iterator *p) : ptr_end_(e),
+                                                        ptr_const_it_(p) {}
+  // Fields are accessed directly rather than through getters, which measured
+  // about 18% slower in the original version of this class for int.
+
+  // The range merged from one input is [*ptr_const_it_, *ptr_end_).
+  const Iterator *ptr_end_;      // *ptr_end_ ends the range
+  Iterator       *ptr_const_it_;  // **ptr_const_it_ must be an element of
+                                  // the range
+};
+
+template <typename Iterator, typename Compare, typename KeyOf>
+class IteratorPointerPairReverseCompare {
+ public:
+  IteratorPointerPairReverseCompare(Compare comp, KeyOf key_of)
+      : comp_(comp), key_of_(key_of) {}
+
+  bool operator()(const IteratorPointerPair<Iterator> &it0,
+                  const IteratorPointerPair<Iterator> &it1) const {
+    return comp_(key_of_(**(it1.ptr_const_it_)),
+                 key_of_(**(it0.ptr_const_it_)));
+  }
+
+ private:
+  Compare comp_;
+  KeyOf   key_of_;
+};
+
+// Struct and class only for the loser tree method.
+
+// A node of the loser tree: the current head key of one input, kept inline
+// so that replaying a path compares keys without going through an iterator,
+// and the index src of that input.  When the input is exhausted, src is
+// increased by the number of inputs, so that the node loses every comparison
+// with a node for a nonempty input; with a sentinel its key is also set to
+// the greatest key, and src alone decides ties with it.
+
+template <typename Key>
+struct LoserTreeNode {
+  Key    key;
+  size_t src;
+};
+
+// Loser tree laid out as a heap: leaf i (input i) is at index nr_sources + i,
+// the parent of index j is j / 2, internal nodes 1 through nr_sources - 1 hold
+// the loser of the match played there, and node 0 holds the overall winner.
+// This works for any nr_sources, not only powers of two.  Nodes are ordered
+// by key, then by input index, which makes the merge stable.
+
+template <typename Key, typename Compare>
+class LoserTree {
+ public:
+  typedef LoserTreeNode<Key>              Node;
+  typedef MergeKeyTraits<Key, Compare>    Traits;
+
+  LoserTree(size_t nr_sources, Compare comp) : comp_(comp) {
+    reset(nr_sources);
+  }
+
+  // Resizes the tree for nr_sources inputs, keeping storage already
+  // allocated, so that a tree reused for no more inputs allocates nothing.
+  void reset(size_t nr_sources) {
+    nr_sources_ = nr_sources;
+    tree_.resize(nr_sources);
+    winners_.resize(2 * nr_sources);
+  }
+
+  // Sets *pnode to be the leaf for input src, with head key key.
+  void leaf(const Key &key, size_t src, Node *pnode) const {
+    pnode->key = key;
+    pnode->src = src;
+  }
+
+  // Sets *pnode to be the leaf for exhausted input src.
+  void exhausted_leaf(size_t src, Node *pnode) const {
+    if (Traits::kHasSentinel)
+      pnode->key = Traits::sentinel();
+    pnode->src = src + nr_sources_;
+  }
+
+  bool less(const Node &n0, const Node &n1) const {
+    if (!Traits::kHasSentinel) {
+      bool x0 = n0.src >= nr_sources_;
+      bool x1 = n1.src >= nr_sources_;
+      if (x0 || x1)
+        return !x0 || (x1 && n0.src < n1.src);
+    }
+    return    comp_(n0.key, n1.key)
+           || (!comp_(n1.key, n0.key) && n0.src < n1.src);
+  }
+
+  // Plays all the matches, given the leaves in order of input.
+  void build(std::vector<Node> *pleaves) {
+    if (nr_sources_ == 0)
+      return;
+    std::vector<Node> &winners = winners_;
+    std::copy(pleaves->begin(), pleaves->end(),
+              winners.begin() + nr_sources_);
+    for (size_t j = nr_sources_ - 1; j > 0; --j) {
+      if (less(winners[2 * j + 1], winners[2 * j])) {
+        winners[j] = winners[2 * j + 1];
+        tree_[j]   = winners[2 * j];
+      } else {
+        winners[j] = winners[2 * j];
+        tree_[j]   = winners[2 * j + 1];
+      }
+    }
+    tree_[0] = winners[1];
+  }
+
+  const Node &winner() const { return tree_[0]; }
+
+  bool winner_exhausted() const { return tree_[0].src >= nr_sources_; }
+
+  // Replaces the leaf of the input src that was the winner by node, and
+  // replays the matches on the path from that leaf to the root.
+  void replay(size_t src, Node node) {
+    for (size_t j = (nr_sources_ + src) / 2; j > 0; j /= 2) {
+      if (less(tree_[j], node))
+        std::swap(tree_[j], node);
+    }
+    tree_[0] = node;
+  }
+
+  // The end of the block at the start of [first, last), the rest of the
+  // winner's input, that would win in turn before any other input's head:
+  // the elements that go before the runner-up, the least of the losers on
+  // the winner's path to the root.  Found by exponential search, testing
+  // the elements 1, 3, 7, ... after first, then binary search within the
+  // last step, so a block of m elements costs about 2 log2(m) comparisons.
+  // The winner must not be exhausted.
+  template <typename Iterator, typename KeyOf>
+  Iterator gallop(Iterator first, Iterator last, KeyOf key_of) const {
+    size_t      src     = tree_[0].src;
+    const Node *prunner = nullptr;
+    for (size_t j = (nr_sources_ + src) / 2; j > 0; j /= 2) {
+      if (prunner == nullptr || less(tree_[j], *prunner))
+        prunner = &tree_[j];
+    }
+    if (prunner == nullptr || prunner->src >= nr_sources_)
+      return last;
+    const Node &runner = *prunner;
+    auto before = [&](const typename std::iterator_traits<Iterator>::value_type
+                          &v) {
+      Node node;
+      leaf(key_of(v), src, &node);
+      return less(node, runner);
+    };
+
+    size_t n  = last - first;
+    size_t lo = 1;  // first[0], ..., first[lo - 1] go before the runner-up
+    size_t hi = 1;
+    while (hi < n && before(first[hi])) {
+      lo = hi + 1;
+      hi = 2 * hi + 1;
+    }
+    return std::partition_point(first + lo, first + std::min(hi, n), before);
+  }
+
+ private:
+  size_t            nr_sources_;
+  Compare           comp_;
+  std::vector<Node> tree_;
+  std::vector<Node> winners_;  // used only to build
+};
+
+// In C rather than STL terms (i.e. loosely speaking), minptrix is a function
+// to find the minimum key among the elements pointed to by the iterators
+// *pits into the ranges that end at ends, for the linear method.  Execution
+// time is linear in the number of ranges.  After finding the minimum, the
+// iterator that points to it is incremented.  It returns false if all the
+// iterators were at the ends of their ranges, otherwise true with *pmin
+// pointing to the minimum element.
+
+template <typename Iterator, typename Compare, typename KeyOf>
+bool minptrix(std::vector<Iterator> *pits, const std::vector<Iterator> &ends,
+              Compare comp, KeyOf key_of, Iterator *pmin) {
+  bool   did_examine = false;  // did examine an element of a range
+  size_t minix       = 0;
+
+  for (size_t i = 0; i < pits->size(); ++i) {
+    if ((*pits)[i] == ends[i])
+      continue;
+    if ((!did_examine) || comp(key_of(*(*pits)[i]), key_of(**pmin))) {
+      did_examine = true;
+      *pmin       = (*pits)[i];
+      minix       = i;
+    }
+  }
+
+  if (did_examine)
+    ++(*pits)[minix];
+
+  return did_examine;
+}
+
+// Linear merge of the ranges [(*pits)[i], ends[i]) into out.  Advances the
+// elements of *pits.
+
+template <typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_lin_ranges(std::vector<Iterator> *pits,
+                                const std::vector<Iterator> &ends,
+                                OutputIterator out,
+                                Compare comp, KeyOf key_of) {
+  Iterator min = Iterator();  // set by minptrix before use
+  while (minptrix(pits, ends, comp, key_of, &min))
+    *out++ = *min;
+  return out;
+}
+
+// Priority queue merge state: the heap of the ranges [(*pits)[i], ends[i])
+// given to push_ranges and not yet exhausted.  merge may be called
+// repeatedly, each call continuing where the last left off, which is how
+// BasicMergeCursor pulls batches.  *pits and ends must stay in place while
+// the merger is used.
+
+template <typename Iterator, typename Compare, typename KeyOf>
+class PriorityQueueMerger {
+ public:
+  PriorityQueueMerger(Compare comp, KeyOf key_of)
+      : pair_comp_(comp, key_of), pq_(pair_comp_) {}
+  PriorityQueueMerger(const PriorityQueueMerger &) = delete;
+  PriorityQueueMerger & operator= (const PriorityQueueMerger &) = delete;
+
+  void push_ranges(std::vector<Iterator> *pits,
+                   const std::vector<Iterator> &ends) {
+    for (size_t j = 0; j < pits->size(); ++j) {
+      if ((*pits)[j] != ends[j])
+        pq_.push(Pair(&ends[j], &(*pits)[j]));
+    }
+  }
+
+  bool empty() const { return pq_.empty(); }
+
+  // Reserves heap storage for nr ranges.  Only while empty.
+  void reserve(size_t nr) {
+    std::vector<Pair> heap;
+    heap.reserve(nr);
+    pq_ = PriorityQueue(pair_comp_, std::move(heap));
+  }
+
+  // Writes the next n elements, which must not be more than remain, to out;
+  // returns the end of the output.
+  template <typename OutputIterator>
+  OutputIterator merge(size_t n, OutputIterator out) {
+    Pair it_pval(nullptr, nullptr);
+
+    for (size_t i = 0; i < n; ++i) {
+      it_pval = pq_.top();
+      pq_.pop();
+      *out++ = **(it_pval.ptr_const_it_);
+      ++(*(it_pval.ptr_const_it_));
+      if (*(it_pval.ptr_const_it_) != *(it_pval.ptr_end_))
+        pq_.push(it_pval);
+    }
+
+    return out;
+  }
+
+ private:
+  typedef IteratorPointerPair<Iterator> Pair;
+  typedef IteratorPointerPairReverseCompare<Iterator, Compare, KeyOf>
+                                        PairReverseCompare;
+  typedef std::priority_queue<Pair, std::vector<Pair>, PairReverseCompare>
+                                        PriorityQueue;
+
+  PairReverseCompare pair_comp_;
+  PriorityQueue      pq_;
+};
+
+// Priority queue merge of the ranges [(*pits)[i], ends[i]), whose lengths
+// total total_nr, into out.  Advances the elements of *pits.
+
+template <typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_pq_ranges(std::vector<Iterator> *pits,
+                               const std::vector<Iterator> &ends,
+                               size_t total_nr, OutputIterator out,
+                               Compare comp, KeyOf key_of) {
+  PriorityQueueMerger<Iterator, Compare, KeyOf> merger(comp, key_of);
+  merger.push_ranges(pits, ends);
+  return merger.merge(total_nr, out);
+}
+
+// Builds *ptree for the ranges [its[i], ends[i]), with *pleaves for the
+// initial leaves; both are resized, keeping their storage.
+
+template <typename Key, typename Iterator, typename Compare, typename KeyOf>
+void build_loser_tree(const std::vector<Iterator> &its,
+                      const std::vector<Iterator> &ends,
+                      LoserTree<Key, Compare> *ptree,
+                      std::vector<LoserTreeNode<Key> > *pleaves,
+                      KeyOf key_of) {
+  size_t nr_ranges = its.size();
+  ptree->reset(nr_ranges);
+  pleaves->resize(nr_ranges);
+  for (size_t i = 0; i < nr_ranges; ++i) {
+    if (its[i] != ends[i])
+      ptree->leaf(key_of(*its[i]), i, &(*pleaves)[i]);
+    else
+      ptree->exhausted_leaf(i, &(*pleaves)[i]);
+  }
+  ptree->build(pleaves);
+}
+
+// Loser tree merge of the ranges [(*pits)[i], ends[i]), whose lengths total
+// total_nr, into out, in *ptree, with *pleaves for the initial leaves; both
+// are resized, keeping their storage.  Advances the elements of *pits.
+
+template <typename Key, typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_lt_ranges_with_tree(std::vector<Iterator> *pits,
+                                         const std::vector<Iterator> &ends,
+                                         size_t total_nr, OutputIterator out,
+                                         LoserTree<Key, Compare> *ptree,
+                                         std::vector<LoserTreeNode<Key> >
+                                             *pleaves,
+                                         KeyOf key_of) {
+  typedef LoserTreeNode<Key> Node;
+  if (pits->empty())
+    return out;
+
+  std::vector<Iterator>   &its  = *pits;
+  LoserTree<Key, Compare> &tree = *ptree;
+  build_loser_tree(its, ends, ptree, pleaves, key_of);
+
+  Node winner;
+  for (size_t i = 0; i < total_nr; ++i) {
+    size_t src = tree.winner().src;
+    *out++ = *its[src];
+    ++its[src];
+    if (its[src] != ends[src])
+      tree.leaf(key_of(*its[src]), src, &winner);
+    else
+      tree.exhausted_leaf(src, &winner);
+    tree.replay(src, winner);
+  }
+
+  return out;
+}
+
+// Loser tree merge of the ranges [(*pits)[i], ends[i]), whose lengths total
+// total_nr, into out.  Advances the elements of *pits.
+
+template <typename Key, typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_lt_ranges(std::vector<Iterator> *pits,
+                               const std::vector<Iterator> &ends,
+                               size_t total_nr, OutputIterator out,
+                               Compare comp, KeyOf key_of) {
+  LoserTree<Key, Compare>          tree(0, comp);
+  std::vector<LoserTreeNode<Key> > leaves;
+  return merge_lt_ranges_with_tree(pits, ends, total_nr, out, &tree, &leaves,
+                                   key_of);
+}
+
+// As merge_lt_ranges_with_tree, with galloping: after the same input has won
+// kMinGallop times in a row, the block of its elements that would win in
+// turn is copied at once (by memmove, for pointers or vector iterators to
+// trivially copyable elements) and its leaf replayed once.  The block ends
+// where the input's next element would lose to the runner-up, by key, then
+// by input index, so the output is the same as without galloping.
+
+template <typename Key, typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_gallop_ranges_with_tree(std::vector<Iterator> *pits,
+                                             const std::vector<Iterator>
+                                                 &ends,
+                                             size_t total_nr,
+                                             OutputIterator out,
+                                             LoserTree<Key, Compare> *ptree,
+                                             std::vector<LoserTreeNode<Key> >
+                                                 *pleaves,
+                                             KeyOf key_of) {
+  typedef LoserTreeNode<Key> Node;
+  if (pits->empty())
+    return out;
+
+  std::vector<Iterator>   &its  = *pits;
+  LoserTree<Key, Compare> &tree = *ptree;
+  build_loser_tree(its, ends, ptree, pleaves, key_of);
+
+  Node   winner;
+  size_t last_src = pits->size();
+  size_t nr_wins  = 0;  // in a row by last_src
+  for (size_t i = 0; i < total_nr; ) {
+    size_t src = tree.winner().src;
+    nr_wins    = src == last_src ? nr_wins + 1 : 1;
+    last_src   = src;
+    if (nr_wins < kMinGallop) {
+      *out++ = *its[src];
+      ++its[src];
+      ++i;
+    } else {
+      Iterator block_end = tree.gallop(its[src], ends[src], key_of);
+      out      = std::copy(its[src], block_end, out);
+      i       += block_end - its[src];
+      its[src] = block_end;
+      nr_wins  = 0;
+    }
+    if (its[src] != ends[src])
+      tree.leaf(key_of(*its[src]), src, &winner);
+    else
+      tree.exhausted_leaf(src, &winner);
+    tree.replay(src, winner);
+  }
+
+  return out;
+}
+
+template <typename Key, typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_gallop_ranges(std::vector<Iterator> *pits,
+                                   const std::vector<Iterator> &ends,
+                                   size_t total_nr, OutputIterator out,
+                                   Compare comp, KeyOf key_of) {
+  LoserTree<Key, Compare>          tree(0, comp);
+  std::vector<LoserTreeNode<Key> > leaves;
+  return merge_gallop_ranges_with_tree(pits, ends, total_nr, out, &tree,
+                                       &leaves, key_of);
+}
+
+// Co-ranking for the parallel method: sets *psplits to the positions in the
+// ranges [begins[i], ends[i]) at which the first rank elements of their
+// stable merge end, where the stable merge orders elements by key, then by
+// range index, then by position, as the loser tree does.  Keeps bounds
+// [lo[i], hi[i]] on each split position; each step takes the middle element
+// of the widest bounds as pivot, finds by binary search where every range
+// would be cut just before the pivot in that order, and, depending on whether
+// those cuts hold at least rank elements, makes them the upper or lower
+// bounds, at least halving the widest bounds.
+
+template <typename Iterator, typename Compare, typename KeyOf>
+void corank(const std::vector<Iterator> &begins,
+            const std::vector<Iterator> &ends,
+            size_t rank, Compare comp, KeyOf key_of,
+            std::vector<Iterator> *psplits) {
+  size_t nr_ranges = begins.size();
+  std::vector<Iterator> lo(begins);
+  std::vector<Iterator> hi(ends);
+  std::vector<Iterator> cuts(nr_ranges);
+  auto key_less = [&](const typename std::iterator_traits<Iterator>::value_type
+                          &v0,
+                      const typename std::iterator_traits<Iterator>::value_type
+                          &v1) {
+    return comp(key_of(v0), key_of(v1));
+  };
+
+  for (;;) {
+    size_t j     = 0;
+    size_t width = 0;
+    for (size_t i = 0; i < nr_ranges; ++i) {
+      if (static_cast<size_t>(hi[i] - lo[i]) > width) {
+        width = hi[i] - lo[i];
+        j     = i;
+      }
+    }
+    if (width == 0)
+      break;
+
+    Iterator pivot = lo[j] + width / 2;
+    size_t   nr_before = 0;
+    for (size_t i = 0; i < nr_ranges; ++i) {
+      if (i < j)
+        cuts[i] = std::upper_bound(lo[i], hi[i], *pivot, key_less);
+      else if (i > j)
+        cuts[i] = std::lower_bound(lo[i], hi[i], *pivot, key_less);
+      else
+        cuts[i] = pivot;
+      nr_before += cuts[i] - begins[i];
+    }
+    if (nr_before >= rank) {
+      hi.swap(cuts);
+    } else {
+      lo.swap(cuts);
+      ++lo[j];
+    }
+  }
+
+  psplits->swap(lo);
+}
+
+// Beginnings and ends of a container of ranges.
+
+template <typename Ranges>
+void input_ranges(const Ranges &inputs,
+                  std::vector<RangeIterator<Ranges> > *pits,
+                  std::vector<RangeIterator<Ranges> > *pends) {
+  pits->clear();
+  pends->clear();
+  for (auto ia = std::begin(inputs); ia != std::end(inputs); ++ia) {
+    pits->push_back(std::begin(*ia));
+    pends->push_back(std::end(*ia));
+  }
+}
+
+// Single-threaded merge of ranges by method.
+
+template <typename Key, typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_ranges(std::vector<Iterator> *pits,
+                            const std::vector<Iterator> &ends,
+                            size_t total_nr, OutputIterator out,
+                            MergeMethod method, Compare comp, KeyOf key_of) {
+  switch (method) {
+    case kLinear:
+      return merge_lin_ranges(pits, ends, out, comp, key_of);
+    case kPriorityQueue:
+      return merge_pq_ranges(pits, ends, total_nr, out, comp, key_of);
+    case kGalloping:
+      return merge_gallop_ranges<Key>(pits, ends, total_nr, out, comp,
+                                      key_of);
+    default:
+      return merge_lt_ranges<Key>(pits, ends, total_nr, out, comp, key_of);
+  }
+}
+
+// Merge of the ranges [its[i], ends[i]) split by their fences, their first
+// and last keys, into out; see multimerge_fenced.  The fences are swept in
+// key order, starts before ends at equal keys, counting the ranges that
+// cover each key: the windows are the closed intervals of keys that two or
+// more cover.  Each range is cut at the windows it meets, by binary search,
+// into pieces outside every window, which no other range overlaps, and
+// pieces inside one; the windows' pieces are kept in order of range, so
+// that merging them keeps the merge stable.  The copied pieces and the
+// windows, disjoint intervals of keys, are then written in order of their
+// first keys.
+
+template <typename Key, typename Iterator, typename OutputIterator,
+          typename Compare, typename KeyOf>
+OutputIterator merge_fenced_ranges(const std::vector<Iterator> &its,
+                                   const std::vector<Iterator> &ends,
+                                   OutputIterator out, MergeMethod method,
+                                   Compare comp, KeyOf key_of,
+                                   FenceStats *pstats) {
+  typedef typename std::iterator_traits<Iterator>::value_type Value;
+  struct Fence {
+    Key  key;
+    bool is_end;
+  };
+  struct Window {
+    Key                   first;
+    Key                   last;
+    std::vector<Iterator> its;
+    std::vector<Iterator> ends;
+    size_t                nr;
+  };
+  struct Piece {  // a piece to copy, or, with first == last, a window
+    Iterator first;
+    Iterator last;
+    size_t   window;
+  };
+
+  std::vector<Fence> fences;
+  for (size_t i = 0; i < its.size(); ++i) {
+    if (its[i] != ends[i]) {
+      fences.push_back(Fence{ key_of(*its[i]), false });
+      fences.push_back(Fence{ key_of(*(ends[i] - 1)), true });
+    }
+  }
+  std::sort(fences.begin(), fences.end(),
+            [&](const Fence &f0, const Fence &f1) {
+              return    comp(f0.key, f1.key)
+                     || (!comp(f1.key, f0.key) && !f0.is_end && f1.is_end);
+            });
+  std::vector<Window> windows;
+  size_t nr_covering = 0;
+  for (size_t f = 0; f < fences.size(); ++f) {
+    if (!fences[f].is_end && ++nr_covering == 2) {
+      windows.push_back(Window());
+      windows.back().first = fences[f].key;
+      windows.back().nr    = 0;
+    } else if (fences[f].is_end && nr_covering-- == 2) {
+      windows.back().last = fences[f].key;
+    }
+  }
+
+  auto value_less = [&](const Value &v, const Key &key) {
+    return comp(key_of(v), key);
+  };
+  auto less_value = [&](const Key &key, const Value &v) {
+    return comp(key, key_of(v));
+  };
+  std::vector<Piece> pieces;
+  for (size_t w = 0; w < windows.size(); ++w)
+    pieces.push_back(Piece{ Iterator(), Iterator(), w });
+  size_t nr_copied = 0;
+  for (size_t i = 0; i < its.size(); ++i) {
+    if (its[i] == ends[i])
+      continue;
+    const Key &last_key = key_of(*(ends[i] - 1));
+    Iterator   it       = its[i];
+    size_t w = std::lower_bound(windows.begin(), windows.end(),
+                                key_of(*it),
+                                [&](const Window &window, const Key &key) {
+                                  return comp(window.last, key);
+                                }) - windows.begin();
+    for (; w < windows.size() && !comp(last_key, windows[w].first); ++w) {
+      Iterator window_first = std::lower_bound(it, ends[i], windows[w].first,
+                                               value_less);
+      Iterator window_last  = std::upper_bound(window_first, ends[i],
+                                               windows[w].last, less_value);
+      if (window_first != it) {
+        pieces.push_back(Piece{ it, window_first, windows.size() });
+        nr_copied += window_first - it;
+      }
+      windows[w].its.push_back(window_first);
+      windows[w].ends.push_back(window_last);
+      windows[w].nr += window_last - window_first;
+      it = window_last;
+    }
+    if (it != ends[i]) {
+      pieces.push_back(Piece{ it, ends[i], windows.size() });
+      nr_copied += ends[i] - it;
+    }
+  }
+
+  std::sort(pieces.begin(), pieces.end(),
+            [&](const Piece &p0, const Piece &p1) {
+              return comp(p0.window < windows.size() ? windows[p0.window].first
+                                                     : key_of(*p0.first),
+                          p1.window < windows.size() ? windows[p1.window].first
+                                                     : key_of(*p1.first));
+            });
+  size_t nr_merged = 0;
+  for (size_t p = 0; p < pieces.size(); ++p) {
+    if (pieces[p].window == windows.size()) {
+      out = std::copy(pieces[p].first, pieces[p].last, out);
+    } else {
+      Window &window = windows[pieces[p].window];
+      out = merge_ranges<Key>(&window.its, window.ends, window.nr, out,
+                              method, comp, key_of);
+      nr_merged += window.nr;
+    }
+  }
+
+  if (pstats != nullptr) {
+    pstats->nr_copied  = nr_copied;
+    pstats->nr_merged  = nr_merged;
+    pstats->nr_windows = windows.size();
+  }
+  return out;
+}
+
+}  // namespace internal
+
+// Multimerge of the ranges in inputs, each sorted by key_of and comp, into
+// out, by method; returns the end of the output.  The loser tree and
+// galloping methods are stable: equal keys are output in the order of the
+// inputs holding them.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value>,
+          typename Ranges, typename OutputIterator>
+OutputIterator multimerge(const Ranges &inputs, OutputIterator out,
+                          MergeMethod method = kLoserTree,
+                          Compare comp = Compare(), KeyOf key_of = KeyOf()) {
+  std::vector<RangeIterator<Ranges> > its;
+  std::vector<RangeIterator<Ranges> > ends;
+  internal::input_ranges(inputs, &its, &ends);
+  return internal::merge_ranges<Key>(&its, ends, total_length(inputs), out,
+                                     method, comp, key_of);
+}
+
+// Multimerge as above, but first looking at each range's fences, its first
+// and last keys: the parts of ranges whose keys no other range's fences
+// enclose are copied whole, and only the windows of keys where ranges
+// overlap are merged, by method.  For runs that mostly do not overlap, such
+// as daily files, most elements are copied rather than compared; the cost is
+// a sort of the 2k fences and a few binary searches per run.  Stable if
+// method is.  If pstats is not null, sets *pstats.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value>,
+          typename Ranges, typename OutputIterator>
+OutputIterator multimerge_fenced(const Ranges &inputs, OutputIterator out,
+                                 FenceStats *pstats,
+                                 MergeMethod method = kLoserTree,
+                                 Compare comp = Compare(),
+                                 KeyOf key_of = KeyOf()) {
+  std::vector<RangeIterator<Ranges> > its;
+  std::vector<RangeIterator<Ranges> > ends;
+  internal::input_ranges(inputs, &its, &ends);
+  return internal::merge_fenced_ranges<Key>(its, ends, out, method, comp,
+                                            key_of, pstats);
+}
+
+// Pull-based priority queue multimerge of the ranges in inputs: rather than
+// writing the whole output at once, next_batch writes up to n more elements
+// of it to a buffer given by the caller, keeping the heap between calls, so
+// that a consumer can process the output in constant space as it is merged.
+// The inputs must outlive the cursor and not change while it is used.
+
+template <typename Iterator, typename Key,
+          typename Value = typename std::iterator_traits<Iterator>::value_type,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value> >
+class BasicMergeCursor {
+ public:
+  template <typename Ranges>
+  explicit BasicMergeCursor(const Ranges &inputs, Compare comp = Compare(),
+                            KeyOf key_of = KeyOf())
+      : remaining_(total_length(inputs)), merger_(comp, key_of) {
+    internal::input_ranges(inputs, &its_, &ends_);
+    merger_.push_ranges(&its_, ends_);
+  }
+  BasicMergeCursor(const BasicMergeCursor &) = delete;
+  BasicMergeCursor & operator= (const BasicMergeCursor &) = delete;
+
+  // Writes the next min(n, remaining()) elements of the merge to out[0], ...;
+  // returns the number written, 0 once the merge is done.
+  template <typename OutputIterator>
+  size_t next_batch(OutputIterator out, size_t n) {
+    if (n > remaining_)
+      n = remaining_;
+    merger_.merge(n, out);
+    remaining_ -= n;
+    return n;
+  }
+
+  size_t remaining() const { return remaining_; }
+  bool   done()      const { return remaining_ == 0; }
+
+ private:
+  size_t                                                remaining_;
+  std::vector<Iterator>                                 its_;
+  std::vector<Iterator>                                 ends_;
+  internal::PriorityQueueMerger<Iterator, Compare, KeyOf> merger_;
+};
+
+// Reusable multimerge: holds the iterator, heap, and loser tree storage that
+// multimerge allocates on each call, and keeps it from one merge to the next,
+// so that once it has grown to the largest number of inputs merged (or
+// reserve has been called for that number), a merge allocates nothing.  For
+// many small merges, where those allocations would cost as much as merging.
+// Not for use by more than one thread at a time.
+
+template <typename Iterator, typename Key,
+          typename Value = typename std::iterator_traits<Iterator>::value_type,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value> >
+class BasicMergeContext {
+ public:
+  explicit BasicMergeContext(Compare comp = Compare(), KeyOf key_of = KeyOf())
+      : comp_(comp), key_of_(key_of), pq_merger_(comp, key_of),
+        tree_(0, comp) {}
+  BasicMergeContext(const BasicMergeContext &) = delete;
+  BasicMergeContext & operator= (const BasicMergeContext &) = delete;
+
+  // Allocates storage for merges of up to nr_inputs inputs.
+  void reserve(size_t nr_inputs) {
+    its_.reserve(nr_inputs);
+    ends_.reserve(nr_inputs);
+    leaves_.reserve(nr_inputs);
+    tree_.reset(nr_inputs);
+    pq_merger_.reserve(nr_inputs);
+  }
+
+  // As multimerge: merges the ranges in inputs, whose iterators must be of
+  // type Iterator, into out by method; returns the end of the output.
+  template <typename Ranges, typename OutputIterator>
+  OutputIterator merge(const Ranges &inputs, OutputIterator out,
+                       MergeMethod method = kLoserTree) {
+    internal::input_ranges(inputs, &its_, &ends_);
+    size_t total_nr = total_length(inputs);
+    switch (method) {
+      case kLinear:
+        return internal::merge_lin_ranges(&its_, ends_, out, comp_, key_of_);
+      case kPriorityQueue:
+        pq_merger_.push_ranges(&its_, ends_);
+        return pq_merger_.merge(total_nr, out);
+      case kGalloping:
+        return internal::merge_gallop_ranges_with_tree(&its_, ends_, total_nr,
+                                                       out, &tree_, &leaves_,
+                                                       key_of_);
+      default:
+        return internal::merge_lt_ranges_with_tree(&its_, ends_, total_nr,
+                                                   out, &tree_, &leaves_,
+                                                   key_of_);
+    }
+  }
+
+ private:
+  Compare                                                 comp_;
+  KeyOf                                                   key_of_;
+  std::vector<Iterator>                                   its_;
+  std::vector<Iterator>                                   ends_;
+  internal::PriorityQueueMerger<Iterator, Compare, KeyOf> pq_merger_;
+  internal::LoserTree<Key, Compare>                       tree_;
+  std::vector<internal::LoserTreeNode<Key> >              leaves_;
+};
+
+namespace internal {
+
+// The number of threads a parallel merge of total_nr elements uses:
+// nr_threads, or one per hardware thread if nr_threads <= 0, but no more
+// than total_nr, and at least 1.
+
+inline int par_nr_threads(int nr_threads, size_t total_nr) {
+  if (nr_threads <= 0)
+    nr_threads = std::max(1U, std::thread::hardware_concurrency());
+  if (static_cast<size_t>(nr_threads) > total_nr)
+    nr_threads = std::max(static_cast<size_t>(1), total_nr);
+  return nr_threads;
+}
+
+// Cuts the ranges [its[i], ends[i]), of total_nr elements, into nr_threads
+// parts of equal size by co-ranking, and on one thread per part t calls
+// merge_part(t, &slice_its, slice_ends, nr, rank) for the part's slice of
+// each range, of nr elements in all, the first of them rank rank in the
+// merge.
+
+template <typename Iterator, typename Compare, typename KeyOf,
+          typename MergePart>
+void merge_parts_par(const std::vector<Iterator> &its,
+                     const std::vector<Iterator> &ends, size_t total_nr,
+                     int nr_threads, Compare comp, KeyOf key_of,
+                     const MergePart &merge_part) {
+  std::vector<std::vector<Iterator> > splits(nr_threads + 1);
+  std::vector<size_t>                 ranks(nr_threads + 1);
+  splits[0]          = its;
+  ranks[0]           = 0;
+  splits[nr_threads] = ends;
+  ranks[nr_threads]  = total_nr;
+  for (int t = 1; t < nr_threads; ++t) {
+    ranks[t] = total_nr / nr_threads * t + total_nr % nr_threads * t
+                                           / nr_threads;
+    corank(its, ends, ranks[t], comp, key_of, &splits[t]);
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(nr_threads);
+  for (int t = 0; t < nr_threads; ++t) {
+    threads.push_back(std::thread([&, t]() {
+      std::vector<Iterator> slice_its(splits[t]);
+      merge_part(t, &slice_its, splits[t + 1], ranks[t + 1] - ranks[t],
+                 ranks[t]);
+    }));
+  }
+  for (int t = 0; t < nr_threads; ++t)
+    threads[t].join();
+}
+
+}  // namespace internal
+
+// Parallel multimerge of the ranges in inputs into the random access out, in
+// the same order as the loser tree method.  The output is split into
+// nr_threads equal parts (nr_threads <= 0 means one per hardware thread);
+// co-ranking finds the slice of each input that belongs in each part, and
+// one thread per part merges its slices by method, which must be
+// kPriorityQueue, kLoserTree, or kGalloping, into its own part of the
+// output, sharing nothing with the other threads.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value>,
+          typename Ranges, typename RandomAccessIterator>
+void multimerge_par(const Ranges &inputs, RandomAccessIterator out,
+                    int nr_threads, MergeMethod method = kLoserTree,
+                    Compare comp = Compare(), KeyOf key_of = KeyOf()) {
+  typedef std::vector<RangeIterator<Ranges> > IteratorVector;
+  IteratorVector its;
+  IteratorVector ends;
+  internal::input_ranges(inputs, &its, &ends);
+  size_t total_nr = total_length(inputs);
+  nr_threads = internal::par_nr_threads(nr_threads, total_nr);
+  if (method == kLinear)
+    method = kLoserTree;
+
+  internal::merge_parts_par(its, ends, total_nr, nr_threads, comp, key_of,
+                            [&](int, IteratorVector *pslice_its,
+                                const IteratorVector &slice_ends, size_t nr,
+                                size_t rank) {
+    internal::merge_ranges<Key>(pslice_its, slice_ends, nr, out + rank,
+                                method, comp, key_of);
+  });
+}
+
+// Output iterator that hands each element assigned through it to a sink, a
+// function object called as (*psink)(value), rather than storing it.  Any
+// merge above given one, as multimerge_sink does, runs the sink on its
+// output as it is merged, so that a reduction of the output, such as a
+// count of distinct keys, costs no pass over a stored output.
+
+template <typename Sink>
+class SinkIterator {
+ public:
+  typedef std::output_iterator_tag iterator_category;
+  typedef void                     value_type;
+  typedef void                     difference_type;
+  typedef void                     pointer;
+  typedef void                     reference;
+
+  explicit SinkIterator(Sink *psink) : psink_(psink) {}
+
+  template <typename Value>
+  SinkIterator &operator=(const Value &value) {
+    (*psink_)(value);
+    return *this;
+  }
+  SinkIterator &operator*()    { return *this; }
+  SinkIterator &operator++()   { return *this; }
+  SinkIterator &operator++(int) { return *this; }
+
+ private:
+  Sink *psink_;
+};
+
+template <typename Sink>
+SinkIterator<Sink> sink_iterator(Sink *psink) {
+  return SinkIterator<Sink>(psink);
+}
+
+// Multimerge of the ranges in inputs as by multimerge, each element handed
+// to *psink in order as it is merged.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value>,
+          typename Ranges, typename Sink>
+void multimerge_sink(const Ranges &inputs, Sink *psink,
+                     MergeMethod method = kLoserTree,
+                     Compare comp = Compare(), KeyOf key_of = KeyOf()) {
+  multimerge<Key, Value>(inputs, sink_iterator(psink), method, comp, key_of);
+}
+
+// Parallel multimerge of the ranges in inputs as by multimerge_par, the
+// first thread's part handed in order to *psink and each other's to its own
+// copy of *psink emptied by clear(), and the copies joined in the order of
+// the parts into *psink by psink->join(copy), which must leave *psink as if
+// it had been handed the copy's elements after its own.  So a sink already
+// handed elements ends as if handed the merge after them, as from
+// multimerge_sink.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value>,
+          typename Ranges, typename Sink>
+void multimerge_par_sink(const Ranges &inputs, Sink *psink, int nr_threads,
+                         MergeMethod method = kLoserTree,
+                         Compare comp = Compare(), KeyOf key_of = KeyOf()) {
+  typedef std::vector<RangeIterator<Ranges> > IteratorVector;
+  IteratorVector its;
+  IteratorVector ends;
+  internal::input_ranges(inputs, &its, &ends);
+  size_t total_nr = total_length(inputs);
+  nr_threads = internal::par_nr_threads(nr_threads, total_nr);
+  if (method == kLinear)
+    method = kLoserTree;
+
+  Sink empty(*psink);
+  empty.clear();
+  std::vector<Sink> sinks(nr_threads, empty);
+  sinks[0] = std::move(*psink);
+  internal::merge_parts_par(its, ends, total_nr, nr_threads, comp, key_of,
+                            [&](int t, IteratorVector *pslice_its,
+                                const IteratorVector &slice_ends, size_t nr,
+                                size_t) {
+    internal::merge_ranges<Key>(pslice_its, slice_ends, nr,
+                                sink_iterator(&sinks[t]), method, comp,
+                                key_of);
+  });
+  *psink = std::move(sinks[0]);
+  for (int t = 1; t < nr_threads; ++t)
+    psink->join(sinks[t]);
+}
+
+// Sinks for merges of keys sorted by Compare: the number of distinct keys,
+// the number of elements of each key, and a histogram of the keys in
+// buckets of equal width.  Each keeps only what it reports, and each joins
+// another and clears for multimerge_par_sink.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value> >
+class BasicDistinctCount {
+ public:
+  explicit BasicDistinctCount(Compare comp = Compare(),
+                              KeyOf key_of = KeyOf())
+      : comp_(comp), key_of_(key_of), count_(0), first_(), last_() {}
+
+  void operator()(const Value &value) {
+    const Key &key = key_of_(value);
+    if (count_ == 0)
+      first_ = key;
+    else if (!comp_(last_, key))
+      return;
+    ++count_;
+    last_ = key;
+  }
+  void join(const BasicDistinctCount &next) {
+    if (next.count_ == 0)
+      return;
+    if (count_ == 0)
+      first_ = next.first_;
+    else if (!comp_(last_, next.first_))
+      --count_;
+    count_ += next.count_;
+    last_   = next.last_;
+  }
+  void clear() { count_ = 0; }
+
+  size_t count() const { return count_; }
+
+ private:
+  Compare comp_;
+  KeyOf   key_of_;
+  size_t  count_;
+  Key     first_;
+  Key     last_;
+};
+
+// The keys in order, each with the number of elements having it.
+
+template <typename Key, typename Value = Key,
+          typename Compare = std::less<Key>,
+          typename KeyOf = KeyOfValue<Key, Value> >
+class BasicGroupCount {
+ public:
+  typedef std::vector<std::pair<Key, size_t> > Groups;
+
+  explicit BasicGroupCount(Compare comp = Compare(), KeyOf key_of = KeyOf())
+      : comp_(comp), key_of_(key_of) {}
+
+  void operator()(const Value &value) {
+    const Key &key = key_of_(value);
+    if (groups_.empty() || comp_(groups_.back().first, key))
+      groups_.push_back(std::make_pair(key, static_cast<size_t>(1)));
+    else
+      ++groups_.back().second;
+  }
+  void join(const BasicGroupCount &next) {
+    auto it = next.groups_.begin();
+    if (   !groups_.empty() && it != next.groups_.end()
+        && !comp_(groups_.back().first, it->first))
+      groups_.back().second += (it++)->second;
+    groups_.insert(groups_.end(), it, next.groups_.end());
+  }
+  void clear() { groups_.clear(); }
+
+  const Groups &groups() const { return groups_; }
+
+ private:
+  Compare comp_;
+  KeyOf   key_of_;
+  Groups  groups_;
+};
+
+// Counts of integer keys in nr_buckets buckets of width keys from lo:
+// bucket b holds keys lo + b * width to lo + (b + 1) * width - 1.  Keys
+// below lo and past the last bucket are counted apart.  A width of 0 is
+// taken as 1.  Since the keys arrive sorted, most fall in the bucket of the
+// key before, found by one comparison without a division.
+
+template <typename Key, typename Value = Key,
+          typename KeyOf = KeyOfValue<Key, Value> >
+class BasicHistogram {
+ public:
+  BasicHistogram(Key lo, Key width, size_t nr_buckets,
+                 KeyOf key_of = KeyOf())
+      : key_of_(key_of), lo_(lo), width_(width == 0 ? 1 : width),
+        counts_(nr_buckets, 0),
+        nr_below_(0), nr_above_(0), bucket_(0), start_(0) {}
+
+  void operator()(const Value &value) {
+    const Key &key = key_of_(value);
+    if (key < lo_) {
+      ++nr_below_;
+      return;
+    }
+    UKey offset = static_cast<UKey>(key) - static_cast<UKey>(lo_);
+    if (offset - start_ < width_ && bucket_ < counts_.size()) {
+      ++counts_[bucket_];
+      return;
+    }
+    UKey b = offset / width_;
+    if (b >= counts_.size()) {
+      ++nr_above_;
+      return;
+    }
+    bucket_ = b;
+    start_  = b * width_;
+    ++counts_[bucket_];
+  }
+  void join(const BasicHistogram &next) {
+    for (size_t b = 0; b < counts_.size(); ++b)
+      counts_[b] += next.counts_[b];
+    nr_below_ += next.nr_below_;
+    nr_above_ += next.nr_above_;
+  }
+  void clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    nr_below_ = 0;
+    nr_above_ = 0;
+    bucket_   = 0;
+    start_    = 0;
+  }
+
+  const std::vector<size_t> &counts() const { return counts_; }
+  size_t nr_below() const { return nr_below_; }
+  size_t nr_above() const { return nr_above_; }
+
+ private:
+  typedef typename std::make_unsigned<Key>::type UKey;
+
+  KeyOf               key_of_;
+  Key                 lo_;
+  UKey                width_;
+  std::vector<size_t> counts_;
+  size_t              nr_below_;
+  size_t              nr_above_;
+  size_t              bucket_;  // of the last key counted, and its
+  UKey                start_;   // offset from lo
+};
+
+}  // namespace com_zulazon_samples_cc_mmerge
+
+#endif  // _HOME_STUART_PROJECTS_SAMPLES_CC_MMERGETEMPLATE_H_
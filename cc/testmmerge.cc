@@ -1,53 +1,229 @@
-// cc/testmmerge.cc rev. 28 December 2013 by Stuart Ambler.  Tests cc/mmerge.cc.
+// cc/testmmerge.cc rev. 17 October 2026 by Stuart Ambler.  Tests cc/mmerge.cc.
 // Copyright (c) 2013 Stuart Ambler.
 // Distributed under the Boost License in the accompanying file LICENSE.
 
 // Tests multi-way merge of k sorted arrays of int, total length n, in memory,
-// using either a simple algorithm linear in k, or instead an algorithm that
-// uses a priority queue, logarithmic in k.  Either way, the dependence on n
-// is linear.  No exception or other error handling.  streams are used in this
-// test code despite discouragement for Google style.
+// using either a simple algorithm linear in k, or instead algorithms that
+// use a priority queue or a loser tree, logarithmic in k.  Either way, the
+// dependence on n is linear.  No exception or other error handling.
+// streams are used in this test code despite discouragement for Google
+// style.
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
 #include <sstream>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 #include <argtable2.h>
 #include "./mmerge.h"
+#include "./mmergeauto.h"
+#include "./mmergebatch.h"
+#include "./mmergebench.h"
+#include "./mmergeext.h"
+#include "./mmergeinplace.h"
+#include "./mmergepack.h"
+#include "./mmergerunset.h"
+#include "./mmergesort.h"
+#include "./mmergestream.h"
 #include "./testmmerge.h"
 
 namespace mm = ::com_zulazon_samples_cc_mmerge;
 
+// Count of calls to operator new, for the small-merge benchmark's report of
+// allocations per merge.  Replacing the global operator new here counts every
+// allocation in the program, including those inside the standard library.
+// noinline keeps g++ from seeing free applied to memory from operator new,
+// which it warns of.
+
+static std::atomic<size_t> nr_allocations(0);
+
+__attribute__((noinline)) void *operator new(size_t size) {
+  ++nr_allocations;
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  free(p);
+}
+
+// Input distributions generate_data can make; see usage().
+
+enum Distribution {
+  kDistUniform,
+  kDistZipf,
+  kDistDuplicates,
+  kDistDisjoint,
+  kDistSimilar,
+  kDistGiant,
+  kDistClustered,
+  kNrDistributions
+};
+
+static const char *const kDistributionNames[kNrDistributions] = {
+  "uniform", "zipf", "dups", "disjoint", "similar", "giant",
+  "clustered"
+};
+
+// Configuration from the command line; see usage().  testmmerge_main sets the
+// defaults before calling get_cfg.
+
+struct TestCfg {
+  int         nr_inputs;
+  int         ave_input_len;
+  Distribution distribution;
+  unsigned int seed;              // for generate_data
+  int         nr_threads;         // for the parallel method; 0 for hardware
+  bool        do_multimerge_lin;
+  bool        do_wide_keys;       // also benchmark 64-bit keys
+  std::string external_dir;       // for run files; empty for no external test
+  int         memory_budget_mb;   // for the external merge's buffers
+  std::string calibration_path;   // for multimerge_auto; empty for none
+  int         nr_small_merges;    // for the small-merge benchmark; 0 for none
+  bool        do_sort;            // benchmark parallel_sort instead
+  int         nr_batch_jobs;      // for the batch benchmark; 0 for none
+  bool        do_flat;            // benchmark the flat layout instead
+  bool        do_inplace;         // benchmark the in-place merge instead
+  bool        do_fused;           // benchmark fused merges instead
+  mm::BenchmarkCfg bench;         // warmups and trials of each benchmark
+  std::string json_path;          // for the benchmark report; empty for none
+  std::string input_path;         // run-set file to merge instead of
+                                  // generated data; empty for none
+  std::string output_path;        // run-set file to write the generated
+                                  // data to; empty for none
+  bool        count_hardware;     // read hardware counters if available
+};
+
 // Print program usage.
 
 void usage() {
   const char *s = "Test mmerge k-way merge.\n"
 "\n"
 "Usage:\n"
-"  ./testmmerge [-l]\n"
-"  ./testmmerge <nr_inputs> [-l]\n"
-"  ./testmmerge <nr_inputs> <ave_input_len> [-l]\n"
+"  ./testmmerge [options]\n"
+"  ./testmmerge <nr_inputs> [options]\n"
+"  ./testmmerge <nr_inputs> <ave_input_len> [options]\n"
 "  ./testmmerge -h | --help\n"
 "\n"
 "Arguments:\n"
 "  <nr_inputs>      Number of sorted input arrays to generate; must be\n"
 "                   positive and its product with ave_input_len no more\n"
-"                   than 500 million.  [default: 1000]\n"
+"                   than 1 billion.  [default: 1000]\n"
 "  <ave_input_len>  Desired average length of sorted input arrays to\n"
 "                   generate; must be positive and its product with\n"
-"                   nr_inputs no more than 500 million [default: 10000].\n"
+"                   nr_inputs no more than 1 billion [default: 10000].\n"
 "\n"
 "Options:\n"
 "  -h --help        Show this help message and exit.\n"
-"  -l               Test slower linear method as well as priority queue method."
-"\n";
+"  -l               Test slower linear method as well as priority queue and\n"
+"                   loser tree methods.\n"
+"  -t <nr_threads>  Number of threads for the parallel method; 0 means one\n"
+"                   per hardware thread [default: 0].\n"
+"  -e <dir>         Also test the external merge, writing one run file per\n"
+"                   input array and the output file in directory dir, which\n"
+"                   must exist; the files are removed afterwards.\n"
+"  -m <mb>          Memory budget in megabytes for the external merge's\n"
+"                   buffers [default: 64].\n"
+"  -c <file>        Calibration table for the automatic choice of method:\n"
+"                   read from file if it exists, otherwise made by a\n"
+"                   calibration run and written to file.  Without -c the\n"
+"                   calibration run is made and not saved.\n"
+"  -s <nr_merges>   Instead of the tests above, benchmark nr_merges small\n"
+"                   merges of nr_inputs arrays of about ave_input_len each,\n"
+"                   with and without a reused MergeContext, reporting\n"
+"                   merges per second and allocations per merge.\n"
+"  -q               Instead of the tests above, benchmark parallel_sort\n"
+"                   against std::sort and std::stable_sort on random ints,\n"
+"                   n = 10^4, 10^5, ... and nr_inputs * ave_input_len,\n"
+"                   reporting the times of its chunk sorts and its merge.\n"
+"  -a <nr_jobs>     Instead of the tests above, benchmark batches of 100,\n"
+"                   1000, ... and nr_jobs independent merges, each of 4 to\n"
+"                   64 arrays of about ave_input_len, one at a time and by\n"
+"                   multimerge_batch on 1, 2, 4, ... and nr_threads\n"
+"                   threads, reporting jobs per second and job latency.\n"
+"  -f               Instead of the tests above, benchmark building the\n"
+"                   generated data as an IntVectorVector and as FlatRuns,\n"
+"                   one buffer of values and one of offsets, and merging\n"
+"                   each by the priority queue, loser tree, galloping, and\n"
+"                   parallel methods; for many short arrays, such as\n"
+"                   1000000 10.\n"
+"  -n               Instead of the tests above, benchmark merging the\n"
+"                   generated data, stored as FlatRuns, in place with\n"
+"                   bounded memory, serially and in parallel, against\n"
+"                   multimerge_pq, and report each merge's peak resident\n"
+"                   set size.\n"
+"  -v               Instead of the tests above, benchmark reducing the\n"
+"                   merge of the generated data to its number of distinct\n"
+"                   values, the count of each value, and a histogram,\n"
+"                   merged then scanned and fused into the merge, each\n"
+"                   serially and in parallel.\n"
+"  -w <nr_warmups>  Untimed runs of each benchmark before the timed ones\n"
+"                   [default: 0].\n"
+"  -r <nr_trials>   Timed runs of each benchmark, summarized by median,\n"
+"                   95th percentile, and mean with 95% confidence\n"
+"                   interval [default: 1].\n"
+"  -j <file>        Write the benchmark results to file as JSON.\n"
+"  -d <name>        Distribution of the generated data [default: uniform]:\n"
+"                     uniform   lengths uniform from about ave_input_len / 10\n"
+"                               to twice ave_input_len less that, values of\n"
+"                               each array drawn on its own, uniform from 1\n"
+"                               to about n, so that values repeat across\n"
+"                               arrays\n"
+"                     zipf      lengths proportional to 1 / rank, in random\n"
+"                               order, values as uniform\n"
+"                     dups      as uniform, but values from 1 to about\n"
+"                               n / 1000, about 1000 copies of each\n"
+"                     disjoint  as uniform, but each array a consecutive\n"
+"                               range of values, the ranges in random order\n"
+"                     similar   arrays of ave_input_len the same but for\n"
+"                               about 1% of their values\n"
+"                     giant     one array of about half of n, the rest of\n"
+"                               ave_input_len / 100, values as uniform\n"
+"                     clustered as uniform, but each array stretches of\n"
+"                               1000 consecutive values, the stretches of\n"
+"                               all arrays in random order, as for\n"
+"                               time-partitioned logs\n"
+"  -g <seed>        Seed for the generated data, which is the same for the\n"
+"                   same seed whatever the number of threads [default: 1].\n"
+"  -i <file>        Instead of generating data, map the run-set file (see\n"
+"                   common/README.md) into memory and benchmark the\n"
+"                   priority queue, loser tree, galloping, parallel, and\n"
+"                   with -l linear methods on its runs in place;\n"
+"                   nr_inputs and ave_input_len are ignored.\n"
+"  -o <file>        Write the generated data to file as a run-set file.\n"
+"  -b               Also benchmark the priority queue, loser tree, and\n"
+"                   parallel methods on the data widened to int64_t and to\n"
+"                   uint64_t keys, in the same order, and report their\n"
+"                   rates relative to those for int.\n"
+"  -p               Also count cycles, instructions, L1 data cache, last\n"
+"                   level cache, and data TLB misses, and branch misses\n"
+"                   per element of each benchmark, by Linux perf_event_open,\n"
+"                   where available; otherwise report timings alone.\n";
   std::cout << s;
 }
 
 // Get and process command-line arguments.  See usage().
 
-void get_cfg(int argc, char *argv[], int max_nr_input_ints,
-             int *p_nr_inputs, int *p_ave_input_len,
-             bool *p_do_multimerge_lin, bool *p_help_only, bool *p_error) {
+void get_cfg(int argc, char *argv[], int max_nr_input_ints, TestCfg *pcfg,
+             bool *p_help_only, bool *p_error) {
   struct arg_lit *help = arg_lit0("h", "help",
                                   "Show help message and exit.");
   struct arg_lit *lin  = arg_lit0("l", NULL,
@@ -56,8 +232,48 @@ void get_cfg(int argc, char *argv[], int max_nr_input_ints,
                                   "Number of sorted input arrays to generate.");
   struct arg_int *len  = arg_int0(NULL, NULL, "<ave_input_len>",
                                   "Desired averagel length of sorted input arrays.");
+  struct arg_int *thr  = arg_int0("t", "threads", "<nr_threads>",
+                                  "Number of threads for the parallel method.");
+  struct arg_str *ext  = arg_str0("e", "external", "<dir>",
+                                  "Directory for external merge files.");
+  struct arg_int *mem  = arg_int0("m", "memory", "<mb>",
+                                  "Memory budget for the external merge.");
+  struct arg_str *cal  = arg_str0("c", "calibration", "<file>",
+                                  "Calibration table for the automatic method.");
+  struct arg_int *sml  = arg_int0("s", "small", "<nr_merges>",
+                                  "Number of merges for the small-merge benchmark.");
+  struct arg_lit *srt  = arg_lit0("q", "sort",
+                                  "Benchmark parallel_sort.");
+  struct arg_int *bat  = arg_int0("a", "batch", "<nr_jobs>",
+                                  "Benchmark batches of small merges.");
+  struct arg_lit *flt  = arg_lit0("f", "flat",
+                                  "Benchmark the flat layout of runs.");
+  struct arg_lit *inl  = arg_lit0("n", "inplace",
+                                  "Benchmark the in-place merge.");
+  struct arg_lit *fus  = arg_lit0("v", "fused",
+                                  "Benchmark fused merge and aggregate.");
+  struct arg_int *wrm  = arg_int0("w", "warmups", "<nr_warmups>",
+                                  "Untimed runs of each benchmark.");
+  struct arg_int *trl  = arg_int0("r", "trials", "<nr_trials>",
+                                  "Timed runs of each benchmark.");
+  struct arg_str *jsn  = arg_str0("j", "json", "<file>",
+                                  "File for the benchmark results as JSON.");
+  struct arg_lit *prf  = arg_lit0("p", "perf",
+                                  "Count hardware events per element.");
+  struct arg_str *dst  = arg_str0("d", "distribution", "<name>",
+                                  "Distribution of the generated data.");
+  struct arg_int *sed  = arg_int0("g", "seed", "<seed>",
+                                  "Seed for the generated data.");
+  struct arg_str *inp  = arg_str0("i", "input", "<file>",
+                                  "Run-set file to merge.");
+  struct arg_str *out  = arg_str0("o", "output", "<file>",
+                                  "Run-set file for the generated data.");
+  struct arg_lit *wid  = arg_lit0("b", "wide",
+                                  "Also benchmark 64-bit keys.");
   struct arg_end *end  = arg_end(20);
-  void *argtable[]     = { help, lin, nr, len, end };
+  void *argtable[]     = { help, lin, thr, ext, mem, cal, sml, srt, bat, flt,
+                           inl, fus, wrm, trl, jsn, prf, dst, sed, inp, out,
+                           wid, nr, len, end };
   if (arg_nullcheck(argtable) != 0) {
     std::cout << "Insufficient memory to parse command-line arguments.\n"
               << std::endl;
@@ -72,20 +288,86 @@ void get_cfg(int argc, char *argv[], int max_nr_input_ints,
       return;
     }
     if (lin->count > 0)
-      *p_do_multimerge_lin = true;
+      pcfg->do_multimerge_lin = true;
     if (nr->count > 0)
-      *p_nr_inputs = nr->ival[0];
+      pcfg->nr_inputs = nr->ival[0];
     if (len->count > 0)
-      *p_ave_input_len = len->ival[0];
-    if (   *p_nr_inputs <= 0 || *p_ave_input_len <= 0
-           ||   (long) (*p_nr_inputs) * (long) (*p_ave_input_len)
+      pcfg->ave_input_len = len->ival[0];
+    if (thr->count > 0)
+      pcfg->nr_threads = thr->ival[0];
+    if (ext->count > 0)
+      pcfg->external_dir = ext->sval[0];
+    if (mem->count > 0)
+      pcfg->memory_budget_mb = mem->ival[0];
+    if (cal->count > 0)
+      pcfg->calibration_path = cal->sval[0];
+    if (sml->count > 0)
+      pcfg->nr_small_merges = sml->ival[0];
+    if (srt->count > 0)
+      pcfg->do_sort = true;
+    if (bat->count > 0)
+      pcfg->nr_batch_jobs = bat->ival[0];
+    if (flt->count > 0)
+      pcfg->do_flat = true;
+    if (inl->count > 0)
+      pcfg->do_inplace = true;
+    if (fus->count > 0)
+      pcfg->do_fused = true;
+    if (wrm->count > 0)
+      pcfg->bench.nr_warmups = wrm->ival[0];
+    if (trl->count > 0)
+      pcfg->bench.nr_trials = trl->ival[0];
+    if (jsn->count > 0)
+      pcfg->json_path = jsn->sval[0];
+    if (prf->count > 0)
+      pcfg->count_hardware = true;
+    if (sed->count > 0)
+      pcfg->seed = sed->ival[0];
+    if (inp->count > 0)
+      pcfg->input_path = inp->sval[0];
+    if (out->count > 0)
+      pcfg->output_path = out->sval[0];
+    if (wid->count > 0)
+      pcfg->do_wide_keys = true;
+    if (dst->count > 0) {
+      int d = 0;
+      while (   d < kNrDistributions
+             && strcmp(kDistributionNames[d], dst->sval[0]) != 0)
+        ++d;
+      if (d == kNrDistributions) {
+        std::cout << "Unknown distribution " << dst->sval[0] << "."
+                  << std::endl;
+        usage();
+        *p_error = true;
+        return;
+      }
+      pcfg->distribution = static_cast<Distribution>(d);
+    }
+    if (   pcfg->nr_threads < 0 || pcfg->memory_budget_mb <= 0
+        || pcfg->nr_small_merges < 0 || pcfg->nr_batch_jobs < 0
+        || pcfg->bench.nr_warmups < 0
+        || pcfg->bench.nr_trials <= 0) {
+      std::cout << "nr_threads (" << pcfg->nr_threads
+                << "), nr_merges (" << pcfg->nr_small_merges
+                << "), nr_jobs (" << pcfg->nr_batch_jobs
+                << "), and nr_warmups (" << pcfg->bench.nr_warmups
+                << ") must not be negative, and mb ("
+                << pcfg->memory_budget_mb << ") and nr_trials ("
+                << pcfg->bench.nr_trials << ") must be positive."
+                << std::endl;
+      usage();
+      *p_error = true;
+      return;
+    }
+    if (   pcfg->nr_inputs <= 0 || pcfg->ave_input_len <= 0
+           ||   (long) (pcfg->nr_inputs) * (long) (pcfg->ave_input_len)
               > (long) max_nr_input_ints) {
-      std::cout << "nr_inputs (" << *p_nr_inputs << ") and ave_input len ("
-                << *p_ave_input_len << ") must be strictly positive,"
+      std::cout << "nr_inputs (" << pcfg->nr_inputs << ") and ave_input len ("
+                << pcfg->ave_input_len << ") must be strictly positive,"
                 << std::endl
                 << "and their product "
-                <<   static_cast<long>(*p_nr_inputs)
-                   * static_cast<long>(*p_ave_input_len)
+                <<   static_cast<long>(pcfg->nr_inputs)
+                   * static_cast<long>(pcfg->ave_input_len)
                 << ", the total number of ints to merge," << std::endl
                 << "no greater than   " << max_nr_input_ints << "."
                 << std::endl;
@@ -135,6 +417,57 @@ bool verify_small_data() {
     retval = false;
   }
 
+  mm::multimerge_lt(arrays, &output);
+  print_iv("multimerge lt     small data", output);
+  if (output != correctOutput) {
+    std::cout << "multimerge lt  differs from correctOutput" << std::endl;
+    retval = false;
+  }
+
+  mm::multimerge_gallop(arrays, &output);
+  print_iv("multimerge gallop small data", output);
+  if (output != correctOutput) {
+    std::cout << "multimerge gallop differs from correctOutput" << std::endl;
+    retval = false;
+  }
+
+  mm::multimerge_fenced(arrays, &output, mm::kLoserTree, nullptr);
+  print_iv("multimerge fenced small data", output);
+  if (output != correctOutput) {
+    std::cout << "multimerge fenced differs from correctOutput" << std::endl;
+    retval = false;
+  }
+
+  // Batch sizes that do and do not divide the output length.
+
+  for (int batch = 1; batch <= 5; ++batch) {
+    mm::MergeCursor cursor(arrays);
+    int buffer[5];
+    output.clear();
+    size_t nr;
+    while ((nr = cursor.next_batch(buffer, batch)) > 0)
+      output.insert(output.end(), buffer, buffer + nr);
+    if (output != correctOutput || !cursor.done()) {
+      print_iv("multimerge cursor small data", output);
+      std::cout << "MergeCursor differs from correctOutput with batches of "
+                << batch << std::endl;
+      retval = false;
+    }
+  }
+
+  // Thread counts chosen so that the splits fall between and within runs of
+  // equal values.
+
+  for (int nr_threads = 1; nr_threads <= 5; ++nr_threads) {
+    mm::multimerge_par(arrays, &output, nr_threads, mm::kLoserTree);
+    if (output != correctOutput) {
+      print_iv("multimerge par    small data", output);
+      std::cout << "multimerge par differs from correctOutput with "
+                << nr_threads << " threads" << std::endl;
+      retval = false;
+    }
+  }
+
   mm::multimerge(arrays, &output);
   print_iv("multimerge linear small data", output);
   if (output != correctOutput) {
@@ -142,60 +475,675 @@ bool verify_small_data() {
     retval = false;
   }
 
+  mm::multimerge_simd(arrays, &output);
+  print_iv("multimerge simd   small data", output);
+  if (output != correctOutput) {
+    std::cout << "multimerge simd differs from correctOutput" << std::endl;
+    retval = false;
+  }
+
+  // Empty inputs and INT_MAX values, which the loser tree must not confuse
+  // with its marking of exhausted inputs.
+
+  int e1[] = { 3, INT_MAX, INT_MAX };
+  int e3[] = { INT_MIN, 3 };
+  int e13[] = { INT_MIN, 3, 3, INT_MAX, INT_MAX };
+  mm::IntVector edgeOutput(e13, e13 + sizeof(e13) / sizeof(e13[0]));
+  mm::IntVectorVector edge_arrays;
+  edge_arrays.push_back(mm::IntVector(e1, e1 + sizeof(e1) / sizeof(e1[0])));
+  edge_arrays.push_back(mm::IntVector());
+  edge_arrays.push_back(mm::IntVector(e3, e3 + sizeof(e3) / sizeof(e3[0])));
+  edge_arrays.push_back(mm::IntVector());
+
+  mm::multimerge_lt(edge_arrays, &output);
+  print_iv("multimerge lt     edge data ", output);
+  if (output != edgeOutput) {
+    std::cout << "multimerge lt  differs from edgeOutput" << std::endl;
+    retval = false;
+  }
+
+  mm::multimerge_gallop(edge_arrays, &output);
+  print_iv("multimerge gallop edge data ", output);
+  if (output != edgeOutput) {
+    std::cout << "multimerge gallop differs from edgeOutput" << std::endl;
+    retval = false;
+  }
+
+  mm::multimerge_fenced(edge_arrays, &output, mm::kLoserTree, nullptr);
+  print_iv("multimerge fenced edge data ", output);
+  if (output != edgeOutput) {
+    std::cout << "multimerge fenced differs from edgeOutput" << std::endl;
+    retval = false;
+  }
+
+  mm::multimerge_par(edge_arrays, &output, 3, mm::kPriorityQueue);
+  print_iv("multimerge par    edge data ", output);
+  if (output != edgeOutput) {
+    std::cout << "multimerge par differs from edgeOutput" << std::endl;
+    retval = false;
+  }
+
+  mm::multimerge_simd(edge_arrays, &output);
+  print_iv("multimerge simd   edge data ", output);
+  if (output != edgeOutput) {
+    std::cout << "multimerge simd differs from edgeOutput" << std::endl;
+    retval = false;
+  }
+
+  // More inputs than one vector holds, with the minimum in the last lane.
+
+  mm::IntVectorVector wide_arrays(mm::kMaxSimdInputs);
+  mm::IntVector wideOutput;
+  for (int i = mm::kMaxSimdInputs - 1; i >= 0; --i) {
+    for (int j = 0; j < 3; ++j) {
+      wide_arrays[i].push_back(mm::kMaxSimdInputs * j - i);
+    }
+  }
+  mm::multimerge_lt(wide_arrays, &wideOutput);
+  mm::multimerge_simd(wide_arrays, &output);
+  if (output != wideOutput) {
+    print_iv("multimerge simd   wide data ", output);
+    std::cout << "multimerge simd differs from wideOutput" << std::endl;
+    retval = false;
+  }
+
+  // One MergeContext reused for every method, for inputs of different
+  // numbers of arrays, twice over, and a buffer one short.
+
+  mm::MergeContext context;
+  const mm::MergeMethod methods[] = { mm::kLinear, mm::kPriorityQueue,
+                                      mm::kLoserTree, mm::kGalloping };
+  for (int round = 0; round < 2; ++round) {
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+      output.assign(correctOutput.size(), 0);
+      if (   !mm::multimerge(arrays, output.data(), output.size(), &context,
+                             methods[m])
+          || output != correctOutput) {
+        print_iv("multimerge context small data", output);
+        std::cout << "multimerge context differs from correctOutput, method "
+                  << methods[m] << std::endl;
+        retval = false;
+      }
+      output.assign(edgeOutput.size(), 0);
+      if (   !mm::multimerge(edge_arrays, output.data(), output.size(),
+                             &context, methods[m])
+          || output != edgeOutput) {
+        print_iv("multimerge context edge data ", output);
+        std::cout << "multimerge context differs from edgeOutput, method "
+                  << methods[m] << std::endl;
+        retval = false;
+      }
+    }
+  }
+  if (mm::multimerge(arrays, output.data(), correctOutput.size() - 1,
+                     &context)) {
+    std::cout << "multimerge context accepted too small an output buffer"
+              << std::endl;
+    retval = false;
+  }
+
   return retval;
 }
 
-// Generates random integers in a range; used to generate lengths for
-// input arrays of test data.
+// Test data for the templates in cc/mmergetemplate.h: 64-bit timestamps
+// with string payloads, with equal timestamps in different inputs so that
+// stability shows in the payloads, and the same data in descending order
+// merged with std::greater.
 
-class int_rand_in_range {
- public:
-  int_rand_in_range(int amin, int amax, bool do_seed = false) : rmin_(amin),
-                      factor_(static_cast<double>(amax - amin) * kInvRandMax) {
-    if (do_seed)
-      srand(clock());
+bool verify_generic_data() {
+  typedef std::pair<int64_t, std::string> Record;
+  typedef std::vector<Record>             RecordVector;
+  const int64_t t0 = 1380000000000000LL;  // microseconds, beyond 32 bits
+  Record r1[] = { Record(t0 + 1, "a0"), Record(t0 + 5, "a1"),
+                  Record(t0 + 5, "a2") };
+  Record r2[] = { Record(t0,     "b0"), Record(t0 + 5, "b1") };
+  Record r3[] = { Record(t0 + 1, "c0"), Record(t0 + 9, "c1") };
+  const char *order[] = { "b0", "a0", "c0", "a1", "a2", "b1", "c1" };
+  const size_t nr_order = sizeof(order) / sizeof(order[0]);
+  std::vector<RecordVector> inputs;
+  inputs.push_back(RecordVector(r1, r1 + sizeof(r1) / sizeof(r1[0])));
+  inputs.push_back(RecordVector(r2, r2 + sizeof(r2) / sizeof(r2[0])));
+  inputs.push_back(RecordVector(r3, r3 + sizeof(r3) / sizeof(r3[0])));
+  bool retval = true;
+
+  RecordVector output(mm::total_length(inputs));
+  mm::multimerge<int64_t, Record>(inputs, output.begin());
+  for (int nr_threads = 1; nr_threads <= 4; ++nr_threads) {
+    RecordVector output_par(output.size());
+    mm::multimerge_par<int64_t, Record>(inputs, output_par.begin(),
+                                        nr_threads);
+    if (output_par != output) {
+      std::cout << "multimerge_par<int64_t, Record> differs from multimerge "
+                << "with " << nr_threads << " threads" << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "multimerge<int64_t, Record> generic data ";
+  for (size_t i = 0; i < output.size(); ++i)
+    std::cout << output[i].second << " ";
+  std::cout << std::endl;
+  for (size_t i = 0; i < nr_order; ++i) {
+    if (output.size() != nr_order || output[i].second != order[i]) {
+      std::cout << "multimerge<int64_t, Record> differs from stable order"
+                << std::endl;
+      retval = false;
+      break;
+    }
   }
-  int_rand_in_range(const int_rand_in_range &irir) : rmin_(irir.rmin_),
-                                                     factor_(irir.factor_) {}
-  int_rand_in_range & operator= (const int_rand_in_range &) = delete;
 
-  int operator()() {
-    return rmin_ + int (factor_ * static_cast<double>(rand_r(&seed)) + 0.5);
+  for (size_t i = 0; i < inputs.size(); ++i)
+    std::reverse(inputs[i].begin(), inputs[i].end());
+  RecordVector descending;
+  mm::multimerge<int64_t, Record, std::greater<int64_t> >(
+      inputs, std::back_inserter(descending), mm::kPriorityQueue);
+  std::vector<int64_t> keys;
+  for (size_t i = 0; i < descending.size(); ++i)
+    keys.push_back(descending[i].first);
+  if (keys.size() != nr_order || !std::is_sorted(keys.rbegin(), keys.rend())) {
+    std::cout << "multimerge<int64_t, Record, std::greater> not descending"
+              << std::endl;
+    retval = false;
   }
 
- private:
-  constexpr static double kInvRandMax = 1.0 / RAND_MAX;
+  return retval;
+}
 
-  int          rmin_;
-  double       factor_;
-  unsigned int seed;
-};
+// Random inputs of records for the stability tests: *pinputs gets
+// nr_inputs sorted inputs of up to 300 keys, starting below start_spread,
+// that mostly repeat or step by one, with occasional jumps, so that inputs
+// supply stretches of the output, ending at equal keys in other inputs as
+// often as not.  The records' payloads are their positions in the inputs
+// concatenated in order, and *pcorrect gets the stable sort of that
+// concatenation, which is the stable merge.
 
-// Sequential integer generator for std::generate, used to generate sequential
-// overall input data.
+typedef std::pair<int, size_t> Record;
+typedef std::vector<Record>    RecordVector;
 
-class int_seq {
- public:
-  explicit int_seq(int amin) : rmin_(amin) {}
-  int_seq(const int_seq &is) : rmin_(is.rmin_) {}
-  int_seq & operator= (const int_seq &) = delete;
+void random_record_inputs(int nr_inputs, int start_spread, std::mt19937 *pgen,
+                          std::vector<RecordVector> *pinputs,
+                          RecordVector *pcorrect) {
+  std::mt19937 &gen = *pgen;
+  pinputs->assign(nr_inputs, RecordVector());
+  pcorrect->clear();
+  for (int i = 0; i < nr_inputs; ++i) {
+    int len = gen() % 300;
+    int key = gen() % start_spread;
+    for (int j = 0; j < len; ++j) {
+      key += gen() % 20 == 0 ? gen() % 200 : gen() % 2;
+      (*pinputs)[i].push_back(Record(key, pcorrect->size()));
+      pcorrect->push_back((*pinputs)[i].back());
+    }
+  }
+  std::stable_sort(pcorrect->begin(), pcorrect->end(),
+                   [](const Record &r0, const Record &r1) {
+                     return r0.first < r1.first;
+                   });
+}
+
+// Test data for the galloping method: random inputs, mostly overlapping,
+// whose stretches are long enough to gallop through; numbers of inputs from
+// 1 to 9 give the loser tree odd shapes.
+
+bool verify_gallop_data() {
+  std::mt19937 gen(17);
+  bool retval = true;
+
+  for (int trial = 0; trial < 200 && retval; ++trial) {
+    std::vector<RecordVector> inputs;
+    RecordVector correct;
+    random_record_inputs(1 + trial % 9, 100, &gen, &inputs, &correct);
 
-  int operator()() {
-    return rmin_++;  // post-increment
+    RecordVector output(correct.size());
+    mm::multimerge<int, Record>(inputs, output.begin(), mm::kGalloping);
+    if (output != correct) {
+      std::cout << "multimerge<int, Record> galloping differs from stable "
+                << "order, trial " << trial << std::endl;
+      retval = false;
+    }
+    mm::multimerge_par<int, Record>(inputs, output.begin(), 3,
+                                    mm::kGalloping);
+    if (output != correct) {
+      std::cout << "multimerge_par<int, Record> galloping differs from "
+                << "stable order, trial " << trial << std::endl;
+      retval = false;
+    }
   }
+  std::cout << "multimerge<int, Record> galloping "
+            << (retval ? "matches" : "differs from") << " stable order"
+            << std::endl;
+  return retval;
+}
 
- private:
-  int rmin_;
-};
+// Test data for the fenced method: arrays, some overlapping no other, some
+// touching at one value, and one inside another, whose copied and merged
+// values and windows are known; then random inputs of records, spread so
+// that some overlap and some do not, against the stable merge.
+
+bool verify_fenced_data() {
+  mm::IntVectorVector arrays = {
+    { 1, 2, 3 }, { 5, 6, 7 }, { 7, 8, 9 }, {}, { 12, 15, 18 }, { 13, 14 }
+  };
+  mm::IntVector correct = { 1, 2, 3, 5, 6, 7, 7, 8, 9, 12, 13, 14, 15, 18 };
+  mm::IntVector output;
+  mm::FenceStats stats;
+  bool retval = true;
+  mm::multimerge_fenced(arrays, &output, mm::kLoserTree, &stats);
+  print_iv("multimerge fenced fence data", output);
+  if (   output != correct || stats.nr_copied != 10 || stats.nr_merged != 4
+      || stats.nr_windows != 2) {
+    std::cout << "multimerge fenced differs from correct, or copied "
+              << stats.nr_copied << ", merged " << stats.nr_merged
+              << " in " << stats.nr_windows << " windows, not 10, 4, 2"
+              << std::endl;
+    retval = false;
+  }
+  mm::multimerge_fenced(arrays, &output, mm::kPriorityQueue, nullptr);
+  if (output != correct) {
+    std::cout << "multimerge fenced pq differs from correct" << std::endl;
+    retval = false;
+  }
+
+  std::mt19937 gen(18);
+  for (int trial = 0; trial < 200 && retval; ++trial) {
+    std::vector<RecordVector> inputs;
+    RecordVector correct_records;
+    random_record_inputs(1 + trial % 9, 5000, &gen, &inputs,
+                         &correct_records);
+    RecordVector output_records(correct_records.size());
+    mm::multimerge_fenced<int, Record>(inputs, output_records.begin(),
+                                       nullptr);
+    if (output_records != correct_records) {
+      std::cout << "multimerge_fenced<int, Record> differs from stable "
+                << "order, trial " << trial << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "multimerge_fenced<int, Record> "
+            << (retval ? "matches" : "differs from") << " stable order"
+            << std::endl;
+  return retval;
+}
+
+// Test data for choose_merge_engine: 40 arrays, 8 of them nonempty, and 8
+// arrays, all nonempty, against a table where at 8 heads the linear
+// methods win, SIMD first, but at 40 lose to the loser tree.  The SIMD
+// method leaves the empty arrays out and is chosen by the 8 nonempty; the
+// scalar linear method scans all 40 and must not be chosen when the table
+// has no SIMD entries.  multimerge_simd's output is checked with the empty
+// arrays in place.
+
+bool verify_auto_choice() {
+  std::vector<mm::CalibrationRow> rows(2);
+  const double ns_8[mm::kNrMergeEngines]  = { 1.0,  0.5, 4.0, 3.0 };
+  const double ns_64[mm::kNrMergeEngines] = { 8.0, -1.0, 6.0, 5.0 };
+  rows[0].k = 8;
+  rows[1].k = 64;
+  std::copy(ns_8, ns_8 + mm::kNrMergeEngines, rows[0].ns_per_int);
+  std::copy(ns_64, ns_64 + mm::kNrMergeEngines, rows[1].ns_per_int);
+  mm::MergeCalibration with_simd(rows);
+  rows[0].ns_per_int[mm::kEngineSimd] = -1.0;
+  mm::MergeCalibration without_simd(rows);
+
+  mm::IntVectorVector sparse(40);
+  for (size_t i = 0; i < sparse.size(); i += 5) {
+    for (int j = 0; j < 1000; ++j)
+      sparse[i].push_back(j * 7 + static_cast<int>(i) % 7);
+  }
+  mm::IntVectorVector dense;
+  for (size_t i = 0; i < sparse.size(); ++i) {
+    if (!sparse[i].empty())
+      dense.push_back(sparse[i]);
+  }
+
+  bool retval = true;
+  double estimate;
+  mm::MergeEngine chosen = mm::choose_merge_engine(sparse, with_simd,
+                                                   &estimate);
+  if (chosen != mm::kEngineSimd || estimate < 3.9e-6 || estimate > 4.1e-6) {
+    std::cout << "choose_merge_engine chose "
+              << mm::merge_engine_name(chosen) << ", estimate " << estimate
+              << ", for 8 of 40 arrays nonempty, not simd, 4e-06"
+              << std::endl;
+    retval = false;
+  }
+  chosen = mm::choose_merge_engine(sparse, without_simd, nullptr);
+  if (chosen != mm::kEngineLoserTree) {
+    std::cout << "choose_merge_engine chose "
+              << mm::merge_engine_name(chosen) << " for 8 of 40 arrays "
+              << "nonempty without simd, not lt" << std::endl;
+    retval = false;
+  }
+  chosen = mm::choose_merge_engine(dense, without_simd, nullptr);
+  if (chosen != mm::kEngineLinear) {
+    std::cout << "choose_merge_engine chose "
+              << mm::merge_engine_name(chosen) << " for 8 arrays without "
+              << "simd, not lin" << std::endl;
+    retval = false;
+  }
+  mm::IntVector correct;
+  mm::IntVector output;
+  mm::multimerge_lt(dense, &correct);
+  mm::multimerge_simd(sparse, &output);
+  if (output != correct) {
+    std::cout << "multimerge_simd of 8 of 40 arrays nonempty differs from "
+              << "multimerge_lt" << std::endl;
+    retval = false;
+  }
+  std::cout << "choose_merge_engine " << (retval ? "counts" : "miscounts")
+            << " empty arrays" << std::endl;
+  return retval;
+}
+
+// Test data for parallel_sort: random vectors, with many repeats, of sizes
+// below, at, and above the least it sorts in parallel, on pools of one to
+// four threads, merged by each method, against std::sort.
+
+bool verify_parallel_sort() {
+  const size_t sizes[] = { 0, 1, 1000, mm::kMinParallelSortSize,
+                           mm::kMinParallelSortSize * 3 + 7 };
+  const mm::MergeMethod methods[] = { mm::kPriorityQueue, mm::kLoserTree,
+                                      mm::kGalloping };
+  std::mt19937 gen(19);
+  std::uniform_int_distribution<int> value_dist(-1000, 1000);
+  bool retval = true;
+  for (int nr_threads = 1; nr_threads <= 4; ++nr_threads) {
+    mm::WorkStealingPool pool(nr_threads);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+      for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+        mm::IntVector values(sizes[s]);
+        std::generate(values.begin(), values.end(),
+                      [&]() { return value_dist(gen); });
+        mm::IntVector correct(values);
+        std::sort(correct.begin(), correct.end());
+        mm::parallel_sort(&values, &pool, methods[m], nullptr);
+        if (values != correct) {
+          std::cout << "parallel_sort differs from std::sort, n "
+                    << sizes[s] << ", " << nr_threads << " threads, method "
+                    << methods[m] << std::endl;
+          retval = false;
+        }
+      }
+    }
+  }
+  std::cout << "parallel_sort " << (retval ? "matches" : "differs from")
+            << " std::sort" << std::endl;
+  return retval;
+}
+
+// Test data for the streaming merge: random sorted arrays, some empty, with
+// many repeats, each pushed by its own producer thread in chunks of random
+// length, some empty, through rings of two chunks so that producers and
+// merger often wait for each other, and pulled in output chunks of 1 to 7
+// values, against multimerge_lt.
+
+bool verify_stream_merge() {
+  std::mt19937 gen(20);
+  bool retval = true;
+  for (int trial = 0; trial < 50 && retval; ++trial) {
+    size_t nr_streams = trial % 7;
+    mm::IntVectorVector arrays(nr_streams);
+    std::vector<std::vector<size_t> > cuts(nr_streams);
+    for (size_t i = 0; i < nr_streams; ++i) {
+      arrays[i].resize(gen() % 500);
+      for (size_t j = 0; j < arrays[i].size(); ++j)
+        arrays[i][j] = gen() % 200;
+      std::sort(arrays[i].begin(), arrays[i].end());
+      for (size_t cut = 0; cut < arrays[i].size(); cut += gen() % 40)
+        cuts[i].push_back(cut);
+      cuts[i].push_back(arrays[i].size());
+    }
+    mm::IntVector correct;
+    mm::multimerge_lt(arrays, &correct);
+
+    std::vector<std::unique_ptr<mm::SortedStream> > streams;
+    std::vector<mm::SortedStream *>                 stream_ptrs;
+    for (size_t i = 0; i < nr_streams; ++i) {
+      streams.push_back(std::unique_ptr<mm::SortedStream>(
+                            new mm::SortedStream(2)));
+      stream_ptrs.push_back(streams.back().get());
+    }
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < nr_streams; ++i) {
+      producers.push_back(std::thread([&, i]() {
+        size_t first = 0;
+        for (size_t c = 0; c < cuts[i].size(); ++c) {
+          mm::SortedStream::Chunk chunk(arrays[i].begin() + first,
+                                        arrays[i].begin() + cuts[i][c]);
+          streams[i]->push(&chunk);
+          first = cuts[i][c];
+        }
+        streams[i]->close();
+      }));
+    }
+    mm::StreamMerger merger(stream_ptrs);
+    mm::IntVector output;
+    int buffer[7];
+    size_t nr;
+    while ((nr = merger.next_chunk(buffer, 1 + output.size() % 7)) > 0)
+      output.insert(output.end(), buffer, buffer + nr);
+    for (size_t i = 0; i < producers.size(); ++i)
+      producers[i].join();
+    if (output != correct) {
+      std::cout << "StreamMerger differs from multimerge_lt, trial " << trial
+                << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "StreamMerger " << (retval ? "matches" : "differs from")
+            << " multimerge_lt" << std::endl;
+  return retval;
+}
+
+// Test data for the batch merge: batches of 0 to 300 jobs, some with no
+// arrays or only empty ones, most small and a few larger than a task, on 1
+// to 4 threads, each job's output in the arena against multimerge_lt.
+
+bool verify_batch_merge() {
+  const mm::MergeMethod methods[] = { mm::kPriorityQueue, mm::kLoserTree,
+                                      mm::kGalloping };
+  std::mt19937 gen(21);
+  bool retval = true;
+  for (int nr_threads = 1; nr_threads <= 4; ++nr_threads) {
+    mm::WorkStealingPool pool(nr_threads);
+    for (int trial = 0; trial < 6; ++trial) {
+      size_t nr_jobs = trial == 0 ? 0 : gen() % 300;
+      std::vector<mm::IntVectorVector>       jobs(nr_jobs);
+      std::vector<const mm::IntVectorVector *> job_ptrs(nr_jobs);
+      for (size_t j = 0; j < nr_jobs; ++j) {
+        size_t max_len = j % 50 == 0 ? 2 * mm::kBatchTaskValues : 20;
+        jobs[j].resize(gen() % 65);
+        for (size_t i = 0; i < jobs[j].size(); ++i) {
+          jobs[j][i].resize(gen() % max_len);
+          for (size_t v = 0; v < jobs[j][i].size(); ++v)
+            jobs[j][i][v] = gen() % 1000;
+          std::sort(jobs[j][i].begin(), jobs[j][i].end());
+        }
+        job_ptrs[j] = &jobs[j];
+      }
+      mm::BatchOutput batch;
+      mm::BatchStats  stats;
+      mm::multimerge_batch(job_ptrs, &pool, methods[trial % 3], &batch,
+                           &stats);
+      mm::IntVector correct;
+      for (size_t j = 0; j < nr_jobs && retval; ++j) {
+        mm::multimerge_lt(jobs[j], &correct);
+        if (   batch.offsets[j + 1] - batch.offsets[j] != correct.size()
+            || !std::equal(correct.begin(), correct.end(),
+                           batch.arena.begin() + batch.offsets[j])) {
+          std::cout << "multimerge_batch differs from multimerge_lt, job "
+                    << j << " of " << nr_jobs << ", " << nr_threads
+                    << " threads" << std::endl;
+          retval = false;
+        }
+      }
+      if (   batch.offsets.size() != nr_jobs + 1
+          || stats.job_sec.size() != nr_jobs) {
+        std::cout << "multimerge_batch offsets or stats wrong size"
+                  << std::endl;
+        retval = false;
+      }
+    }
+  }
+  std::cout << "multimerge_batch " << (retval ? "matches" : "differs from")
+            << " multimerge_lt" << std::endl;
+  return retval;
+}
+
+// Test data for packed runs: a block of 0, 1, ..., 127 against its known
+// layout, then random runs, some empty, of lengths about multiples of the
+// block length, with repeats, wide gaps, and the extremes of int, packed,
+// decoded, appended to a piece at a time, and merged, against
+// multimerge_lt.
+
+bool verify_packed_data() {
+  bool retval = true;
+  mm::IntVector values(mm::kPackBlockLen);
+  std::iota(values.begin(), values.end(), 0);
+  mm::PackedRun run;
+  run.assign(values.data(), values.data() + values.size());
+  const std::vector<uint32_t> &words = run.words();
+  if (   words.size() != 4 || words[0] != 0xfffffffe || words[1] != ~0U
+      || words[2] != ~0U || words[3] != ~0U) {
+    std::cout << "PackedRun layout differs for 0, 1, ..., 127" << std::endl;
+    retval = false;
+  }
+
+  std::mt19937 gen(22);
+  for (int trial = 0; trial < 40; ++trial) {
+    size_t k = trial % 9;
+    mm::IntVectorVector arrays(k);
+    for (size_t i = 0; i < k; ++i) {
+      size_t len = gen() % 5 * mm::kPackBlockLen + gen() % 3 - 1;
+      if (len > 100 * mm::kPackBlockLen)
+        len = 0;
+      int spread = trial % 4 == 0 ? 3 : (trial % 4 == 1 ? 1000 : 0);
+      for (size_t j = 0; j < len; ++j) {
+        int v = spread > 0 ? static_cast<int>(gen() % spread)
+                           : static_cast<int>(gen());
+        arrays[i].push_back(v);
+      }
+      if (trial % 5 == 0 && len > 1) {
+        arrays[i][0] = std::numeric_limits<int>::min();
+        arrays[i][1] = std::numeric_limits<int>::max();
+      }
+      std::sort(arrays[i].begin(), arrays[i].end());
+    }
+    mm::IntVector correct;
+    mm::multimerge_lt(arrays, &correct);
+
+    mm::PackedRunVector runs;
+    mm::pack_runs(arrays, &runs);
+    mm::IntVector output;
+    for (size_t i = 0; i < k; ++i) {
+      runs[i].decode(&output);
+      mm::PackedRun pieces;
+      for (size_t j = 0; j < arrays[i].size(); j += 1 + j % 150) {
+        size_t end = std::min(arrays[i].size(), j + 1 + j % 150);
+        pieces.append(arrays[i].data() + j, arrays[i].data() + end);
+      }
+      mm::IntVector appended;
+      pieces.decode(&appended);
+      if (   output != arrays[i] || appended != arrays[i]
+          || runs[i].size() != arrays[i].size()) {
+        std::cout << "PackedRun decoded differs from packed, trial " << trial
+                  << ", run " << i << std::endl;
+        retval = false;
+      }
+    }
+    mm::multimerge_packed(runs, &output);
+    mm::PackedRun packed_output;
+    mm::multimerge_packed(runs, &packed_output);
+    mm::IntVector repacked;
+    packed_output.decode(&repacked);
+    if (output != correct || repacked != correct) {
+      std::cout << "multimerge_packed differs from multimerge_lt, trial "
+                << trial << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "multimerge_packed " << (retval ? "matches" : "differs from")
+            << " multimerge_lt" << std::endl;
+  return retval;
+}
+
+// Checks the 64-bit key overloads of cc/mmerge.h, every method, on keys of
+// Vector's value type, against the sorted concatenation of arrays.  label
+// names the key type in messages.
+
+template <typename Vector>
+bool verify_wide_keys(const std::string &label,
+                      const std::vector<Vector> &arrays) {
+  Vector correct;
+  for (size_t i = 0; i < arrays.size(); ++i)
+    correct.insert(correct.end(), arrays[i].begin(), arrays[i].end());
+  std::sort(correct.begin(), correct.end());
+  bool retval = true;
+
+  Vector output;
+  mm::multimerge(arrays, &output);
+  if (output != correct) {
+    std::cout << "multimerge " << label << " differs" << std::endl;
+    retval = false;
+  }
+  mm::multimerge_pq(arrays, &output);
+  if (output != correct) {
+    std::cout << "multimerge_pq " << label << " differs" << std::endl;
+    retval = false;
+  }
+  mm::multimerge_lt(arrays, &output);
+  if (output != correct) {
+    std::cout << "multimerge_lt " << label << " differs" << std::endl;
+    retval = false;
+  }
+  for (int nr_threads = 1; nr_threads <= 4; ++nr_threads) {
+    mm::multimerge_par(arrays, &output, nr_threads, mm::kLoserTree);
+    if (output != correct) {
+      std::cout << "multimerge_par " << label << " differs with "
+                << nr_threads << " threads" << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "multimerge " << label << " wide data ";
+  for (size_t i = 0; i < output.size(); ++i)
+    std::cout << output[i] << " ";
+  std::cout << std::endl;
+  return retval;
+}
+
+// Test data for the 64-bit key overloads: keys beyond 32 bits, at both ends
+// of their range, which are also the loser tree's sentinel, and, for
+// unsigned keys, above 2^63, where they would be negative if signed.
+
+bool verify_wide_data() {
+  const int64_t  big  = 1LL << 40;
+  const int64_t  imin = std::numeric_limits<int64_t>::min();
+  const int64_t  imax = std::numeric_limits<int64_t>::max();
+  const uint64_t umax = std::numeric_limits<uint64_t>::max();
+  const uint64_t half = 1ULL << 63;
+  mm::Int64VectorVector signed_arrays = {
+    { imin, -big, 3, big, imax }, {}, { -big - 1, 3, big + 1, imax },
+    { imin, imin + 1 }
+  };
+  mm::UInt64VectorVector unsigned_arrays = {
+    { 0, 7, half, umax }, { half - 1, half + 1 }, {},
+    { 1ULL << 32, umax - 1, umax }
+  };
+  bool retval = true;
+  if (!verify_wide_keys("int64_t ", signed_arrays))
+    retval = false;
+  if (!verify_wide_keys("uint64_t", unsigned_arrays))
+    retval = false;
+  return retval;
+}
 
 // Calculate and print statistics for list of ints, interpreted as
 // various lengths centered at aveInputLen; return total length.
 
-int calc_display_stats(mm::IntVector lens, int ave_input_len) {
-  int nr_inputs = lens.size();
-  int tot_lens  = 0;
-  int max_len   = INT_MIN;
-  int min_len   = INT_MAX;
+size_t calc_display_stats(mm::IntVector lens, int ave_input_len) {
+  int    nr_inputs = lens.size();
+  size_t tot_lens  = 0;
+  int    max_len   = INT_MIN;
+  int    min_len   = INT_MAX;
 
   mm::IntVectorIterator lens_it;
   for (lens_it = lens.begin(); lens_it != lens.end(); ++lens_it) {
@@ -215,7 +1163,8 @@ int calc_display_stats(mm::IntVector lens, int ave_input_len) {
   }
   std::cout << "nr_inputs "                 << nr_inputs
             << ", requested ave_input_len " << ave_input_len << std::endl
-            << "their product "             << nr_inputs * ave_input_len
+            << "their product "             << static_cast<long>(nr_inputs)
+                                               * ave_input_len
             << ", actual tot_lens "         << tot_lens << std::endl
             << "mean_len "                  << round(mean_len)
             << ", std dev "                 << round(sqrt(sum_sq_dev
@@ -226,123 +1175,1853 @@ int calc_display_stats(mm::IntVector lens, int ave_input_len) {
   return tot_lens;
 }
 
-// Generate test data: an IntVectorVector of nr_input IntVectors of random
-// lengths uniformly distributed from about ave_input_len / 10 to
-// 2 * ave_input_len minus that; a range centered at ave_input_len.
-
-void generate_data(int nr_inputs,
-                   int ave_input_len,
-                   mm::IntVector *p_input_copy,
-                   mm::IntVectorVector *p_arrays) {
-  int amin = (ave_input_len + 5) / 10;
-  if (amin < 1)
-    amin = 1;
-  int amax = 2 * ave_input_len - amin;
+// Lengths of the input arrays for distribution, in the order of the arrays.
 
+mm::IntVector generate_lens(int nr_inputs, int ave_input_len,
+                            Distribution distribution, std::mt19937 *pgen) {
   mm::IntVector lens(nr_inputs, 0);
-  std::generate(lens.begin(), lens.end(), int_rand_in_range(amin, amax));
+  if (distribution == kDistZipf) {
+    // Proportional to 1 / rank, ranks in random order, scaled to total about
+    // nr_inputs * ave_input_len, at least 1 each.
+    double sum_weights = 0.0;
+    for (int r = 1; r <= nr_inputs; ++r)
+      sum_weights += 1.0 / r;
+    double scale =   static_cast<double>(nr_inputs) * ave_input_len
+                   / sum_weights;
+    for (int r = 1; r <= nr_inputs; ++r)
+      lens[r - 1] = std::max(1, static_cast<int>(round(scale / r)));
+    std::shuffle(lens.begin(), lens.end(), *pgen);
+  } else if (distribution == kDistSimilar) {
+    std::fill(lens.begin(), lens.end(), ave_input_len);
+  } else if (distribution == kDistGiant) {
+    int tiny = std::max(1, ave_input_len / 100);
+    std::fill(lens.begin(), lens.end(), tiny);
+    lens[(*pgen)() % nr_inputs] = std::max(tiny,
+                                           nr_inputs * ave_input_len / 2);
+  } else {
+    int amin = (ave_input_len + 5) / 10;
+    if (amin < 1)
+      amin = 1;
+    int amax = 2 * ave_input_len - amin;
+    std::uniform_int_distribution<int> len_dist(amin, amax);
+    for (int i = 0; i < nr_inputs; ++i)
+      lens[i] = len_dist(*pgen);
+  }
+  return lens;
+}
 
-  int tot_lens = calc_display_stats(lens, ave_input_len);
+// Length of the stretches of consecutive values of the clustered
+// distribution; the last stretch of an array may be shorter.
 
-  // Generate the input data by initializing an overall input array
-  // sequentially, shuffling it, piecing it out into the input arrays,
-  // and sorting each input array.
+const int kClusterLen = 1000;
 
-  mm::IntVector input(tot_lens, 0);
-  std::generate(input.begin(), input.end(), int_seq(1));
-  *p_input_copy = input;  // for later comparison with merge result
-  std::random_shuffle(input.begin(), input.end());
+// What generate_run needs to know besides the array index: for disjoint,
+// the first value of each array; for clustered, the first value of each
+// stretch of each array, ascending; for the others, the range of values.
 
-  p_arrays->clear();
-  p_arrays->reserve(nr_inputs);
-  mm::IntVectorIterator input_it = input.begin();
-  for (int i = 0; i < nr_inputs; ++i) {
-    p_arrays->push_back(mm::IntVector(lens[i], 0));
-    for (mm::IntVectorIterator j = (*p_arrays)[i].begin();
-         j != (*p_arrays)[i].end(); ++j) {
-      *j = *input_it;
-      ++input_it;
+struct RunPlan {
+  Distribution               distribution;
+  unsigned int               seed;
+  mm::IntVector              lens;
+  mm::IntVector              firsts;
+  std::vector<mm::IntVector> cluster_firsts;
+  double                     value_range;
+};
+
+// Generates input array i, sorted, into values[0], ..., values[len - 1],
+// len its length in plan, directly, from a generator seeded by
+// plan.seed and i alone, so that the data depend on neither the number of
+// threads nor the order in which arrays are generated.  Values are drawn as
+// the points of a Poisson process, whose sorted gaps are exponential, with
+// mean gap value_range / len; they are as a sorted sample of len values
+// uniform from 1 to about value_range, with repeats when value_range is less
+// than len.
+
+void generate_run(int i, const RunPlan &plan, int *values) {
+  int len = plan.lens[i];
+  std::seed_seq seq{plan.seed, static_cast<unsigned int>(i)};
+  std::mt19937 gen(seq);
+  switch (plan.distribution) {
+    case kDistDisjoint:
+      for (int j = 0; j < len; ++j)
+        values[j] = plan.firsts[i] + j;
+      break;
+    case kDistClustered:
+      for (int j = 0; j < len; ++j)
+        values[j] = plan.cluster_firsts[i][j / kClusterLen] + j % kClusterLen;
+      break;
+    case kDistSimilar: {
+      // A common base of every fourth value, with about 1% of the values
+      // replaced by random ones in the same range.
+      std::uniform_int_distribution<int> value_dist(1, 4 * len);
+      std::uniform_int_distribution<int> percent_dist(0, 99);
+      for (int j = 0; j < len; ++j)
+        values[j] = percent_dist(gen) == 0 ? value_dist(gen) : 1 + 4 * j;
+      std::sort(values, values + len);
+      break;
+    }
+    default: {
+      // Each gap from a single 32-bit draw, as -log(u) times the mean gap,
+      // which is much faster than std::exponential_distribution's 53-bit
+      // draws and as good for test data.
+      double mean_gap = plan.value_range / len;
+      double x = 0.0;
+      for (int j = 0; j < len; ++j) {
+        x -= mean_gap * std::log((gen() + 0.5) * (1.0 / 4294967296.0));
+        values[j] = static_cast<int>(std::min(x, INT_MAX - 1.0)) + 1;
+      }
+      break;
     }
-    std::stable_sort((*p_arrays)[i].begin(), (*p_arrays)[i].end());
   }
 }
 
-// For timing merges; in actual usage s is nonempty for start == false only.
+// The plan of the test data for nr_inputs arrays by distribution (see
+// usage()), determined by seed: their lengths, chosen first, and what
+// generate_run needs to generate each.  For uniform, lengths are uniformly
+// distributed from about ave_input_len / 10 to 2 * ave_input_len minus
+// that, a range centered at ave_input_len, and values uniform from 1 to
+// about n.
 
-void stopwatch(bool start = true, std::string s = std::string()) {
-  static clock_t t_start;
-  if (start) {
-    t_start = clock();
-    if (s.size() > 0)
-      std::cout << s << " stopwatch start" << std::endl;
-  } else {
-    clock_t t_end = clock();
-    std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
-    std::cout.precision(2);
-    std::cout << s << " stopwatch end" << std::endl
-              << " elapsed " << (t_end - t_start)
-              << " clocks at " << CLOCKS_PER_SEC << " per sec, or "
-              <<   static_cast<double>(t_end - t_start)
-                 / static_cast<double>(CLOCKS_PER_SEC)
-              << " sec" << std::endl;
+void plan_runs(int nr_inputs, int ave_input_len, Distribution distribution,
+               unsigned int seed, RunPlan *pplan) {
+  std::mt19937 gen(seed);
+  RunPlan &plan = *pplan;
+  plan.distribution = distribution;
+  plan.seed         = seed;
+  plan.lens         = generate_lens(nr_inputs, ave_input_len, distribution,
+                                    &gen);
+  size_t tot_lens = 0;
+  for (int i = 0; i < nr_inputs; ++i)
+    tot_lens += plan.lens[i];
+
+  plan.value_range = tot_lens;
+  if (distribution == kDistDuplicates)
+    plan.value_range = std::max<size_t>(1, tot_lens / 1000);
+  if (distribution == kDistDisjoint) {
+    // Consecutive ranges of values, in a random order of arrays.
+    mm::IntVector order(nr_inputs, 0);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), gen);
+    plan.firsts.resize(nr_inputs);
+    int first = 1;
+    for (int o = 0; o < nr_inputs; ++o) {
+      plan.firsts[order[o]] = first;
+      first += plan.lens[order[o]];
+    }
+  } else if (distribution == kDistClustered) {
+    // Consecutive ranges of values, in a random order of the stretches of
+    // all the arrays; each array's stretches are given their ranges in the
+    // order of its values, so they ascend, and the last may be shorter.
+    mm::IntVector stretches;  // the array of each stretch
+    plan.cluster_firsts.resize(nr_inputs);
+    for (int i = 0; i < nr_inputs; ++i) {
+      int nr_stretches = (plan.lens[i] + kClusterLen - 1) / kClusterLen;
+      plan.cluster_firsts[i].reserve(nr_stretches);
+      stretches.insert(stretches.end(), nr_stretches, i);
+    }
+    std::shuffle(stretches.begin(), stretches.end(), gen);
+    int first = 1;
+    for (size_t s = 0; s < stretches.size(); ++s) {
+      mm::IntVector &firsts = plan.cluster_firsts[stretches[s]];
+      int            len    = plan.lens[stretches[s]];
+      int            done   = static_cast<int>(firsts.size()) * kClusterLen;
+      firsts.push_back(first);
+      first += std::min(kClusterLen, len - done);
+    }
   }
 }
 
-// Test program for mmerge.cc.
+// Calls generate(i) for each array i of plan, on nr_threads threads taking
+// arrays in turn.
 
-int testmmerge_main(int argc, char *argv[]) {
-  // Obtain parameters for more voluminous test data from the command line,
-  // or use the following defaults.
+template <typename Generate>
+void generate_runs(const RunPlan &plan, int nr_threads, Generate generate) {
+  int nr_inputs = plan.lens.size();
+  std::atomic<int> next_run(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < std::max(nr_threads, 1); ++t) {
+    threads.push_back(std::thread([&]() {
+      for (int i; (i = next_run++) < nr_inputs; )
+        generate(i);
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+}
 
-  constexpr int max_nr_input_ints = 500000000;  // 500 million (Ok for 8GB RAM)
-                                                // >= product of two following:
-  int  nr_inputs         = 1000;
-  int  ave_input_len     = 10000;
-  bool do_multimerge_lin = false;
-  bool help_only         = false;
-  bool error             = false;
+// The arrays of plan as an IntVectorVector, one vector each.
 
-  get_cfg(argc, argv, max_nr_input_ints, &nr_inputs, &ave_input_len,
-          &do_multimerge_lin, &help_only, &error);
-  if (help_only)
-    return 0;
-  else if (error)
-    return -1;
+void generate_arrays(const RunPlan &plan, int nr_threads,
+                     mm::IntVectorVector *p_arrays) {
+  p_arrays->clear();
+  p_arrays->resize(plan.lens.size());
+  generate_runs(plan, nr_threads, [&](int i) {
+    mm::IntVector &array = (*p_arrays)[i];
+    array.resize(plan.lens[i]);
+    generate_run(i, plan, array.data());
+  });
+}
 
-  bool retval = true;  // set to false if any errors in merge output
-  if (!verify_small_data())
-    retval = false;
+// The arrays of plan as FlatRuns, each generated in place.
 
-  // Do the larger tests.
+void generate_arrays(const RunPlan &plan, int nr_threads,
+                     mm::FlatRuns *pruns) {
+  size_t nr_inputs = plan.lens.size();
+  pruns->offsets.resize(nr_inputs + 1);
+  pruns->offsets[0] = 0;
+  for (size_t i = 0; i < nr_inputs; ++i)
+    pruns->offsets[i + 1] = pruns->offsets[i] + plan.lens[i];
+  pruns->values.resize(pruns->offsets[nr_inputs]);
+  generate_runs(plan, nr_threads, [&](int i) {
+    generate_run(i, plan, pruns->values.data() + pruns->offsets[i]);
+  });
+}
 
-  mm::IntVector input_copy;
-  mm::IntVectorVector arrays;
-  generate_data(nr_inputs, ave_input_len, &input_copy, &arrays);
+// Generate test data: nr_input arrays, each sorted, of lengths and values
+// by distribution (see plan_runs and usage()), determined by seed, as an
+// IntVectorVector or FlatRuns, the same data either way.  Prints the
+// lengths' statistics.  Each array is generated sorted by generate_run, on
+// nr_threads threads taking arrays in turn.
 
-  mm::IntVector output_pq;
-  std::cout << "multimerge priority queue" << std::endl;
-  stopwatch();
-  mm::multimerge_pq(arrays, &output_pq);
-  stopwatch(false, "multimerge pq ");
-  bool cmp_ok = (output_pq == input_copy);
-  if (!cmp_ok)
-    retval = false;
-  std::cout << "multimerge_pq       "
-            << (cmp_ok ? "matches     " : "differs from")
-            << " input_copy" << std::endl;
-
-  if (do_multimerge_lin) {
-    mm::IntVector output_lin;
-    std::cout << "multimerge linear" << std::endl;
-    stopwatch();
-    mm::multimerge(arrays, &output_lin);
-    stopwatch(false, "multimerge lin");
-    cmp_ok = (output_pq == input_copy);
-    if (!cmp_ok)
-      retval = false;
-    std::cout << "multimerge (linear) "
-              << (cmp_ok ? "matches     " : "differs from")
-              << " input_copy" << std::endl;
+template <typename Runs>
+void generate_data(int nr_inputs,
+                   int ave_input_len,
+                   Distribution distribution,
+                   unsigned int seed,
+                   int nr_threads,
+                   Runs *pruns) {
+  RunPlan plan;
+  plan_runs(nr_inputs, ave_input_len, distribution, seed, &plan);
+  calc_display_stats(plan.lens, ave_input_len);
+  generate_arrays(plan, nr_threads, pruns);
+}
+
+// Test data for flat runs: random runs, some empty, with repeats, the same
+// as a vector of vectors and as FlatRuns, every method of cc/mmerge.h on
+// each against the other; then the data of generate_data for each
+// distribution, the same either way.
+
+bool verify_flat_data() {
+  std::mt19937 gen(23);
+  bool retval = true;
+  for (int trial = 0; trial < 40; ++trial) {
+    size_t k = trial % 13 * (trial % 3 == 0 ? 7 : 1);
+    mm::IntVectorVector arrays(k);
+    mm::Int64VectorVector wide_arrays(k);
+    mm::FlatRuns      runs;
+    mm::Int64FlatRuns wide_runs;
+    for (size_t i = 0; i < k; ++i) {
+      arrays[i].resize(gen() % 4 == 0 ? 0 : gen() % 60);
+      for (size_t j = 0; j < arrays[i].size(); ++j)
+        arrays[i][j] = gen() % 100 - 50;
+      std::sort(arrays[i].begin(), arrays[i].end());
+      wide_arrays[i].assign(arrays[i].begin(), arrays[i].end());
+      runs.push_back(arrays[i].begin(), arrays[i].end());
+      wide_runs.push_back(wide_arrays[i].begin(), wide_arrays[i].end());
+    }
+    mm::IntVector correct;
+    mm::multimerge_lt(arrays, &correct);
+    std::vector<std::pair<std::string, mm::IntVector> > outputs(10);
+    outputs[0].first = "multimerge";
+    mm::multimerge(runs, &outputs[0].second);
+    outputs[1].first = "multimerge_simd";
+    mm::multimerge_simd(runs, &outputs[1].second);
+    outputs[2].first = "multimerge_pq";
+    mm::multimerge_pq(runs, &outputs[2].second);
+    outputs[3].first = "multimerge_lt";
+    mm::multimerge_lt(runs, &outputs[3].second);
+    outputs[4].first = "multimerge_gallop";
+    mm::multimerge_gallop(runs, &outputs[4].second);
+    outputs[5].first = "multimerge_fenced";
+    mm::multimerge_fenced(runs, &outputs[5].second, mm::kLoserTree, nullptr);
+    outputs[6].first = "multimerge_par";
+    mm::multimerge_par(runs, &outputs[6].second, 3, mm::kLoserTree);
+    outputs[7].first = "FlatMergeCursor";
+    {
+      mm::FlatMergeCursor cursor(runs);
+      int buffer[5];
+      size_t nr;
+      while ((nr = cursor.next_batch(buffer, 5)) > 0)
+        outputs[7].second.insert(outputs[7].second.end(), buffer,
+                                 buffer + nr);
+    }
+    outputs[8].first = "multimerge FlatMergeContext";
+    {
+      mm::FlatMergeContext context;
+      outputs[8].second.resize(runs.values.size());
+      if (!mm::multimerge(runs, outputs[8].second.data(),
+                          outputs[8].second.size(), &context,
+                          mm::kGalloping))
+        outputs[8].second.clear();
+    }
+    outputs[9].first = "int64_t multimerge_par";
+    {
+      mm::Int64Vector wide_output;
+      mm::multimerge_par(wide_runs, &wide_output, 2, mm::kPriorityQueue);
+      outputs[9].second.assign(wide_output.begin(), wide_output.end());
+    }
+    if (runs.size() != k || runs.values.size() != correct.size())
+      retval = false;
+    for (size_t o = 0; o < outputs.size(); ++o) {
+      if (outputs[o].second != correct) {
+        std::cout << outputs[o].first << " of FlatRuns differs from "
+                  << "multimerge_lt, trial " << trial << std::endl;
+        retval = false;
+      }
+    }
+  }
+
+  for (int d = 0; d < kNrDistributions; ++d) {
+    RunPlan plan;
+    plan_runs(50, 300, static_cast<Distribution>(d), 3, &plan);
+    mm::IntVectorVector arrays;
+    mm::FlatRuns        runs;
+    generate_arrays(plan, 2, &arrays);
+    generate_arrays(plan, 3, &runs);
+    bool same = runs.size() == arrays.size();
+    for (size_t i = 0; same && i < arrays.size(); ++i)
+      same = std::equal(arrays[i].begin(), arrays[i].end(), runs[i].begin())
+             && arrays[i].size() == static_cast<size_t>(runs[i].end()
+                                                        - runs[i].begin());
+    if (!same) {
+      std::cout << "generate_arrays FlatRuns differs from IntVectorVector, "
+                << kDistributionNames[d] << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "FlatRuns merges " << (retval ? "match" : "differ from")
+            << " IntVectorVector merges" << std::endl;
+  return retval;
+}
+
+// Test data for the in-place merge: random flat runs, some empty, with
+// repeats, merged in place with buffers of none, a few, and about sqrt(n)
+// ints, and in parallel on pools of 1 to 4 threads, each against
+// multimerge_lt; then a few runs long enough that the parallel merge cuts
+// its last pairs into parts, for each distribution.
+
+bool verify_inplace_data() {
+  std::mt19937 gen(24);
+  mm::WorkStealingPool pool1(1);
+  mm::WorkStealingPool pool3(3);
+  mm::WorkStealingPool pool4(4);
+  bool retval = true;
+  for (int trial = 0; trial < 60; ++trial) {
+    size_t k = trial % 17 * (trial % 4 == 0 ? 9 : 1);
+    mm::FlatRuns runs;
+    mm::IntVector run;
+    for (size_t i = 0; i < k; ++i) {
+      run.resize(gen() % 4 == 0 ? 0 : gen() % 80);
+      for (size_t j = 0; j < run.size(); ++j)
+        run[j] = gen() % 100 - 50;
+      std::sort(run.begin(), run.end());
+      runs.push_back(run.begin(), run.end());
+    }
+    mm::IntVector correct;
+    mm::multimerge_lt(runs, &correct);
+    std::vector<std::pair<std::string, mm::FlatRuns> > outputs(
+        7, std::make_pair(std::string(), runs));
+    outputs[0].first = "multimerge_inplace, no buffer";
+    mm::multimerge_inplace(&outputs[0].second, 0);
+    outputs[1].first = "multimerge_inplace, buffer 3";
+    mm::multimerge_inplace(&outputs[1].second, 3);
+    outputs[2].first = "multimerge_inplace";
+    mm::multimerge_inplace(&outputs[2].second);
+    outputs[3].first = "multimerge_inplace_par, 1 thread";
+    mm::multimerge_inplace_par(&outputs[3].second, &pool1, 5);
+    outputs[4].first = "multimerge_inplace_par, 3 threads, no buffer";
+    mm::multimerge_inplace_par(&outputs[4].second, &pool3, 0);
+    outputs[5].first = "multimerge_inplace_par, 4 threads";
+    mm::multimerge_inplace_par(&outputs[5].second, &pool4, 9);
+    outputs[6].first = "multimerge_inplace_par";
+    mm::multimerge_inplace_par(&outputs[6].second, 2);
+    for (size_t o = 0; o < outputs.size(); ++o) {
+      const mm::FlatRuns &merged = outputs[o].second;
+      if (merged.values != correct || merged.size() != (k > 0 ? 1 : 0)) {
+        std::cout << outputs[o].first << " differs from multimerge_lt, "
+                  << "trial " << trial << std::endl;
+        retval = false;
+      }
+    }
+  }
+
+  for (int d = 0; d < kNrDistributions; ++d) {
+    RunPlan plan;
+    plan_runs(5, 40000, static_cast<Distribution>(d), 5, &plan);
+    mm::FlatRuns runs;
+    generate_arrays(plan, 2, &runs);
+    mm::IntVector correct;
+    mm::multimerge_lt(runs, &correct);
+    mm::FlatRuns serial = runs;
+    mm::multimerge_inplace(&serial, 0);
+    mm::multimerge_inplace_par(&runs, &pool4, 100);
+    if (serial.values != correct || runs.values != correct) {
+      std::cout << (serial.values != correct ? "multimerge_inplace"
+                                             : "multimerge_inplace_par")
+                << " differs from multimerge_lt, " << kDistributionNames[d]
+                << std::endl;
+      retval = false;
+    }
+  }
+  std::cout << "in-place merges " << (retval ? "match" : "differ from")
+            << " multimerge_lt" << std::endl;
+  return retval;
+}
+
+// The sinks of one fused merge: a distinct count, a group count, and a
+// histogram of buckets of 7 from -40, with values below and above.
+
+struct FusedSinks {
+  FusedSinks() : histogram(-40, 7, 9) {}
+
+  bool operator==(const FusedSinks &other) const {
+    return    distinct.count()     == other.distinct.count()
+           && groups.groups()      == other.groups.groups()
+           && histogram.counts()   == other.histogram.counts()
+           && histogram.nr_below() == other.histogram.nr_below()
+           && histogram.nr_above() == other.histogram.nr_above();
+  }
+
+  mm::DistinctCount distinct;
+  mm::GroupCount    groups;
+  mm::Histogram     histogram;
+};
+
+// Test data for the fused merges: random runs, some empty, with many
+// repeats, as an IntVectorVector and as FlatRuns, merged into each sink by
+// every method and in parallel on 1 to 5 threads, each against the sink
+// handed the values of multimerge_lt's output; and that output against
+// counts made by hand.  Sinks already handed lesser values are handed the
+// merge by multimerge_sink and by multimerge_par_sink, each against the
+// sink handed the lesser values and then the output.  A histogram of width
+// 0 counts as one of width 1.
+
+bool verify_sink_data() {
+  std::mt19937 gen(25);
+  bool retval = true;
+  const mm::MergeMethod methods[] = { mm::kLinear, mm::kPriorityQueue,
+                                      mm::kLoserTree, mm::kGalloping };
+  for (int trial = 0; trial < 40; ++trial) {
+    size_t k = trial % 11 * (trial % 3 == 0 ? 5 : 1);
+    mm::IntVectorVector arrays(k);
+    mm::FlatRuns        runs;
+    for (size_t i = 0; i < k; ++i) {
+      arrays[i].resize(gen() % 4 == 0 ? 0 : gen() % 70);
+      for (size_t j = 0; j < arrays[i].size(); ++j)
+        arrays[i][j] = gen() % 90 - 45;
+      std::sort(arrays[i].begin(), arrays[i].end());
+      runs.push_back(arrays[i].begin(), arrays[i].end());
+    }
+    mm::IntVector output;
+    mm::multimerge_lt(arrays, &output);
+    FusedSinks scanned;
+    for (size_t i = 0; i < output.size(); ++i) {
+      scanned.distinct(output[i]);
+      scanned.groups(output[i]);
+      scanned.histogram(output[i]);
+    }
+    const int lesser[] = { -60, -60, -50 };
+    FusedSinks filled;
+    for (size_t i = 0; i < sizeof(lesser) / sizeof(lesser[0]); ++i) {
+      filled.distinct(lesser[i]);
+      filled.groups(lesser[i]);
+      filled.histogram(lesser[i]);
+    }
+    FusedSinks after(filled);
+    for (size_t i = 0; i < output.size(); ++i) {
+      after.distinct(output[i]);
+      after.groups(output[i]);
+      after.histogram(output[i]);
+    }
+
+    size_t nr_distinct = std::unique(output.begin(), output.end())
+                         - output.begin();
+    size_t nr_below = 0;
+    size_t nr_above = 0;
+    std::vector<size_t> counts(9, 0);
+    for (size_t i = 0; i < k; ++i) {
+      for (size_t j = 0; j < arrays[i].size(); ++j) {
+        int value = arrays[i][j];
+        if (value < -40)
+          ++nr_below;
+        else if (value >= -40 + 7 * 9)
+          ++nr_above;
+        else
+          ++counts[(value + 40) / 7];
+      }
+    }
+    size_t nr_grouped = 0;
+    for (size_t g = 0; g < scanned.groups.groups().size(); ++g)
+      nr_grouped += scanned.groups.groups()[g].second;
+    if (   scanned.distinct.count()     != nr_distinct
+        || scanned.groups.groups().size() != nr_distinct
+        || nr_grouped                   != mm::total_length(arrays)
+        || scanned.histogram.counts()   != counts
+        || scanned.histogram.nr_below() != nr_below
+        || scanned.histogram.nr_above() != nr_above) {
+      std::cout << "sinks differ from counts by hand, trial " << trial
+                << std::endl;
+      retval = false;
+    }
+
+    std::vector<std::pair<std::string, FusedSinks> > fused;
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+      std::string method = std::to_string(methods[m]);
+      fused.push_back(std::make_pair("multimerge_sink method " + method,
+                                     FusedSinks()));
+      FusedSinks &sinks = fused.back().second;
+      mm::multimerge_sink(arrays, &sinks.distinct, methods[m]);
+      mm::multimerge_sink(arrays, &sinks.groups, methods[m]);
+      mm::multimerge_sink(arrays, &sinks.histogram, methods[m]);
+      fused.push_back(std::make_pair(
+          "multimerge_sink FlatRuns method " + method, FusedSinks()));
+      FusedSinks &flat_sinks = fused.back().second;
+      mm::multimerge_sink(runs, &flat_sinks.distinct, methods[m]);
+      mm::multimerge_sink(runs, &flat_sinks.groups, methods[m]);
+      mm::multimerge_sink(runs, &flat_sinks.histogram, methods[m]);
+    }
+    for (int nr_threads = 1; nr_threads <= 5; ++nr_threads) {
+      fused.push_back(std::make_pair(
+          "multimerge_par_sink " + std::to_string(nr_threads) + " threads",
+          FusedSinks()));
+      FusedSinks &sinks = fused.back().second;
+      mm::multimerge_par_sink(arrays, &sinks.distinct, nr_threads);
+      mm::multimerge_par_sink(runs, &sinks.groups, nr_threads,
+                              mm::kGalloping);
+      mm::multimerge_par_sink(arrays, &sinks.histogram, nr_threads,
+                              mm::kPriorityQueue);
+    }
+    FusedSinks again(filled);
+    mm::multimerge_sink(arrays, &again.distinct);
+    mm::multimerge_sink(runs, &again.groups, mm::kGalloping);
+    mm::multimerge_sink(arrays, &again.histogram, mm::kPriorityQueue);
+    if (!(again == after)) {
+      std::cout << "multimerge_sink into filled sinks differs from scans, "
+                << "trial " << trial << std::endl;
+      retval = false;
+    }
+    for (int nr_threads = 1; nr_threads <= 5; ++nr_threads) {
+      FusedSinks par_again(filled);
+      mm::multimerge_par_sink(arrays, &par_again.distinct, nr_threads);
+      mm::multimerge_par_sink(runs, &par_again.groups, nr_threads,
+                              mm::kGalloping);
+      mm::multimerge_par_sink(arrays, &par_again.histogram, nr_threads,
+                              mm::kPriorityQueue);
+      if (!(par_again == after)) {
+        std::cout << "multimerge_par_sink into filled sinks on " << nr_threads
+                  << " threads differs from scans, trial " << trial
+                  << std::endl;
+        retval = false;
+      }
+    }
+    mm::Histogram zero_width(-3, 0, 7);
+    mm::Histogram unit_width(-3, 1, 7);
+    mm::multimerge_sink(arrays, &zero_width);
+    mm::multimerge_sink(arrays, &unit_width);
+    if (   zero_width.counts()   != unit_width.counts()
+        || zero_width.nr_below() != unit_width.nr_below()
+        || zero_width.nr_above() != unit_width.nr_above()) {
+      std::cout << "histogram of width 0 differs from width 1, trial "
+                << trial << std::endl;
+      retval = false;
+    }
+    for (size_t f = 0; f < fused.size(); ++f) {
+      if (!(fused[f].second == scanned)) {
+        std::cout << fused[f].first << " differs from scan of "
+                  << "multimerge_lt, trial " << trial << std::endl;
+        retval = false;
+      }
+    }
+  }
+  std::cout << "fused merges " << (retval ? "match" : "differ from")
+            << " scans of multimerge_lt" << std::endl;
+  return retval;
+}
+
+// An order-independent digest of a multiset of integers: the number of
+// values, and the sum modulo 2^64 of a 64-bit mix of each value, so that any
+// two orderings of the same values have the same digest, and a value lost,
+// added, or changed alters the sum with probability about 1 - 2^-64.  Values
+// are mixed as 64-bit, so an int and its widening to int64_t mix alike.
+
+struct MultisetDigest {
+  MultisetDigest() : nr_values(0), hash(0) {}
+
+  template <typename Value>
+  void add(Value value) {
+    // splitmix64's finalizer, spreading each value over all 64 bits.
+    uint64_t z = static_cast<uint64_t>(value) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    hash += z ^ (z >> 31);
+    ++nr_values;
+  }
+
+  template <typename Iterator>
+  void add(Iterator first, Iterator last) {
+    for (; first != last; ++first)
+      add(*first);
+  }
+
+  bool operator==(const MultisetDigest &other) const {
+    return nr_values == other.nr_values && hash == other.hash;
+  }
+
+  size_t   nr_values;
+  uint64_t hash;
+};
+
+// The digest of all the values of ranges, the expected digest of their
+// merge.
+
+template <typename Ranges>
+MultisetDigest input_digest(const Ranges &ranges) {
+  MultisetDigest digest;
+  for (auto it = ranges.begin(); it != ranges.end(); ++it)
+    digest.add(it->begin(), it->end());
+  return digest;
+}
+
+// Streaming check of merge output, given a piece at a time in order: that
+// the output is sorted, across pieces as well as within them, and that its
+// length and digest equal those of the inputs.  Only the last value seen and
+// the digest are kept, so no copy of the inputs or output is needed.
+
+template <typename Value>
+class OutputCheck {
+ public:
+  explicit OutputCheck(const MultisetDigest &expected)
+      : expected_(expected), sorted_(true), last_(0) {}
+
+  template <typename Iterator>
+  void add(Iterator first, Iterator last) {
+    for (; first != last; ++first) {
+      Value value = *first;
+      if (digest_.nr_values > 0 && value < last_)
+        sorted_ = false;
+      last_ = value;
+      digest_.add(value);
+    }
+  }
+
+  bool ok() const { return sorted_ && digest_ == expected_; }
+
+  // Why the output differs from the inputs, if it does.
+  std::string problem() const {
+    if (!sorted_)
+      return "not sorted";
+    if (digest_.nr_values != expected_.nr_values) {
+      return std::to_string(digest_.nr_values) + " values, not "
+             + std::to_string(expected_.nr_values);
+    }
+    return digest_.hash != expected_.hash ? "different values" : "";
+  }
+
+ private:
+  MultisetDigest expected_;
+  MultisetDigest digest_;
+  bool           sorted_;
+  Value          last_;
+};
+
+// Prints whether check found the output, labelled by label, to match the
+// inputs, and returns whether it did.
+
+template <typename Value>
+bool print_check(const std::string &label, const OutputCheck<Value> &check) {
+  if (check.ok()) {
+    std::cout << label << "matches      inputs" << std::endl;
+    return true;
+  }
+  std::cout << label << "differs from inputs: " << check.problem()
+            << std::endl;
+  return false;
+}
+
+// Benchmarks a merge into *poutput under the harness as name, checks the
+// output of the last trial against the inputs' digest expected, prints the
+// timings and the check, labelled by label, and adds the result to *preport.
+// The rates count the values merged, and the bytes read and written.
+// Returns whether the output matched.
+
+template <typename Vector>
+bool bench_merge(const std::string &name, const std::string &label,
+                 const TestCfg &cfg, const MultisetDigest &expected,
+                 Vector *poutput, const std::function<void()> &merge,
+                 mm::BenchmarkReport *preport) {
+  typedef typename Vector::value_type Value;
+  size_t n = expected.nr_values;
+  mm::BenchmarkResult result = mm::run_benchmark(name, n,
+                                                 2 * n * sizeof(Value),
+                                                 cfg.bench, merge);
+  OutputCheck<Value> check(expected);
+  check.add(poutput->begin(), poutput->end());
+  mm::BenchmarkReport::print(result, std::cout);
+  result.ok = print_check(label, check);
+  preport->add(result);
+  return result.ok;
+}
+
+// External merge test: writes arrays as run files in cfg.external_dir,
+// benchmarks merging them into an output file there within the memory
+// budget, checks the output file against the inputs' digest expected by
+// reading it back a piece at a time, and removes the files.
+
+bool test_external(const TestCfg &cfg, const mm::IntVectorVector &arrays,
+                   const MultisetDigest &expected,
+                   mm::BenchmarkReport *preport) {
+  std::vector<std::string> paths;
+  std::string output_path = cfg.external_dir + "/mmerge.out";
+  std::string error_msg;
+  bool ok = true;
+
+  for (size_t i = 0; ok && i < arrays.size(); ++i) {
+    std::ostringstream path;
+    path << cfg.external_dir << "/mmerge.run." << i;
+    paths.push_back(path.str());
+    ok = mm::write_run_file(paths.back(), arrays[i], &error_msg);
+  }
+
+  mm::ExternalMergeStats stats;
+  mm::BenchmarkResult    result;
+  if (ok) {
+    std::cout << "multimerge files, " << cfg.memory_budget_mb
+              << " MB budget" << std::endl;
+    size_t n = expected.nr_values;
+    result = mm::run_benchmark(
+                 "files", n, 2 * n * sizeof(int), cfg.bench, [&]() {
+      ok = ok && mm::multimerge_files(
+                     paths, output_path,
+                     static_cast<size_t>(cfg.memory_budget_mb) << 20,
+                     &stats, &error_msg);
+    });
+  }
+
+  if (ok) {
+    mm::BenchmarkReport::print(result, std::cout);
+    std::cout << "multimerge files " << stats.buffer_ints
+              << " ints per buffer, " << stats.nr_rounds << " rounds, "
+              << stats.nr_reads << " reads, " << stats.nr_writes
+              << " writes" << std::endl;
+
+    std::ifstream in(output_path.c_str(), std::ios::binary);
+    std::vector<int> buffer(1 << 16);
+    OutputCheck<int> check(expected);
+    while (in) {
+      in.read(reinterpret_cast<char *>(buffer.data()),
+              buffer.size() * sizeof(int));
+      check.add(buffer.begin(), buffer.begin() + in.gcount() / sizeof(int));
+    }
+    result.ok = ok = print_check("multimerge_files    ", check)
+                     && stats.nr_ints == expected.nr_values;
+    preport->add(result);
+  } else {
+    std::cout << error_msg << std::endl;
+  }
+
+  for (size_t i = 0; i < paths.size(); ++i)
+    std::remove(paths[i].c_str());
+  std::remove(output_path.c_str());
+  return ok;
+}
+
+// Automatic method test: loads or makes the calibration table, benchmarks
+// multimerge_auto, and reports the engine chosen, the effective k, and the
+// estimated and median times, with the ratio of the median time to that of
+// each engine benchmarked earlier, as found in *preport by name.
+
+bool test_auto(const TestCfg &cfg, const mm::IntVectorVector &arrays,
+               const MultisetDigest &expected,
+               mm::BenchmarkReport *preport) {
+  mm::MergeCalibration calibration;
+  std::string error_msg;
+  std::ifstream existing(cfg.calibration_path.c_str());
+  if (!cfg.calibration_path.empty() && existing) {
+    if (!calibration.load(cfg.calibration_path, &error_msg)) {
+      std::cout << error_msg << std::endl;
+      return false;
+    }
+    std::cout << "multimerge auto calibration read from "
+              << cfg.calibration_path << std::endl;
+  } else {
+    std::cout << "multimerge auto calibration" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    calibration.calibrate(1 << 18);
+    std::cout << "multimerge auto calibration took "
+              << std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start).count()
+              << " sec" << std::endl;
+    if (   !cfg.calibration_path.empty()
+        && !calibration.save(cfg.calibration_path, &error_msg)) {
+      std::cout << error_msg << std::endl;
+      return false;
+    }
+  }
+
+  double estimate;
+  mm::MergeEngine chosen = mm::choose_merge_engine(arrays, calibration,
+                                                   &estimate);
+  mm::IntVector output_auto;
+  std::cout << "multimerge auto" << std::endl;
+  bool cmp_ok = bench_merge("auto", "multimerge_auto     ", cfg, expected,
+                            &output_auto, [&]() {
+    mm::multimerge_auto(arrays, &output_auto, calibration);
+  }, preport);
+  double auto_sec = preport->find("auto")->median_sec;
+  std::cout << "multimerge auto chose " << mm::merge_engine_name(chosen)
+            << " at effective k " << mm::effective_nr_inputs(arrays)
+            << ", estimated " << estimate << " sec, took " << auto_sec
+            << " sec" << std::endl;
+  for (int e = 0; e < mm::kNrMergeEngines; ++e) {
+    const mm::BenchmarkResult *pengine = preport->find(
+        mm::merge_engine_name(static_cast<mm::MergeEngine>(e)));
+    if (pengine != nullptr && pengine->median_sec > 0.0) {
+      std::cout << "multimerge auto median over " << pengine->name << " "
+                << auto_sec / pengine->median_sec << std::endl;
+    }
+  }
+  return cmp_ok;
+}
+
+// Small-merge benchmark: cfg.nr_small_merges loser tree merges of
+// cfg.nr_inputs arrays of random lengths averaging about cfg.ave_input_len,
+// cycling through a few such problems generated first, by multimerge_lt into
+// a vector kept between merges and then by multimerge into a buffer with a
+// MergeContext.  Reports merges per second at the median and calls to
+// operator new per merge, which should be 0 for the context.  The outputs
+// are checked in a separate pass, untimed.
+
+bool test_small_merges(const TestCfg &cfg, mm::BenchmarkReport *preport) {
+  constexpr int kNrProblems = 64;
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> len_dist(1, 2 * cfg.ave_input_len - 1);
+  std::uniform_int_distribution<int> value_dist;
+  std::vector<mm::IntVectorVector> problems(kNrProblems);
+  std::vector<mm::IntVector>       expected(kNrProblems);
+  size_t max_total = 0;
+  for (int p = 0; p < kNrProblems; ++p) {
+    problems[p].resize(cfg.nr_inputs);
+    for (int i = 0; i < cfg.nr_inputs; ++i) {
+      mm::IntVector &array = problems[p][i];
+      array.resize(len_dist(gen));
+      std::generate(array.begin(), array.end(),
+                    [&]() { return value_dist(gen); });
+      std::sort(array.begin(), array.end());
+      expected[p].insert(expected[p].end(), array.begin(), array.end());
+    }
+    std::sort(expected[p].begin(), expected[p].end());
+    max_total = std::max(max_total, expected[p].size());
+  }
+
+  bool retval = true;
+  mm::IntVector output;
+  mm::IntVector buffer(max_total);
+  mm::MergeContext context;
+  context.reserve(cfg.nr_inputs);
+  for (int p = 0; p < kNrProblems; ++p) {
+    mm::multimerge_lt(problems[p], &output);
+    mm::multimerge(problems[p], buffer.data(), buffer.size(), &context);
+    if (   output != expected[p]
+        || !std::equal(output.begin(), output.end(), buffer.begin())) {
+      std::cout << "small merges differ from expected, problem " << p
+                << std::endl;
+      retval = false;
+    }
+  }
+
+  size_t nr_ints = 0;
+  for (int m = 0; m < cfg.nr_small_merges; ++m)
+    nr_ints += expected[m % kNrProblems].size();
+  for (int with_context = 0; with_context <= 1; ++with_context) {
+    const char *name = with_context ? "small_context" : "small_vector";
+    size_t allocations_start = nr_allocations;
+    mm::BenchmarkResult result = mm::run_benchmark(
+        name, nr_ints, 2 * nr_ints * sizeof(int), cfg.bench, [&]() {
+      for (int m = 0; m < cfg.nr_small_merges; ++m) {
+        const mm::IntVectorVector &arrays = problems[m % kNrProblems];
+        if (with_context)
+          mm::multimerge(arrays, buffer.data(), buffer.size(), &context);
+        else
+          mm::multimerge_lt(arrays, &output);
+      }
+    });
+    double nr_merges = static_cast<double>(cfg.nr_small_merges)
+                       * (cfg.bench.nr_warmups + cfg.bench.nr_trials);
+    mm::BenchmarkReport::print(result, std::cout);
+    std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    std::cout.precision(2);
+    std::cout << "small merges " << (with_context ? "context " : "vector  ")
+              << (result.median_sec > 0.0
+                  ? cfg.nr_small_merges / result.median_sec : 0.0)
+              << " merges/s, "
+              << (nr_allocations - allocations_start) / nr_merges
+              << " allocations per merge" << std::endl;
+    result.ok = retval;
+    preport->add(result);
+  }
+  return retval;
+}
+
+// The arrays as 64-bit keys of type Key, in the same order: each value times
+// 2^32, so that the keys fill the high half, and for unsigned keys with the
+// sign bit flipped, which maps signed order to unsigned order.
+
+template <typename Key>
+std::vector<std::vector<Key> > widen_keys(const mm::IntVectorVector &arrays) {
+  const uint64_t flip = std::is_signed<Key>::value ? 0 : 1ULL << 63;
+  std::vector<std::vector<Key> > wide(arrays.size());
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    wide[i].reserve(arrays[i].size());
+    for (size_t j = 0; j < arrays[i].size(); ++j) {
+      uint64_t v = static_cast<uint64_t>(static_cast<int64_t>(arrays[i][j]));
+      wide[i].push_back(static_cast<Key>((v << 32) ^ flip));
+    }
+  }
+  return wide;
+}
+
+// Benchmarks the priority queue, loser tree, and parallel methods on the
+// arrays widened to 64-bit keys of type Key, naming each result by that of
+// the int benchmark with suffix appended, and prints its rates relative to
+// the int benchmark's: the same comparisons, on twice the bytes.  Returns
+// false if any output was wrong.
+
+template <typename Key>
+bool test_wide_keys(const TestCfg &cfg, const mm::IntVectorVector &arrays,
+                    int nr_threads, const std::string &suffix,
+                    mm::BenchmarkReport *preport) {
+  std::vector<std::vector<Key> > wide = widen_keys<Key>(arrays);
+  MultisetDigest expected = input_digest(wide);
+  std::vector<Key> output;
+  std::string key_name = std::is_signed<Key>::value ? "int64_t" : "uint64_t";
+  bool retval = true;
+
+  std::cout << "multimerge priority queue, " << key_name << " keys"
+            << std::endl;
+  if (!bench_merge("pq" + suffix, "multimerge_pq" + suffix + "   ", cfg,
+                   expected, &output,
+                   [&]() { mm::multimerge_pq(wide, &output); }, preport))
+    retval = false;
+
+  std::cout << "multimerge loser tree, " << key_name << " keys" << std::endl;
+  if (!bench_merge("lt" + suffix, "multimerge_lt" + suffix + "   ", cfg,
+                   expected, &output,
+                   [&]() { mm::multimerge_lt(wide, &output); }, preport))
+    retval = false;
+
+  std::cout << "multimerge parallel loser tree, " << key_name << " keys, "
+            << nr_threads << " threads" << std::endl;
+  if (!bench_merge("par" + suffix, "multimerge_par" + suffix + "  ", cfg,
+                   expected, &output,
+                   [&]() {
+                     mm::multimerge_par(wide, &output, nr_threads,
+                                        mm::kLoserTree);
+                   }, preport))
+    retval = false;
+
+  const char *names[] = { "pq", "lt", "par" };
+  for (size_t m = 0; m < sizeof(names) / sizeof(names[0]); ++m) {
+    const mm::BenchmarkResult *pnarrow = preport->find(names[m]);
+    const mm::BenchmarkResult *pwide   = preport->find(names[m] + suffix);
+    if (   pnarrow != nullptr && pwide != nullptr
+        && pnarrow->elements_per_sec > 0.0 && pnarrow->bytes_per_sec > 0.0) {
+      std::cout << "multimerge_" << names[m] << suffix << " over int, "
+                << "elements/s " << pwide->elements_per_sec
+                                    / pnarrow->elements_per_sec
+                << ", bytes/s " << pwide->bytes_per_sec
+                                   / pnarrow->bytes_per_sec << std::endl;
+    }
+  }
+  return retval;
+}
+
+// The larger tests: generates data per cfg and benchmarks each method on it,
+// adding the results to *preport.  Returns false if any output was wrong.
+
+bool test_large_data(const TestCfg &cfg, int nr_threads,
+                     mm::BenchmarkReport *preport) {
+  mm::IntVectorVector arrays;
+  auto start = std::chrono::steady_clock::now();
+  generate_data(cfg.nr_inputs, cfg.ave_input_len, cfg.distribution, cfg.seed,
+                nr_threads, &arrays);
+  std::cout << "generate_data took "
+            << std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start).count()
+            << " sec" << std::endl;
+  std::string error_msg;
+  if (   !cfg.output_path.empty()
+      && !mm::write_run_set(cfg.output_path, arrays, &error_msg)) {
+    std::cout << error_msg << std::endl;
+    return false;
+  }
+  MultisetDigest expected = input_digest(arrays);
+  preport->set("n", expected.nr_values);
+
+  bool retval = true;
+  mm::IntVector output;
+  std::cout << "multimerge priority queue" << std::endl;
+  if (!bench_merge("pq", "multimerge_pq       ", cfg, expected, &output,
+                   [&]() { mm::multimerge_pq(arrays, &output); }, preport))
+    retval = false;
+
+  std::cout << "multimerge loser tree" << std::endl;
+  if (!bench_merge("lt", "multimerge_lt       ", cfg, expected, &output,
+                   [&]() { mm::multimerge_lt(arrays, &output); }, preport))
+    retval = false;
+
+  std::cout << "multimerge galloping loser tree" << std::endl;
+  if (!bench_merge("gallop", "multimerge_gallop   ", cfg, expected, &output,
+                   [&]() { mm::multimerge_gallop(arrays, &output); },
+                   preport))
+    retval = false;
+  double lt_sec     = preport->find("lt")->median_sec;
+  double gallop_sec = preport->find("gallop")->median_sec;
+  std::cout << "multimerge_gallop median speedup over multimerge_lt "
+            << (gallop_sec > 0.0 ? lt_sec / gallop_sec : 0.0) << std::endl;
+
+  std::cout << "multimerge fenced loser tree" << std::endl;
+  mm::FenceStats fence_stats;
+  if (!bench_merge("fenced", "multimerge_fenced   ", cfg, expected, &output,
+                   [&]() {
+                     mm::multimerge_fenced(arrays, &output, mm::kLoserTree,
+                                           &fence_stats);
+                   }, preport))
+    retval = false;
+  double copied_fraction = expected.nr_values > 0
+                           ?   static_cast<double>(fence_stats.nr_copied)
+                             / expected.nr_values
+                           : 0.0;
+  double fenced_sec = preport->find("fenced")->median_sec;
+  std::cout << "multimerge_fenced copied " << copied_fraction
+            << " of the values, merged the rest in "
+            << fence_stats.nr_windows << " windows" << std::endl
+            << "multimerge_fenced median speedup over multimerge_lt "
+            << (fenced_sec > 0.0 ? lt_sec / fenced_sec : 0.0) << std::endl;
+  preport->set("fenced_copied_fraction", copied_fraction);
+
+  // The packed merges' rates count the packed bytes read, not 4 per value,
+  // and the bytes written, 4 per value or packed.
+  std::cout << "multimerge packed runs, loser tree" << std::endl;
+  mm::PackedRunVector runs;
+  start = std::chrono::steady_clock::now();
+  mm::pack_runs(arrays, &runs);
+  double pack_sec = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+  size_t n            = expected.nr_values;
+  size_t packed_bytes = 0;
+  for (size_t i = 0; i < runs.size(); ++i)
+    packed_bytes += runs[i].nr_bytes();
+  double bytes_per_value = n > 0 ? static_cast<double>(packed_bytes) / n
+                                 : 0.0;
+  std::cout << "pack_runs took " << pack_sec << " sec, "
+            << bytes_per_value << " bytes per value against "
+            << sizeof(int) << std::endl;
+  preport->set("packed_bytes_per_value", bytes_per_value);
+  mm::BenchmarkResult result = mm::run_benchmark(
+      "packed", n, packed_bytes + n * sizeof(int), cfg.bench,
+      [&]() { mm::multimerge_packed(runs, &output); });
+  {
+    OutputCheck<int> check(expected);
+    check.add(output.begin(), output.end());
+    mm::BenchmarkReport::print(result, std::cout);
+    result.ok = print_check("multimerge_packed   ", check);
+    retval = retval && result.ok;
+    preport->add(result);
+  }
+  mm::PackedRun packed_output;
+  mm::multimerge_packed(runs, &packed_output);
+  result = mm::run_benchmark(
+      "packed_repack", n, packed_bytes + packed_output.nr_bytes(), cfg.bench,
+      [&]() { mm::multimerge_packed(runs, &packed_output); });
+  {
+    packed_output.decode(&output);
+    OutputCheck<int> check(expected);
+    check.add(output.begin(), output.end());
+    mm::BenchmarkReport::print(result, std::cout);
+    result.ok = print_check("multimerge_repacked  ", check);
+    retval = retval && result.ok;
+    preport->add(result);
+  }
+  double packed_sec = preport->find("packed")->median_sec;
+  double repack_sec = preport->find("packed_repack")->median_sec;
+  std::cout << "multimerge_packed output "
+            << (n > 0 ? static_cast<double>(packed_output.nr_bytes()) / n
+                      : 0.0)
+            << " bytes per value repacked" << std::endl
+            << "multimerge_packed median speedup over multimerge_lt "
+            << (packed_sec > 0.0 ? lt_sec / packed_sec : 0.0)
+            << ", repacked "
+            << (repack_sec > 0.0 ? lt_sec / repack_sec : 0.0) << std::endl;
+  runs.clear();
+  runs.shrink_to_fit();
+  output.clear();
+  output.shrink_to_fit();
+
+  // The cursor's output is checked batch by batch, as a consumer pipelined
+  // with the merge would use it, in a buffer of constant size; the check is
+  // part of what is timed.
+
+  {
+    constexpr size_t kBatch = 4096;
+    std::vector<int> buffer(kBatch);
+    OutputCheck<int> check(expected);
+    std::cout << "multimerge cursor, batches of " << kBatch << std::endl;
+    size_t n = expected.nr_values;
+    mm::BenchmarkResult result = mm::run_benchmark(
+        "cursor", n, 2 * n * sizeof(int), cfg.bench, [&]() {
+      check = OutputCheck<int>(expected);
+      mm::MergeCursor cursor(arrays);
+      size_t nr;
+      while ((nr = cursor.next_batch(buffer.data(), kBatch)) > 0)
+        check.add(buffer.begin(), buffer.begin() + nr);
+    });
+    mm::BenchmarkReport::print(result, std::cout);
+    result.ok = print_check("MergeCursor         ", check);
+    if (!result.ok)
+      retval = false;
+    preport->add(result);
+  }
+
+  std::cout << "multimerge parallel loser tree, " << nr_threads << " threads"
+            << std::endl;
+  if (!bench_merge("par", "multimerge_par      ", cfg, expected, &output,
+                   [&]() {
+                     mm::multimerge_par(arrays, &output, nr_threads,
+                                        mm::kLoserTree);
+                   }, preport))
+    retval = false;
+  double par_sec = preport->find("par")->median_sec;
+  std::cout << "multimerge_par median speedup over multimerge_lt "
+            << (par_sec > 0.0 ? lt_sec / par_sec : 0.0) << std::endl;
+  output.clear();
+  output.shrink_to_fit();
+
+  if (   !cfg.external_dir.empty()
+      && !test_external(cfg, arrays, expected, preport))
+    retval = false;
+
+  if (cfg.nr_inputs <= mm::kMaxSimdInputs) {
+    std::cout << "multimerge simd" << std::endl;
+    if (!bench_merge("simd", "multimerge_simd     ", cfg, expected,
+                     &output,
+                     [&]() { mm::multimerge_simd(arrays, &output); },
+                     preport))
+      retval = false;
+  }
+
+  if (cfg.do_multimerge_lin) {
+    std::cout << "multimerge linear" << std::endl;
+    if (!bench_merge("lin", "multimerge (linear) ", cfg, expected, &output,
+                     [&]() { mm::multimerge(arrays, &output); }, preport))
+      retval = false;
+  }
+  output.clear();
+  output.shrink_to_fit();
+
+  if (cfg.do_wide_keys) {
+    if (!test_wide_keys<int64_t>(cfg, arrays, nr_threads, "_i64", preport))
+      retval = false;
+    if (!test_wide_keys<uint64_t>(cfg, arrays, nr_threads, "_u64", preport))
+      retval = false;
+  }
+
+  if (!test_auto(cfg, arrays, expected, preport))
+    retval = false;
+
+  return retval;
+}
+
+// The sort benchmark: parallel_sort, on a pool of nr_threads, against
+// std::sort and std::stable_sort, on uniformly random ints, n = 10^4, 10^5,
+// ... and nr_inputs * ave_input_len, adding the results to *preport.  Each
+// trial first copies the unsorted input, the same for every sort.  Returns
+// false if any output was wrong.
+
+bool test_sort(const TestCfg &cfg, int nr_threads,
+               mm::BenchmarkReport *preport) {
+  size_t max_n = static_cast<size_t>(cfg.nr_inputs) * cfg.ave_input_len;
+  std::vector<size_t> sizes;
+  for (size_t n = 10000; n < max_n; n *= 10)
+    sizes.push_back(n);
+  sizes.push_back(max_n);
+
+  mm::WorkStealingPool pool(nr_threads);
+  std::mt19937 gen(cfg.seed);
+  std::uniform_int_distribution<int> value_dist;
+  bool retval = true;
+  for (size_t s = 0; s < sizes.size(); ++s) {
+    size_t n = sizes[s];
+    mm::IntVector input(n);
+    std::generate(input.begin(), input.end(),
+                  [&]() { return value_dist(gen); });
+    MultisetDigest expected;
+    expected.add(input.begin(), input.end());
+    mm::IntVector values;
+    std::string suffix = "_" + std::to_string(n);
+    std::cout << "sort n " << n << std::endl;
+
+    if (!bench_merge("std_sort" + suffix, "std::sort           ", cfg,
+                     expected, &values,
+                     [&]() {
+                       values = input;
+                       std::sort(values.begin(), values.end());
+                     }, preport))
+      retval = false;
+    if (!bench_merge("stable_sort" + suffix, "std::stable_sort    ", cfg,
+                     expected, &values,
+                     [&]() {
+                       values = input;
+                       std::stable_sort(values.begin(), values.end());
+                     }, preport))
+      retval = false;
+    mm::SortStats stats;
+    if (!bench_merge("parallel_sort" + suffix, "parallel_sort       ", cfg,
+                     expected, &values,
+                     [&]() {
+                       values = input;
+                       mm::parallel_sort(&values, &pool, mm::kLoserTree,
+                                         &stats);
+                     }, preport))
+      retval = false;
+
+    double sort_sec     = preport->find("std_sort" + suffix)->median_sec;
+    double parallel_sec = preport->find("parallel_sort" + suffix)->median_sec;
+    double phases_sec   = stats.sort_sec + stats.merge_sec;
+    std::cout << "parallel_sort " << stats.nr_chunks << " chunks on "
+              << nr_threads << " threads, last trial: chunk sorts "
+              << stats.sort_sec << " sec, merge " << stats.merge_sec
+              << " sec, merge share "
+              << (phases_sec > 0.0 ? stats.merge_sec / phases_sec : 0.0)
+              << ", " << stats.nr_steals << " steals" << std::endl
+              << "parallel_sort median speedup over std::sort "
+              << (parallel_sec > 0.0 ? sort_sec / parallel_sec : 0.0)
+              << std::endl;
+  }
+  return retval;
+}
+
+// The latency at fraction q of secs, sorted, in microseconds.
+
+static double percentile_usec(const std::vector<double> &secs, double q) {
+  if (secs.empty())
+    return 0.0;
+  return 1e6 * secs[std::min(secs.size() - 1,
+                             static_cast<size_t>(q * secs.size()))];
+}
+
+// The batch benchmark: jobs of 4 to 64 arrays each of about ave_input_len
+// random ints, in batches of 100, 1000, ... and nr_jobs, merged one at a
+// time by multimerge_pq and by multimerge_batch on pools of 1, 2, 4, ...
+// and nr_threads threads, adding the results to *preport.  Prints jobs per
+// second and the median and tail of the latency of a job, from the start of
+// its batch to its output, over the last trial.  Returns false if any
+// output was wrong.
+
+bool test_batch(const TestCfg &cfg, int nr_threads,
+                mm::BenchmarkReport *preport) {
+  constexpr int kMinJobInputs = 4;
+  constexpr int kMaxJobInputs = 64;
+  size_t max_jobs = cfg.nr_batch_jobs;
+  std::mt19937 gen(cfg.seed);
+  std::uniform_int_distribution<int> k_dist(kMinJobInputs, kMaxJobInputs);
+  std::uniform_int_distribution<int> len_dist(1, 2 * cfg.ave_input_len - 1);
+  std::uniform_int_distribution<int> value_dist;
+  std::vector<mm::IntVectorVector>         jobs(max_jobs);
+  std::vector<const mm::IntVectorVector *> job_ptrs(max_jobs);
+  std::vector<mm::IntVector>               expected(max_jobs);
+  for (size_t j = 0; j < max_jobs; ++j) {
+    jobs[j].resize(k_dist(gen));
+    for (size_t i = 0; i < jobs[j].size(); ++i) {
+      mm::IntVector &array = jobs[j][i];
+      array.resize(len_dist(gen));
+      std::generate(array.begin(), array.end(),
+                    [&]() { return value_dist(gen); });
+      std::sort(array.begin(), array.end());
+      expected[j].insert(expected[j].end(), array.begin(), array.end());
+    }
+    std::sort(expected[j].begin(), expected[j].end());
+    job_ptrs[j] = &jobs[j];
+  }
+  std::vector<size_t> batch_sizes;
+  for (size_t b = 100; b < max_jobs; b *= 10)
+    batch_sizes.push_back(b);
+  batch_sizes.push_back(max_jobs);
+  std::vector<int> thread_counts;
+  for (int t = 1; t < nr_threads; t *= 2)
+    thread_counts.push_back(t);
+  thread_counts.push_back(nr_threads);
+
+  bool retval = true;
+  std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+  std::cout.precision(2);
+  for (size_t s = 0; s < batch_sizes.size(); ++s) {
+    size_t nr_jobs = batch_sizes[s];
+    std::vector<const mm::IntVectorVector *> batch_jobs(
+        job_ptrs.begin(), job_ptrs.begin() + nr_jobs);
+    size_t nr_ints = 0;
+    for (size_t j = 0; j < nr_jobs; ++j)
+      nr_ints += expected[j].size();
+    std::string suffix = "_" + std::to_string(nr_jobs);
+    std::cout << "batch of " << nr_jobs << " jobs, " << nr_ints << " ints"
+              << std::endl;
+
+    // One at a time, as a handler would, each into its own vector.
+    std::vector<mm::IntVector> outputs(nr_jobs);
+    std::vector<double>        job_sec(nr_jobs);
+    bool ok = true;
+    mm::BenchmarkResult result = mm::run_benchmark(
+        "serial" + suffix, nr_ints, 2 * nr_ints * sizeof(int), cfg.bench,
+        [&]() {
+      auto start = std::chrono::steady_clock::now();
+      for (size_t j = 0; j < nr_jobs; ++j) {
+        mm::multimerge_pq(jobs[j], &outputs[j]);
+        job_sec[j] = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+      }
+    });
+    for (size_t j = 0; j < nr_jobs; ++j)
+      ok = ok && outputs[j] == expected[j];
+    result.ok = ok;
+    retval = retval && ok;
+    std::sort(job_sec.begin(), job_sec.end());
+    std::cout << "serial multimerge_pq       "
+              << nr_jobs / result.median_sec << " jobs/s, latency p50 "
+              << percentile_usec(job_sec, 0.5) << " p99 "
+              << percentile_usec(job_sec, 0.99) << " max "
+              << percentile_usec(job_sec, 1.0) << " usec"
+              << (ok ? "" : ", output wrong") << std::endl;
+    preport->add(result);
+
+    for (size_t c = 0; c < thread_counts.size(); ++c) {
+      int threads = thread_counts[c];
+      mm::WorkStealingPool pool(threads);
+      mm::BatchOutput batch;
+      mm::BatchStats  stats;
+      result = mm::run_benchmark(
+          "batch" + suffix + "_t" + std::to_string(threads), nr_ints,
+          2 * nr_ints * sizeof(int), cfg.bench, [&]() {
+        mm::multimerge_batch(batch_jobs, &pool, mm::kLoserTree, &batch,
+                             &stats);
+      });
+      ok = true;
+      for (size_t j = 0; j < nr_jobs; ++j)
+        ok = ok && std::equal(expected[j].begin(), expected[j].end(),
+                              batch.arena.begin() + batch.offsets[j]);
+      result.ok = ok;
+      retval = retval && ok;
+      std::sort(stats.job_sec.begin(), stats.job_sec.end());
+      std::cout << "multimerge_batch " << threads << " thr"
+                << (threads < 10 ? "   " : "  ")
+                << nr_jobs / result.median_sec << " jobs/s, latency p50 "
+                << percentile_usec(stats.job_sec, 0.5) << " p99 "
+                << percentile_usec(stats.job_sec, 0.99) << " max "
+                << percentile_usec(stats.job_sec, 1.0) << " usec, "
+                << stats.nr_tasks << " tasks, " << stats.nr_steals
+                << " steals" << (ok ? "" : ", output wrong") << std::endl;
+      preport->add(result);
+    }
+  }
+  return retval;
+}
+
+// The flat layout benchmark: the data of cfg, typically many short arrays,
+// built (and freed) as an IntVectorVector and as FlatRuns from values
+// already generated, as when runs are loaded, since seeding a generator per
+// array in generate_data would swamp the difference, and merged by the
+// priority queue, loser tree, galloping, and parallel methods in each
+// layout, adding the results to *preport.  Returns false if any output was
+// wrong.
+
+bool test_flat(const TestCfg &cfg, int nr_threads,
+               mm::BenchmarkReport *preport) {
+  RunPlan plan;
+  plan_runs(cfg.nr_inputs, cfg.ave_input_len, cfg.distribution, cfg.seed,
+            &plan);
+  size_t n = calc_display_stats(plan.lens, cfg.ave_input_len);
+  preport->set("n", n);
+  mm::FlatRuns runs;
+  generate_arrays(plan, nr_threads, &runs);
+  size_t k = runs.size();
+
+  std::cout << "build IntVectorVector and FlatRuns" << std::endl;
+  mm::BenchmarkResult result = mm::run_benchmark(
+      "build_vectors", n, 2 * n * sizeof(int), cfg.bench, [&]() {
+    mm::IntVectorVector built(k);
+    for (size_t i = 0; i < k; ++i)
+      built[i].assign(runs[i].begin(), runs[i].end());
+  });
+  mm::BenchmarkReport::print(result, std::cout);
+  preport->add(result);
+  result = mm::run_benchmark(
+      "build_flat", n, 2 * n * sizeof(int), cfg.bench, [&]() {
+    mm::FlatRuns built;
+    built.reserve(k, n);
+    for (size_t i = 0; i < k; ++i)
+      built.push_back(runs[i].begin(), runs[i].end());
+  });
+  mm::BenchmarkReport::print(result, std::cout);
+  preport->add(result);
+  double vectors_sec = preport->find("build_vectors")->median_sec;
+  double flat_sec    = preport->find("build_flat")->median_sec;
+  std::cout << "FlatRuns median build speedup over IntVectorVector "
+            << (flat_sec > 0.0 ? vectors_sec / flat_sec : 0.0) << std::endl;
+
+  mm::IntVectorVector arrays(k);
+  for (size_t i = 0; i < k; ++i)
+    arrays[i].assign(runs[i].begin(), runs[i].end());
+  MultisetDigest expected = input_digest(arrays);
+  mm::IntVector output;
+  bool retval = true;
+  struct Method {
+    std::string           name;
+    std::function<void()> merge_vectors;
+    std::function<void()> merge_flat;
+  };
+  const Method methods[] = {
+    { "pq",     [&]() { mm::multimerge_pq(arrays, &output); },
+                [&]() { mm::multimerge_pq(runs, &output); } },
+    { "lt",     [&]() { mm::multimerge_lt(arrays, &output); },
+                [&]() { mm::multimerge_lt(runs, &output); } },
+    { "gallop", [&]() { mm::multimerge_gallop(arrays, &output); },
+                [&]() { mm::multimerge_gallop(runs, &output); } },
+    { "par",    [&]() { mm::multimerge_par(arrays, &output, nr_threads,
+                                           mm::kLoserTree); },
+                [&]() { mm::multimerge_par(runs, &output, nr_threads,
+                                           mm::kLoserTree); } }
+  };
+  for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+    const std::string &name = methods[m].name;
+    std::string label = "multimerge_" + name;
+    label.resize(20, ' ');
+    std::cout << "multimerge " << name << " IntVectorVector and FlatRuns"
+              << std::endl;
+    if (!bench_merge(name + "_vectors", label, cfg, expected, &output,
+                     methods[m].merge_vectors, preport))
+      retval = false;
+    if (!bench_merge(name + "_flat", label, cfg, expected, &output,
+                     methods[m].merge_flat, preport))
+      retval = false;
+    vectors_sec = preport->find(name + "_vectors")->median_sec;
+    flat_sec    = preport->find(name + "_flat")->median_sec;
+    std::cout << "FlatRuns median " << name << " speedup over IntVectorVector "
+              << (flat_sec > 0.0 ? vectors_sec / flat_sec : 0.0) << std::endl;
+  }
+  return retval;
+}
+
+// The in-place benchmark: the data of cfg as FlatRuns, merged into a
+// separate output by multimerge_pq and in place by multimerge_inplace with
+// no buffer and with about sqrt(n) ints, and by multimerge_inplace_par,
+// adding the results to *preport.  Each in-place trial first copies the
+// runs back from a copy kept, as the sort benchmark copies its input.  Each
+// merge is then run once more for its peak resident set size above the
+// size before it, the memory the merge itself takes.  Returns false if any
+// output was wrong.
+
+bool test_inplace(const TestCfg &cfg, int nr_threads,
+                  mm::BenchmarkReport *preport) {
+  mm::FlatRuns input;
+  generate_data(cfg.nr_inputs, cfg.ave_input_len, cfg.distribution, cfg.seed,
+                nr_threads, &input);
+  size_t n = input.values.size();
+  preport->set("n", n);
+  MultisetDigest expected;
+  expected.add(input.values.begin(), input.values.end());
+  size_t buffer_len = static_cast<size_t>(std::sqrt(static_cast<double>(n)))
+                      + 1;
+  mm::WorkStealingPool pool(nr_threads);
+  mm::FlatRuns  runs = input;
+  mm::IntVector output;
+
+  struct Method {
+    std::string           name;
+    std::string           label;
+    mm::IntVector        *poutput;
+    std::function<void()> merge;
+  };
+  const Method methods[] = {
+    { "pq",            "multimerge_pq       ", &output,
+      [&]() { mm::multimerge_pq(runs, &output); } },
+    { "inplace_nobuf", "inplace, no buffer  ", &runs.values,
+      [&]() { runs = input; mm::multimerge_inplace(&runs, 0); } },
+    { "inplace",       "multimerge_inplace  ", &runs.values,
+      [&]() { runs = input; mm::multimerge_inplace(&runs, buffer_len); } },
+    { "inplace_par",   "inplace_par         ", &runs.values,
+      [&]() {
+        runs = input;
+        mm::multimerge_inplace_par(&runs, &pool, buffer_len);
+      } }
+  };
+  bool retval = true;
+  bool rss_ok = mm::reset_peak_rss();
+  if (!rss_ok)
+    std::cout << "peak RSS cannot be reset, not measured" << std::endl;
+  std::cout << "in-place buffer " << buffer_len << " ints per thread, "
+            << nr_threads << " threads" << std::endl;
+  for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+    const Method &method = methods[m];
+    runs = input;
+    if (!bench_merge(method.name, method.label, cfg, expected,
+                     method.poutput, method.merge, preport))
+      retval = false;
+    if (rss_ok) {
+      runs = input;
+      mm::IntVector().swap(output);
+      mm::reset_peak_rss();
+      size_t before = mm::rss_bytes();
+      method.merge();
+      size_t peak  = mm::peak_rss_bytes();
+      double extra = peak > before ? (peak - before) / 1048576.0 : 0.0;
+      std::cout << method.label << "peak RSS " << peak / 1048576.0
+                << " MB, " << extra << " MB over the " << before / 1048576.0
+                << " MB before" << std::endl;
+      preport->set(method.name + "_peak_rss_mb", peak / 1048576.0);
+      preport->set(method.name + "_extra_rss_mb", extra);
+    }
+  }
+  double pq_sec = preport->find("pq")->median_sec;
+  for (size_t m = 1; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+    double sec = preport->find(methods[m].name)->median_sec;
+    std::cout << methods[m].label << "median time over multimerge_pq's "
+              << (pq_sec > 0.0 ? sec / pq_sec : 0.0) << std::endl;
+  }
+  return retval;
+}
+
+// Whether two sinks of a kind have the same results.
+
+static bool same_sink(const mm::DistinctCount &a, const mm::DistinctCount &b) {
+  return a.count() == b.count();
+}
+
+static bool same_sink(const mm::GroupCount &a, const mm::GroupCount &b) {
+  return a.groups() == b.groups();
+}
+
+static bool same_sink(const mm::Histogram &a, const mm::Histogram &b) {
+  return    a.counts() == b.counts() && a.nr_below() == b.nr_below()
+         && a.nr_above() == b.nr_above();
+}
+
+// Benchmarks the reduction of the merge of arrays by copies of empty, as
+// name: merged by multimerge_lt and the output then scanned, and fused by
+// multimerge_sink, and the same in parallel on nr_threads threads, adding
+// the results to *preport.  The scans' bytes count the output written and
+// read again.  Returns false if any fused result differs from its scan's.
+
+template <typename Sink>
+bool bench_fused(const std::string &name, const Sink &empty,
+                 const mm::IntVectorVector &arrays, mm::IntVector *poutput,
+                 const TestCfg &cfg, int nr_threads,
+                 mm::BenchmarkReport *preport) {
+  size_t n = mm::total_length(arrays);
+  Sink scanned(empty);
+  Sink fused(empty);
+  Sink par_scanned(empty);
+  Sink par_fused(empty);
+  auto scan = [&](Sink *psink) {
+    *psink = empty;
+    for (auto it = poutput->begin(); it != poutput->end(); ++it)
+      (*psink)(*it);
+  };
+  std::vector<mm::BenchmarkResult> results;
+  results.push_back(mm::run_benchmark(
+      name + "_scan", n, 3 * n * sizeof(int), cfg.bench, [&]() {
+    mm::multimerge_lt(arrays, poutput);
+    scan(&scanned);
+  }));
+  results.push_back(mm::run_benchmark(
+      name + "_fused", n, n * sizeof(int), cfg.bench, [&]() {
+    fused = empty;
+    mm::multimerge_sink(arrays, &fused);
+  }));
+  results.push_back(mm::run_benchmark(
+      name + "_par_scan", n, 3 * n * sizeof(int), cfg.bench, [&]() {
+    mm::multimerge_par(arrays, poutput, nr_threads, mm::kLoserTree);
+    scan(&par_scanned);
+  }));
+  results.push_back(mm::run_benchmark(
+      name + "_par_fused", n, n * sizeof(int), cfg.bench, [&]() {
+    par_fused = empty;
+    mm::multimerge_par_sink(arrays, &par_fused, nr_threads);
+  }));
+  results[1].ok = same_sink(fused, scanned);
+  results[3].ok = same_sink(par_fused, par_scanned);
+  for (size_t r = 0; r < results.size(); ++r) {
+    mm::BenchmarkReport::print(results[r], std::cout);
+    preport->add(results[r]);
+  }
+  std::cout << name << " fused " << (results[1].ok ? "matches" : "differs")
+            << ", median speedup over merge then scan "
+            << results[0].median_sec / results[1].median_sec
+            << "; parallel fused "
+            << (results[3].ok ? "matches" : "differs")
+            << ", median speedup "
+            << results[2].median_sec / results[3].median_sec << std::endl;
+  return results[1].ok && results[3].ok;
+}
+
+// The fused merge benchmark: the data of cfg reduced to its number of
+// distinct values, to the count of each value, and to a histogram of 1000
+// buckets spanning its values, by merge then scan and by fused merge, each
+// also in parallel on nr_threads threads, adding the results to *preport.
+// Returns false if any fused result was wrong.
+
+bool test_fused(const TestCfg &cfg, int nr_threads,
+                mm::BenchmarkReport *preport) {
+  mm::IntVectorVector arrays;
+  generate_data(cfg.nr_inputs, cfg.ave_input_len, cfg.distribution, cfg.seed,
+                nr_threads, &arrays);
+  preport->set("n", mm::total_length(arrays));
+  int lo = INT_MAX;
+  int hi = INT_MIN;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    if (!arrays[i].empty()) {
+      lo = std::min(lo, arrays[i].front());
+      hi = std::max(hi, arrays[i].back());
+    }
+  }
+  int width = lo <= hi ? static_cast<int>(
+                             (static_cast<int64_t>(hi) - lo) / 1000 + 1)
+                       : 1;
+  mm::IntVector output;
+  bool retval = true;
+  std::cout << "distinct count" << std::endl;
+  if (!bench_fused("distinct", mm::DistinctCount(), arrays, &output, cfg,
+                   nr_threads, preport))
+    retval = false;
+  std::cout << "group-by count" << std::endl;
+  if (!bench_fused("groups", mm::GroupCount(), arrays, &output, cfg,
+                   nr_threads, preport))
+    retval = false;
+  std::cout << "histogram of 1000 buckets of " << width << std::endl;
+  if (!bench_fused("histogram", mm::Histogram(lo, width, 1000), arrays,
+                   &output, cfg, nr_threads, preport))
+    retval = false;
+  return retval;
+}
+
+// Benchmarks the priority queue, loser tree, galloping, parallel, and with
+// -l linear methods on ranges, runs of a run-set file of Value, adding the
+// results to *preport.  Returns false if any output was wrong.
+
+template <typename Value>
+bool bench_run_set(const TestCfg &cfg,
+                   const std::vector<mm::IteratorRange<const Value *> >
+                       &ranges,
+                   int nr_threads, mm::BenchmarkReport *preport) {
+  size_t n = mm::total_length(ranges);
+  MultisetDigest expected = input_digest(ranges);
+  std::vector<Value> output(n);
+
+  bool retval = true;
+  std::cout << "multimerge priority queue" << std::endl;
+  if (!bench_merge("pq", "multimerge_pq       ", cfg, expected, &output,
+                   [&]() {
+                     mm::multimerge<Value>(ranges, output.data(),
+                                           mm::kPriorityQueue);
+                   }, preport))
+    retval = false;
+
+  std::cout << "multimerge loser tree" << std::endl;
+  if (!bench_merge("lt", "multimerge_lt       ", cfg, expected, &output,
+                   [&]() {
+                     mm::multimerge<Value>(ranges, output.data(),
+                                           mm::kLoserTree);
+                   }, preport))
+    retval = false;
+
+  std::cout << "multimerge galloping loser tree" << std::endl;
+  if (!bench_merge("gallop", "multimerge_gallop   ", cfg, expected, &output,
+                   [&]() {
+                     mm::multimerge<Value>(ranges, output.data(),
+                                           mm::kGalloping);
+                   }, preport))
+    retval = false;
+
+  std::cout << "multimerge parallel loser tree, " << nr_threads << " threads"
+            << std::endl;
+  if (!bench_merge("par", "multimerge_par      ", cfg, expected, &output,
+                   [&]() {
+                     mm::multimerge_par<Value>(ranges, output.data(),
+                                               nr_threads, mm::kLoserTree);
+                   }, preport))
+    retval = false;
+
+  if (cfg.do_multimerge_lin) {
+    std::cout << "multimerge linear" << std::endl;
+    if (!bench_merge("lin", "multimerge (linear) ", cfg, expected, &output,
+                     [&]() {
+                       mm::multimerge<Value>(ranges, output.data(),
+                                             mm::kLinear);
+                     }, preport))
+      retval = false;
+  }
+  return retval;
+}
+
+// Benchmarks merging the runs of the run-set file cfg.input_path, mapped into
+// memory and merged where they lie by the templates of cc/mmergetemplate.h,
+// adding the results to *preport.  The values may be 32- or 64-bit.  The
+// methods with only an IntVectorVector interface, SIMD, cursor, external,
+// and automatic, are not run.  Returns false if the file could not be read
+// or any output was wrong.
+
+bool test_run_set(const TestCfg &cfg, int nr_threads,
+                  mm::BenchmarkReport *preport) {
+  mm::RunSetFile file;
+  std::string error_msg;
+  auto start = std::chrono::steady_clock::now();
+  if (!file.open(cfg.input_path, &error_msg)) {
+    std::cout << error_msg << std::endl;
+    return false;
+  }
+  std::cout << "run set " << cfg.input_path << " mapped in "
+            << std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start).count()
+            << " sec, " << 8 * file.value_size() << "-bit values" << std::endl;
+  size_t k = file.nr_runs();
+  mm::IntVector lens(k, 0);
+  for (size_t i = 0; i < k; ++i)
+    lens[i] = file.run_length(i);
+  size_t n = file.nr_values();
+  int ave_input_len = k == 0 ? 0 : n / k;
+  calc_display_stats(lens, ave_input_len);
+  preport->set("k", k);
+  preport->set("each", ave_input_len);
+  preport->set("n", n);
+  preport->set("input", cfg.input_path);
+  preport->set("value_bits", 8 * file.value_size());
+
+  if (file.value_size() == sizeof(int))
+    return bench_run_set(cfg, file.int_ranges(), nr_threads, preport);
+  return bench_run_set(cfg, file.int64_ranges(), nr_threads, preport);
+}
+
+// Test program for mmerge.cc.
+
+int testmmerge_main(int argc, char *argv[]) {
+  // Obtain parameters for more voluminous test data from the command line,
+  // or use the following defaults.
+
+  constexpr int max_nr_input_ints = 1000000000;  // 1 billion (Ok for 12GB RAM)
+                                                 // >= product of two following:
+  TestCfg cfg;
+  cfg.nr_inputs         = 1000;
+  cfg.ave_input_len     = 10000;
+  cfg.distribution      = kDistUniform;
+  cfg.seed              = 1;
+  cfg.nr_threads        = 0;
+  cfg.do_multimerge_lin = false;
+  cfg.do_wide_keys      = false;
+  cfg.memory_budget_mb  = 64;
+  cfg.nr_small_merges   = 0;
+  cfg.do_sort           = false;
+  cfg.nr_batch_jobs     = 0;
+  cfg.do_flat           = false;
+  cfg.do_inplace        = false;
+  cfg.do_fused          = false;
+  cfg.bench.nr_warmups  = 0;
+  cfg.bench.nr_trials   = 1;
+  cfg.bench.pcounters   = nullptr;
+  cfg.count_hardware    = false;
+  bool help_only        = false;
+  bool error            = false;
+
+  get_cfg(argc, argv, max_nr_input_ints, &cfg, &help_only, &error);
+  if (help_only)
+    return 0;
+  else if (error)
+    return -1;
+
+  bool retval = true;  // set to false if any errors in merge output
+  if (!verify_small_data())
+    retval = false;
+  if (!verify_generic_data())
+    retval = false;
+  if (!verify_wide_data())
+    retval = false;
+  if (!verify_gallop_data())
+    retval = false;
+  if (!verify_fenced_data())
+    retval = false;
+  if (!verify_auto_choice())
+    retval = false;
+  if (!verify_parallel_sort())
+    retval = false;
+  if (!verify_stream_merge())
+    retval = false;
+  if (!verify_batch_merge())
+    retval = false;
+  if (!verify_packed_data())
+    retval = false;
+  if (!verify_flat_data())
+    retval = false;
+  if (!verify_inplace_data())
+    retval = false;
+  if (!verify_sink_data())
+    retval = false;
+
+  int nr_threads = cfg.nr_threads;
+  if (nr_threads == 0)
+    nr_threads = std::max(1U, std::thread::hardware_concurrency());
+  mm::BenchmarkReport report;
+  report.set("k", cfg.nr_inputs);
+  report.set("each", cfg.ave_input_len);
+  report.set("distribution", kDistributionNames[cfg.distribution]);
+  report.set("warmups", cfg.bench.nr_warmups);
+  report.set("trials", cfg.bench.nr_trials);
+  report.set("threads", nr_threads);
+
+  mm::PerfCounters counters;
+  if (cfg.count_hardware) {
+    std::string counter_msg;
+    if (counters.open(&counter_msg)) {
+      cfg.bench.pcounters = &counters;
+      std::cout << "hardware counters";
+      for (int c = 0; c < mm::kNrPerfCounters; ++c) {
+        mm::PerfCounter counter = static_cast<mm::PerfCounter>(c);
+        if (counters.available(counter))
+          std::cout << " " << mm::perf_counter_name(counter);
+      }
+      std::cout << std::endl;
+    } else {
+      std::cout << "hardware counters unavailable, timings only: "
+                << counter_msg << std::endl;
+    }
+  }
+
+  if (cfg.do_sort) {
+    if (!test_sort(cfg, nr_threads, &report))
+      retval = false;
+  } else if (cfg.do_flat) {
+    if (!test_flat(cfg, nr_threads, &report))
+      retval = false;
+  } else if (cfg.do_inplace) {
+    if (!test_inplace(cfg, nr_threads, &report))
+      retval = false;
+  } else if (cfg.do_fused) {
+    if (!test_fused(cfg, nr_threads, &report))
+      retval = false;
+  } else if (cfg.nr_batch_jobs > 0) {
+    report.set("jobs", cfg.nr_batch_jobs);
+    if (!test_batch(cfg, nr_threads, &report))
+      retval = false;
+  } else if (cfg.nr_small_merges > 0) {
+    report.set("merges", cfg.nr_small_merges);
+    if (!test_small_merges(cfg, &report))
+      retval = false;
+  } else if (!cfg.input_path.empty()) {
+    if (!test_run_set(cfg, nr_threads, &report))
+      retval = false;
+  } else if (!test_large_data(cfg, nr_threads, &report)) {
+    retval = false;
+  }
+
+  std::string error_msg;
+  if (!cfg.json_path.empty() && !report.write_json(cfg.json_path, &error_msg)) {
+    std::cout << error_msg << std::endl;
+    retval = false;
   }
 
   return retval ? 0 : -1;
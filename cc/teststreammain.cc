@@ -0,0 +1,310 @@
+// cc/teststreammain.cc rev. 17 October 2026 by Stuart Ambler.
+// Benchmark driver for the streaming merge of cc/mmergestream.h.
+// Copyright (c) 2026 Stuart Ambler.
+// Distributed under the Boost License in the accompanying file LICENSE.
+
+// Merges sorted event streams made while the merge runs: one producer thread
+// per stream makes events whose values are their creation times, in
+// nanoseconds of std::chrono::steady_clock, optionally at a fixed rate, and
+// pushes them in chunks through the stream's ring to the merger on the main
+// thread.  The merger takes the time once per output chunk; an event's
+// latency is that time less its value, from its creation to its leaving
+// the merge, including the wait for its input chunk to fill.  Reports the
+// throughput, the latency percentiles, and how often the merger waited.
+// streams are used in this test code despite discouragement for Google
+// style.
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <argtable2.h>
+#include "./mmergebench.h"
+#include "./mmergestream.h"
+
+namespace mm = ::com_zulazon_samples_cc_mmerge;
+
+// Configuration from the command line; see usage().
+
+struct StreamCfg {
+  int              nr_streams;
+  int              nr_events;      // per stream
+  int              chunk_len;      // events per input chunk
+  int              ring_chunks;    // chunks each ring holds
+  int              out_chunk_len;  // values per output chunk
+  double           rate;           // events per second per stream; 0 for
+                                   // as fast as possible
+  mm::BenchmarkCfg bench;
+  std::string      json_path;      // for the report; empty for none
+};
+
+void usage() {
+  const char *s = "Benchmark the streaming merge of sorted event streams.\n"
+"\n"
+"Usage:\n"
+"  ./teststreammain [<nr_streams> [<nr_events>]] [options]\n"
+"  ./teststreammain -h | --help\n"
+"\n"
+"Arguments:\n"
+"  <nr_streams>     Number of streams, each made by its own producer\n"
+"                   thread [default: 16].\n"
+"  <nr_events>      Number of events per stream [default: 1000000].\n"
+"\n"
+"Options:\n"
+"  -h --help        Show this help message and exit.\n"
+"  -c <len>         Events per chunk pushed by a producer [default: 256].\n"
+"  -q <nr_chunks>   Chunks each stream's ring holds before its producer\n"
+"                   waits [default: 64].\n"
+"  -o <len>         Values per output chunk of the merger [default: 4096].\n"
+"  -u <rate>        Events per second made by each producer; 0 means as\n"
+"                   fast as it can [default: 0].\n"
+"  -w <nr_warmups>  Untimed runs before the timed ones [default: 1].\n"
+"  -r <nr_trials>   Timed runs, summarized by median, 95th percentile, and\n"
+"                   mean with 95% confidence interval; latencies are of\n"
+"                   the last [default: 5].\n"
+"  -j <file>        Write the results to file as JSON.\n";
+  std::cout << s;
+}
+
+// Get and process command-line arguments.  See usage().
+
+void get_cfg(int argc, char *argv[], StreamCfg *pcfg, bool *p_help_only,
+             bool *p_error) {
+  struct arg_lit *help = arg_lit0("h", "help", "Show help message and exit.");
+  struct arg_int *nrs  = arg_int0(NULL, NULL, "<nr_streams>",
+                                  "Number of streams.");
+  struct arg_int *nre  = arg_int0(NULL, NULL, "<nr_events>",
+                                  "Number of events per stream.");
+  struct arg_int *chk  = arg_int0("c", "chunk", "<len>",
+                                  "Events per input chunk.");
+  struct arg_int *rng  = arg_int0("q", "queue", "<nr_chunks>",
+                                  "Chunks per ring.");
+  struct arg_int *och  = arg_int0("o", "output", "<len>",
+                                  "Values per output chunk.");
+  struct arg_dbl *rat  = arg_dbl0("u", "rate", "<rate>",
+                                  "Events per second per stream.");
+  struct arg_int *wrm  = arg_int0("w", "warmups", "<nr_warmups>",
+                                  "Untimed runs.");
+  struct arg_int *trl  = arg_int0("r", "trials", "<nr_trials>",
+                                  "Timed runs.");
+  struct arg_str *jsn  = arg_str0("j", "json", "<file>",
+                                  "File for the results as JSON.");
+  struct arg_end *end  = arg_end(20);
+  void *argtable[]     = { help, chk, rng, och, rat, wrm, trl, jsn, nrs, nre,
+                           end };
+  if (arg_nullcheck(argtable) != 0) {
+    std::cout << "Insufficient memory to parse command-line arguments.\n"
+              << std::endl;
+    *p_error = true;
+    return;
+  }
+  int nr_errors = arg_parse(argc, argv, argtable);
+  if (nr_errors == 0) {
+    if (help->count > 0) {
+      usage();
+      *p_help_only = true;
+    } else {
+      if (nrs->count > 0)
+        pcfg->nr_streams = nrs->ival[0];
+      if (nre->count > 0)
+        pcfg->nr_events = nre->ival[0];
+      if (chk->count > 0)
+        pcfg->chunk_len = chk->ival[0];
+      if (rng->count > 0)
+        pcfg->ring_chunks = rng->ival[0];
+      if (och->count > 0)
+        pcfg->out_chunk_len = och->ival[0];
+      if (rat->count > 0)
+        pcfg->rate = rat->dval[0];
+      if (wrm->count > 0)
+        pcfg->bench.nr_warmups = wrm->ival[0];
+      if (trl->count > 0)
+        pcfg->bench.nr_trials = trl->ival[0];
+      if (jsn->count > 0)
+        pcfg->json_path = jsn->sval[0];
+      if (   pcfg->nr_streams <= 0 || pcfg->nr_events < 0
+          || pcfg->chunk_len <= 0 || pcfg->ring_chunks <= 0
+          || pcfg->out_chunk_len <= 0 || pcfg->rate < 0.0
+          || pcfg->bench.nr_warmups < 0 || pcfg->bench.nr_trials <= 0) {
+        std::cout << "nr_streams, the lengths, nr_chunks, and nr_trials "
+                  << "must be positive, and nr_events, rate, and "
+                  << "nr_warmups not negative." << std::endl;
+        usage();
+        *p_error = true;
+      }
+    }
+  } else {
+    std::cout << "Incorrect usage.\n" << std::endl;
+    usage();
+    *p_error = true;
+  }
+  arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+}
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// What one run of the streams and merge found.
+
+struct StreamRun {
+  std::vector<int64_t> latencies;  // ns, in output order
+  size_t               nr_waits;
+  bool                 ok;         // output sorted and complete
+};
+
+// Runs the producers and the merge once per cfg.
+
+void run_streams(const StreamCfg &cfg, StreamRun *prun) {
+  std::vector<std::unique_ptr<mm::Int64SortedStream> > streams;
+  std::vector<mm::Int64SortedStream *>                 stream_ptrs;
+  for (int i = 0; i < cfg.nr_streams; ++i) {
+    streams.push_back(std::unique_ptr<mm::Int64SortedStream>(
+                          new mm::Int64SortedStream(cfg.ring_chunks)));
+    stream_ptrs.push_back(streams.back().get());
+  }
+  std::atomic<uint64_t> value_sum(0);
+  int64_t start = now_ns();
+  double  gap   = cfg.rate > 0.0 ? 1e9 / cfg.rate : 0.0;
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < cfg.nr_streams; ++i) {
+    producers.push_back(std::thread([&, i]() {
+      uint64_t sum = 0;
+      mm::Int64SortedStream::Chunk chunk;
+      for (int e = 0; e < cfg.nr_events; ++e) {
+        if (gap > 0.0) {
+          int64_t due = start + static_cast<int64_t>(e * gap);
+          while (now_ns() < due)
+            std::this_thread::yield();
+        }
+        chunk.push_back(now_ns());
+        sum += chunk.back();
+        if (chunk.size() == static_cast<size_t>(cfg.chunk_len)) {
+          streams[i]->push(&chunk);
+          chunk.clear();
+        }
+      }
+      if (!chunk.empty())
+        streams[i]->push(&chunk);
+      streams[i]->close();
+      value_sum += sum;
+    }));
+  }
+
+  mm::Int64StreamMerger merger(stream_ptrs);
+  std::vector<int64_t> buffer(cfg.out_chunk_len);
+  uint64_t output_sum = 0;
+  int64_t  last       = INT64_MIN;
+  bool     sorted     = true;
+  prun->latencies.clear();
+  prun->latencies.reserve(static_cast<size_t>(cfg.nr_streams)
+                          * cfg.nr_events);
+  size_t nr;
+  while ((nr = merger.next_chunk(buffer.data(), buffer.size())) > 0) {
+    int64_t emitted = now_ns();
+    for (size_t j = 0; j < nr; ++j) {
+      prun->latencies.push_back(emitted - buffer[j]);
+      output_sum += buffer[j];
+      sorted     &= last <= buffer[j];
+      last        = buffer[j];
+    }
+  }
+  for (size_t t = 0; t < producers.size(); ++t)
+    producers[t].join();
+  prun->nr_waits = merger.nr_waits();
+  prun->ok       =    sorted && output_sum == value_sum
+                   &&   prun->latencies.size()
+                      == static_cast<size_t>(cfg.nr_streams) * cfg.nr_events;
+}
+
+// The latency at fraction q of the sorted latencies, in microseconds.
+
+static double percentile_us(const std::vector<int64_t> &sorted, double q) {
+  if (sorted.empty())
+    return 0.0;
+  size_t i = std::min(sorted.size() - 1,
+                      static_cast<size_t>(q * sorted.size()));
+  return sorted[i] / 1000.0;
+}
+
+int main(int argc, char *argv[]) {
+  StreamCfg cfg;
+  cfg.nr_streams       = 16;
+  cfg.nr_events        = 1000000;
+  cfg.chunk_len        = 256;
+  cfg.ring_chunks      = 64;
+  cfg.out_chunk_len    = 4096;
+  cfg.rate             = 0.0;
+  cfg.bench.nr_warmups = 1;
+  cfg.bench.nr_trials  = 5;
+  cfg.bench.pcounters  = nullptr;
+  bool help_only       = false;
+  bool error           = false;
+  get_cfg(argc, argv, &cfg, &help_only, &error);
+  if (help_only)
+    return 0;
+  else if (error)
+    return -1;
+
+  size_t n = static_cast<size_t>(cfg.nr_streams) * cfg.nr_events;
+  std::cout << "streams " << cfg.nr_streams << ", events per stream "
+            << cfg.nr_events << ", chunk " << cfg.chunk_len << ", ring "
+            << cfg.ring_chunks << " chunks, output chunk "
+            << cfg.out_chunk_len << ", rate per stream ";
+  if (cfg.rate > 0.0)
+    std::cout << cfg.rate << std::endl;
+  else
+    std::cout << "unlimited" << std::endl;
+
+  StreamRun run;
+  bool      ok = true;
+  mm::BenchmarkResult result = mm::run_benchmark(
+      "stream", n, 2 * n * sizeof(int64_t), cfg.bench, [&]() {
+    run_streams(cfg, &run);
+    ok = ok && run.ok;
+  });
+  result.ok = ok;
+  mm::BenchmarkReport::print(result, std::cout);
+  std::cout << "StreamMerger " << (ok ? "output sorted and complete"
+                                      : "output wrong") << std::endl;
+
+  std::vector<int64_t> &latencies = run.latencies;
+  std::sort(latencies.begin(), latencies.end());
+  const double quantiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+  const char  *names[]     = { "p50", "p90", "p99", "p999", "max" };
+  mm::BenchmarkReport report;
+  report.set("streams", cfg.nr_streams);
+  report.set("events", cfg.nr_events);
+  report.set("chunk", cfg.chunk_len);
+  report.set("ring", cfg.ring_chunks);
+  report.set("output_chunk", cfg.out_chunk_len);
+  report.set("rate", cfg.rate);
+  std::cout << "latency, last trial, usec:";
+  for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); ++q) {
+    double us = percentile_us(latencies, quantiles[q]);
+    std::cout << " " << names[q] << " " << us;
+    report.set(std::string("latency_") + names[q] + "_us", us);
+  }
+  std::cout << std::endl
+            << "merger waited for a stream " << run.nr_waits
+            << " times, last trial" << std::endl;
+  report.set("waits", run.nr_waits);
+  report.add(result);
+
+  std::string error_msg;
+  if (!cfg.json_path.empty() && !report.write_json(cfg.json_path, &error_msg)) {
+    std::cout << error_msg << std::endl;
+    ok = false;
+  }
+  return ok ? 0 : -1;
+}
@@ -1,35 +1,84 @@
 #!/usr/bin/env python
 """ Runs a set of mmerge.py timing tests.
-common/runtests.py rev. 22 July 2013 by Stuart Ambler.
+common/runtests.py rev. 17 October 2026 by Stuart Ambler.
 Copyright (c) 2013 Stuart Ambler.
 Distributed under the Boost License in the accompanying file LICENSE
 """
+import json
 import os
 import re
 import sys
+import tempfile
 
 tot_lens_str      = r'(?:tot_lens|totLens) (\d+)'
 pq_elapsed_str    = r'(?:pq.+|pq\s+stopwatch end\s+)elapsed.* (\d+\.\d+) sec'
 lin_elapsed_str   = r'(?:lin.+|lin\s+stopwatch end\s+)elapsed.* (\d+\.\d+) sec'
 heapq_elapsed_str = r'heapq.+elapsed.* (\d+\.\d+) sec'
+lt_elapsed_str    = r'(?:lt\s+stopwatch end\s+)elapsed.* (\d+\.\d+) sec'
+simd_elapsed_str  = r'(?:simd\s+stopwatch end\s+)elapsed.* (\d+\.\d+) sec'
 differ_str        = r'(differ)'
 results_reo       = re.compile(         tot_lens_str        # 0
                                + r'|' + pq_elapsed_str      # 1
                                + r'|' + lin_elapsed_str     # 2
                                + r'|' + heapq_elapsed_str   # 3
-                               + r'|' + differ_str,         # 4
+                               + r'|' + lt_elapsed_str      # 4
+                               + r'|' + simd_elapsed_str    # 5
+                               + r'|' + differ_str,         # 6
                                re.IGNORECASE)
 python_str = r'\.py$'
 python_reo = re.compile(python_str, re.IGNORECASE)
 ruby_str   = r'\.rb$'
 ruby_reo   = re.compile(ruby_str, re.IGNORECASE)
+json_option_str = r'^\s*-j\b'
+json_option_reo = re.compile(json_option_str, re.MULTILINE)
 
-def run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin):
+# The benchmark names in the JSON written by test programs with the -j
+# option, for the columns of the table.
+json_columns = ("pq", "lin", "heapq", "lt", "simd")
+
+def writes_json(cmd):
+    """ Whether the test program run by cmd takes the -j <file> option to
+    write its benchmark results as JSON, as its help text shows.
+    """
+    p = os.popen("%s -h" % cmd, "r")
+    help_text = p.read()
+    p.close()
+    return json_option_reo.search(help_text) is not None
+
+def run_json_test(cmd, args):
+    """ Run a test program that writes JSON, with args.
+    Returns: the report it wrote, a dict, or None if it wrote none, and its
+    text output.
+    """
+    fd, json_path = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    try:
+        p = os.popen("%s %s -j %s" % (cmd, args, json_path), "r")
+        results = p.readlines()
+        p.close()
+        try:
+            with open(json_path) as f:
+                report = json.load(f)
+        except ValueError:
+            report = None
+    finally:
+        os.remove(json_path)
+    return report, results
+
+def run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin,
+               use_json=False, reports=None, dist=None):
     """ Run a timing test on some language version of the multimerge samples.
     Args: command cmd to run a test, or "header" to print header line,
     nr_input_arrays, ave_input _len as named,
     do_pq should always be True unless want to skip the test altogether,
     do_lin True to set the third, l, argument for the command,
+    use_json True if the command writes JSON by -j (see writes_json), in which
+    case the times are the medians it reports, and its report is appended to
+    the list reports if that is not None; otherwise the times are parsed
+    from its text output,
+    dist the name of the input distribution, passed to the command by -d,
+    or None for the command's default; if not None a first column, dist,
+    is printed, with dist or, for the header line, "dist".
     """
     nr_input_arrays_str = str(nr_input_arrays)
     ave_input_len_str   = str(ave_input_len)
@@ -37,6 +86,8 @@ def run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin):
     pq_elapsed          = "NA"
     lin_elapsed         = "NA"
     heapq_elapsed       = "NA"
+    lt_elapsed          = "NA"
+    simd_elapsed        = "NA"
     if cmd == "header":
         nr_input_arrays_str = "k"
         ave_input_len_str   = "each"
@@ -44,10 +95,38 @@ def run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin):
         pq_elapsed          = "pq"
         lin_elapsed         = "lin"
         heapq_elapsed       = "heapq"
+        lt_elapsed          = "lt"
+        simd_elapsed        = "simd"
+    elif (do_pq or do_lin) and use_json:
+        args = "%d %d %s" % (nr_input_arrays, ave_input_len,
+                             "-l" if do_lin else "")
+        if dist is not None:
+            args += " -d %s" % dist
+        report, results = run_json_test(cmd, args)
+        if report is None:
+            sys.stderr.write("\nerror: no JSON report:\n%s\n" % results)
+            sys.stderr.flush()
+        else:
+            if "n" in report:
+                tot_lens = "%d" % report["n"]
+            medians = {}
+            for result in report["results"]:
+                medians[result["name"]] = "%.4f" % result["median_sec"]
+                if not result["ok"]:
+                    sys.stderr.write("\nerror: %s output differs:\n%s\n"
+                                     % (result["name"], results))
+                    sys.stderr.flush()
+            (pq_elapsed, lin_elapsed, heapq_elapsed, lt_elapsed,
+             simd_elapsed) = [medians.get(name, "NA")
+                              for name in json_columns]
+            if reports is not None:
+                reports.append(report)
     elif do_pq or do_lin:
         lin_str = "-l"
-        p = os.popen("%s %d %d %s" % (cmd, nr_input_arrays, ave_input_len,
-                                      lin_str if do_lin else ""), "r")
+        dist_str = "-d %s" % dist if dist is not None else ""
+        p = os.popen("%s %d %d %s %s" % (cmd, nr_input_arrays, ave_input_len,
+                                         lin_str if do_lin else "",
+                                         dist_str), "r")
         results = p.readlines()
         p.close
         match_list = results_reo.findall("".join(results))
@@ -55,6 +134,8 @@ def run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin):
         pq_elapsed = "NA"
         lin_elapsed = "NA"
         heapq_elapsed = "NA"
+        lt_elapsed = "NA"
+        simd_elapsed = "NA"
         for match in match_list:
             if match[0]:
                 tot_lens = match[0]
@@ -64,44 +145,87 @@ def run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin):
                 lin_elapsed = match[2]
             elif match[3]:
                 heapq_elapsed = match[3]
-            if match[4]:
+            elif match[4]:
+                lt_elapsed = match[4]
+            elif match[5]:
+                simd_elapsed = match[5]
+            if match[6]:
                 sys.stderr.write("\nerror:\n%s\n" % results)
                 sys.stderr.flush()
-    print("    %6s %6s %10s %7s %7s %7s" % (nr_input_arrays_str,
-                                            ave_input_len_str, tot_lens,
-                                            pq_elapsed, lin_elapsed,
-                                            heapq_elapsed))
+    dist_column = ""
+    if dist is not None:
+        dist_column = "%-8s " % ("dist" if cmd == "header" else dist)
+    print("    %s%6s %6s %10s %7s %7s %7s %7s %7s" % (dist_column,
+                                                      nr_input_arrays_str,
+                                                      ave_input_len_str,
+                                                      tot_lens, pq_elapsed,
+                                                      lin_elapsed,
+                                                      heapq_elapsed,
+                                                      lt_elapsed, simd_elapsed))
+
 
+# The tests main runs: nr_input_arrays, ave_input_len, do_pq, do_lin as for
+# run_a_test.  common/commonanalyze.R selects rows of the table by position.
+configurations = (
+    (   10,  10000, True, True),
+    (   20,  10000, True, True),
+    (   30,  10000, True, True),
+    (   40,  10000, True, True),
+    (   50,  10000, True, True),
+    (   60,  10000, True, True),
+    (   70,  10000, True, True),
+    (   80,  10000, True, True),
+    (   90,  10000, True, True),
+    (  100,  10000, True, True),
+    (  160,  10000, True, True),
+    ( 1000,  10000, True, False),
+    (  100,  20000, True, True),
+    (  100,  40000, True, False),
+    (  100,  60000, True, False),
+    (  100,  80000, True, False),
+    (  100, 100000, True, False),
+)
 
 def main ():
     """ main function to run set of mmerge.py timing tests.
-    Args: command line argument, the command to run the test executble:
+    Args: command line arguments, the command to run the test executble:
     for c,      ./testmmergemain
     for cc,     ./testmmergemain
     for java,   ./runmmerge
     for python, ./mmerge.py
     for ruby,   ./testmmerge.rb
+    optionally followed by --json <file>, to write there a JSON list of the
+    reports of a command that writes JSON by -j; the table printed is the
+    same either way;
+    and by --dist <name>, any number of times, to run all the tests for each
+    input distribution named, for a command that takes -d <name>, with the
+    distribution in a first column of the table.
     Returns: nothing
     """
     cmd = sys.argv[1]
-    run_a_test("header", 0, 0, False, False)
-    run_a_test(cmd,    10,  10000, True,  True)
-    run_a_test(cmd,    20,  10000, True,  True)
-    run_a_test(cmd,    30,  10000, True,  True)
-    run_a_test(cmd,    40,  10000, True,  True)
-    run_a_test(cmd,    50,  10000, True,  True)
-    run_a_test(cmd,    60,  10000, True,  True)
-    run_a_test(cmd,    70,  10000, True,  True)
-    run_a_test(cmd,    80,  10000, True,  True)
-    run_a_test(cmd,    90,  10000, True,  True)
-    run_a_test(cmd,   100,  10000, True,  True)
-    run_a_test(cmd,   160,  10000, True,  True)
-    run_a_test(cmd,  1000,  10000, True,  False)
-    run_a_test(cmd,   100,  20000, True,  True)
-    run_a_test(cmd,   100,  40000, True,  False)
-    run_a_test(cmd,   100,  60000, True,  False)
-    run_a_test(cmd,   100,  80000, True,  False)
-    run_a_test(cmd,   100, 100000, True,  False)
+    json_out_path = None
+    dists = []
+    args = sys.argv[2:]
+    while len(args) >= 2 and args[0] in ("--json", "--dist"):
+        if args[0] == "--json":
+            json_out_path = args[1]
+        else:
+            dists.append(args[1])
+        args = args[2:]
+    if args:
+        sys.stderr.write("usage: %s <command> [--json <file>] "
+                         "[--dist <name>]...\n" % sys.argv[0])
+        sys.exit(2)
+    use_json = writes_json(cmd)
+    reports = []
+    run_a_test("header", 0, 0, False, False, dist=("" if dists else None))
+    for dist in (dists if dists else [None]):
+        for nr_input_arrays, ave_input_len, do_pq, do_lin in configurations:
+            run_a_test(cmd, nr_input_arrays, ave_input_len, do_pq, do_lin,
+                       use_json, reports, dist)
+    if json_out_path is not None:
+        with open(json_out_path, "w") as f:
+            json.dump(reports, f, indent=2)
 
 if __name__ == "__main__":
     main ()